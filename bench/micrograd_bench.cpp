@@ -0,0 +1,434 @@
+/**
+ * @file micrograd_bench.cpp
+ * @brief Benchmarks of the autograd and neural network hot paths
+ *
+ * Every benchmark reports its timing together with the heap traffic of one
+ * iteration (allocations, bytes, and peak live bytes above the starting
+ * point) as one JSON document on stdout, so runs can be stored and diffed
+ * across releases and engines.
+ *
+ * Usage: micrograd_bench [--quick] [--filter <substring>]
+ */
+
+#include "micrograd/compiled_graph.hpp"
+#include "micrograd/inference.hpp"
+#include "micrograd/quantized.hpp"
+#include "micrograd/kernels.hpp"
+#include "micrograd/layer.hpp"
+#include "micrograd/mlp.hpp"
+#include "micrograd/neuron.hpp"
+#include "micrograd/tape.hpp"
+#include "micrograd/thread_pool.hpp"
+#include "micrograd/trainer.hpp"
+#include "micrograd/value.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef MICROGRAD_VERSION
+#define MICROGRAD_VERSION "unknown"
+#endif
+
+// ======== ALLOCATION TRACKING ========
+// Each block carries its size in a header, so live and peak bytes can be tracked
+namespace {
+constexpr std::size_t kHeader = alignof(std::max_align_t);
+
+std::atomic<long> g_allocations{0};
+std::atomic<long> g_bytes{0};
+std::atomic<long> g_live_bytes{0};
+std::atomic<long> g_peak_bytes{0};
+} // namespace
+
+void *operator new(std::size_t size) {
+    auto *block = static_cast<unsigned char *>(std::malloc(size + kHeader));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    std::memcpy(block, &size, sizeof size);
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const long bytes = static_cast<long>(size);
+    g_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    const long live = g_live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    long peak = g_peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return block + kHeader;
+}
+
+void operator delete(void *p) noexcept {
+    if (!p) {
+        return;
+    }
+    auto *block = static_cast<unsigned char *>(p) - kHeader;
+    std::size_t size;
+    std::memcpy(&size, block, sizeof size);
+    g_live_bytes.fetch_sub(static_cast<long>(size), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+namespace {
+
+// ======== HARNESS ========
+using Clock = std::chrono::steady_clock;
+using Fields = std::vector<std::pair<std::string, double>>;
+
+struct Options {
+    double min_seconds = 0.25; ///< Minimum timed duration of each benchmark
+    std::string filter;        ///< Only run benchmarks whose name contains this
+};
+
+struct Result {
+    std::string name;
+    Fields params;
+    Fields metrics;
+};
+
+Options g_options;
+std::vector<Result> g_results;
+
+bool selected(const std::string &name) {
+    return g_options.filter.empty() || name.find(g_options.filter) != std::string::npos;
+}
+
+long peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/// Heap traffic of a single call of body
+Fields heap_profile(const std::function<void()> &body) {
+    const long allocations = g_allocations.load(), bytes = g_bytes.load();
+    const long live = g_live_bytes.load();
+    g_peak_bytes.store(live);
+    body();
+    return {{"allocations_per_iter", static_cast<double>(g_allocations.load() - allocations)},
+            {"bytes_per_iter", static_cast<double>(g_bytes.load() - bytes)},
+            {"peak_live_bytes", static_cast<double>(g_peak_bytes.load() - live)}};
+}
+
+/**
+ * Time body until at least min_seconds have elapsed, doubling the batch of
+ * calls each round, and record ns per call; units scales it to a per-unit
+ * figure (per op, per node, per sample) reported as ns_per_unit.
+ */
+void run(const std::string &name, Fields params, double units, const std::function<void()> &body) {
+    if (!selected(name)) {
+        return;
+    }
+    Fields metrics = heap_profile(body); // Doubles as the warm-up call
+    std::size_t iterations = 1;
+    double seconds = 0.0;
+    for (;;) {
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            body();
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= g_options.min_seconds) {
+            break;
+        }
+        iterations *= 2;
+    }
+    const double ns = seconds * 1e9 / static_cast<double>(iterations);
+    metrics.insert(metrics.begin(), {{"iterations", static_cast<double>(iterations)},
+                                     {"ns_per_iter", ns},
+                                     {"ns_per_unit", ns / units}});
+    metrics.push_back({"peak_rss_kb", static_cast<double>(peak_rss_kb())});
+    g_results.push_back({name, std::move(params), std::move(metrics)});
+    std::cerr << name << ": " << ns << " ns/iter" << std::endl;
+}
+
+/// Time body one call at a time and report latency percentiles
+void run_latency(const std::string &name, Fields params, const std::function<void()> &body) {
+    if (!selected(name)) {
+        return;
+    }
+    Fields metrics = heap_profile(body);
+    const std::size_t samples = g_options.min_seconds < 0.1 ? 2000 : 20000;
+    std::vector<double> ns(samples);
+    for (std::size_t i = 0; i < samples; ++i) {
+        const auto start = Clock::now();
+        body();
+        ns[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+    std::sort(ns.begin(), ns.end());
+    auto percentile = [&](double q) { return ns[static_cast<std::size_t>(q * static_cast<double>(samples - 1))]; };
+    metrics.insert(metrics.begin(), {{"samples", static_cast<double>(samples)},
+                                     {"p50_ns", percentile(0.50)},
+                                     {"p90_ns", percentile(0.90)},
+                                     {"p99_ns", percentile(0.99)},
+                                     {"max_ns", ns.back()}});
+    metrics.push_back({"peak_rss_kb", static_cast<double>(peak_rss_kb())});
+    g_results.push_back({name, std::move(params), std::move(metrics)});
+    std::cerr << name << ": p50 " << percentile(0.50) << " ns" << std::endl;
+}
+
+void print_fields(const Fields &fields) {
+    std::cout << "{";
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        std::cout << (i ? ", " : "") << "\"" << fields[i].first << "\": " << fields[i].second;
+    }
+    std::cout << "}";
+}
+
+void print_json() {
+    std::cout.precision(10);
+    std::cout << "{\n  \"version\": \"" << MICROGRAD_VERSION << "\",\n"
+              << "  \"isa\": \"" << kernels::isa_name(kernels::active_isa()) << "\",\n"
+              << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+              << "  \"results\": [\n";
+    for (std::size_t i = 0; i < g_results.size(); ++i) {
+        const Result &r = g_results[i];
+        std::cout << "    {\"name\": \"" << r.name << "\", \"params\": ";
+        print_fields(r.params);
+        std::cout << ", \"metrics\": ";
+        print_fields(r.metrics);
+        std::cout << "}" << (i + 1 < g_results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}" << std::endl;
+}
+
+// ======== DATA ========
+std::vector<double> bench_data(std::size_t n, double seed) {
+    std::vector<double> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = std::sin(seed + 1.7 * static_cast<double>(i));
+    }
+    return out;
+}
+
+std::vector<ValuePtr> leaves(const std::vector<double> &data) {
+    std::vector<ValuePtr> out;
+    for (double d : data) {
+        out.push_back(make_value(d));
+    }
+    return out;
+}
+
+/// The squared error of one sample through the scalar graph
+ValuePtr scalar_loss(MLP &mlp, const std::vector<ValuePtr> &x, const double *y) {
+    auto out = mlp(x);
+    ValuePtr loss = pow(out[0] - y[0], 2.0);
+    for (std::size_t j = 1; j < out.size(); ++j) {
+        loss = loss + pow(out[j] - y[j], 2.0);
+    }
+    return loss;
+}
+
+struct Shape {
+    int nin;
+    std::vector<int> nouts;
+};
+
+Fields shape_params(const Shape &shape, std::size_t batch) {
+    Fields params = {{"nin", static_cast<double>(shape.nin)}};
+    for (std::size_t l = 0; l < shape.nouts.size(); ++l) {
+        params.push_back({"layer" + std::to_string(l), static_cast<double>(shape.nouts[l])});
+    }
+    params.push_back({"batch", static_cast<double>(batch)});
+    return params;
+}
+
+// ======== BENCHMARKS ========
+void bench_graph_construction() {
+    for (std::size_t ops : {1000, 100000}) {
+        auto x = make_value(0.5), w = make_value(0.9), b = make_value(0.1);
+        run("value.build_chain", {{"ops", static_cast<double>(2 * ops)}}, static_cast<double>(2 * ops), [&] {
+            ValuePtr h = x;
+            for (std::size_t i = 0; i < ops; ++i) {
+                h = h * w + b;
+            }
+        });
+        Tape tape;
+        run("value.build_chain_tape", {{"ops", static_cast<double>(2 * ops)}}, static_cast<double>(2 * ops), [&] {
+            {
+                TapeScope scope(tape);
+                ValuePtr h = x;
+                for (std::size_t i = 0; i < ops; ++i) {
+                    h = h * w + b;
+                }
+            }
+            tape.clear();
+        });
+    }
+}
+
+void bench_backward() {
+    const std::pair<std::size_t, std::size_t> shapes[] = {{16, 16}, {64, 64}, {1024, 4}, {4, 1024}};
+    for (const auto &[depth, width] : shapes) {
+        // width lanes, each mixing in its neighbour at every level
+        auto row = leaves(bench_data(width, 0.3));
+        auto w = make_value(0.7);
+        for (std::size_t d = 0; d < depth; ++d) {
+            std::vector<ValuePtr> next(width);
+            for (std::size_t i = 0; i < width; ++i) {
+                next[i] = tanh(row[i] * w + row[(i + 1) % width]);
+            }
+            row = std::move(next);
+        }
+        ValuePtr root = row[0];
+        for (std::size_t i = 1; i < width; ++i) {
+            root = root + row[i];
+        }
+        std::vector<Value *> order;
+        root->build_topo(order);
+        const Fields params = {{"depth", static_cast<double>(depth)},
+                               {"width", static_cast<double>(width)},
+                               {"nodes", static_cast<double>(order.size())}};
+        const double nodes = static_cast<double>(order.size());
+        run("value.backward", params, nodes, [&] { root->backward(); });
+        run("value.backward_cached_order", params, nodes, [&] { root->backward(order); });
+    }
+}
+
+void bench_neuron_layer() {
+    for (int nin : {16, 128}) {
+        Neuron neuron(nin);
+        auto x = leaves(bench_data(static_cast<std::size_t>(nin), 0.2));
+        // Gradients simply keep accumulating; that does not change the cost
+        run("neuron.forward_backward", {{"nin", static_cast<double>(nin)}}, 1.0, [&] { neuron(x)->backward(); });
+    }
+    for (int width : {16, 64}) {
+        Layer layer(width, width);
+        auto x = leaves(bench_data(static_cast<std::size_t>(width), 0.2));
+        run("layer.forward_backward", {{"nin", static_cast<double>(width)}, {"nout", static_cast<double>(width)}}, 1.0,
+            [&] {
+                layer.zero_grad();
+                auto out = layer(x);
+                ValuePtr s = out[0];
+                for (std::size_t j = 1; j < out.size(); ++j) {
+                    s = s + out[j];
+                }
+                s->backward();
+            });
+    }
+}
+
+void bench_mlp(const Shape &shape) {
+    MLP mlp(shape.nin, shape.nouts);
+    const std::size_t nin = mlp.nin(), nout = mlp.nout(), batch = 64;
+    const auto xs = bench_data(batch * nin, 0.1), ys = bench_data(batch * nout, 2.2);
+
+    // Scalar engine: one graph per sample
+    auto x = leaves(std::vector<double>(xs.begin(), xs.begin() + static_cast<long>(nin)));
+    run("mlp.scalar_step", shape_params(shape, 1), 1.0, [&] {
+        mlp.zero_grad();
+        scalar_loss(mlp, x, ys.data())->backward();
+    });
+
+    // Compiled engine: the same graph traced once and replayed
+    std::vector<ValuePtr> inputs = leaves(std::vector<double>(nin + nout, 0.0));
+    std::vector<ValuePtr> x_in(inputs.begin(), inputs.begin() + static_cast<long>(nin));
+    auto out = mlp(x_in);
+    ValuePtr loss = pow(out[0] - inputs[nin], 2.0);
+    for (std::size_t j = 1; j < nout; ++j) {
+        loss = loss + pow(out[j] - inputs[nin + j], 2.0);
+    }
+    CompiledGraph compiled(loss, inputs);
+    compiled.optimize();
+    out.clear();
+    x_in.clear();
+    loss.reset();
+    std::vector<double> sample(xs.begin(), xs.begin() + static_cast<long>(nin));
+    sample.insert(sample.end(), ys.begin(), ys.begin() + static_cast<long>(nout));
+    run("mlp.compiled_step", shape_params(shape, 1), 1.0, [&] {
+        mlp.zero_grad();
+        compiled.set_inputs(sample.data());
+        compiled.forward();
+        compiled.backward();
+    });
+
+    // Tensor engine: the whole batch per step, optionally checkpointed
+    for (std::size_t interval : {0, 2}) {
+        if (interval > 1 && shape.nouts.size() <= interval) {
+            continue;
+        }
+        mlp.set_checkpoint_interval(interval);
+        Fields params = shape_params(shape, batch);
+        params.push_back({"checkpoint_interval", static_cast<double>(interval)});
+        run("mlp.batch_step", params, static_cast<double>(batch), [&] {
+            mlp.zero_grad();
+            mlp.forward_batch(xs.data(), ys.data(), batch).loss->backward();
+        });
+    }
+    mlp.set_checkpoint_interval(0);
+
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Trainer trainer(mlp, threads);
+    Fields trainer_params = shape_params(shape, batch);
+    trainer_params.push_back({"threads", static_cast<double>(threads)});
+    run("mlp.trainer_step", trainer_params, static_cast<double>(batch), [&] {
+        mlp.zero_grad();
+        trainer.backward_batch(xs.data(), ys.data(), batch);
+    });
+
+    // A full optimizer step, serial versus updating layers during the sweep
+    SGD sgd(mlp.parameter_spans(), 1e-4);
+    run("mlp.sgd_step", shape_params(shape, batch), static_cast<double>(batch), [&] {
+        mlp.zero_grad();
+        mlp.forward_batch(xs.data(), ys.data(), batch).loss->backward();
+        sgd.step();
+    });
+    {
+        PipelinedTrainer pipelined(mlp, sgd);
+        run("mlp.pipelined_step", shape_params(shape, batch), static_cast<double>(batch),
+            [&] { pipelined.step(xs.data(), ys.data(), batch); });
+    }
+
+    // Inference latency of a single sample in each precision
+    std::vector<double> y(nout);
+    run_latency("mlp.predict", shape_params(shape, 1), [&] { mlp.predict(xs.data(), y.data()); });
+    const std::vector<float> xf(xs.begin(), xs.begin() + static_cast<long>(nin));
+    std::vector<float> yf(nout);
+    InferenceMLP<float> f32(mlp);
+    run_latency("inference.f32.predict", shape_params(shape, 1), [&] { f32.predict(xf.data(), yf.data()); });
+    InferenceMLP<bfloat16> bf16(mlp);
+    run_latency("inference.bf16.predict", shape_params(shape, 1), [&] { bf16.predict(xf.data(), yf.data()); });
+    QuantizedMLP int8(mlp, xs.data(), batch);
+    run_latency("inference.int8.predict", shape_params(shape, 1), [&] { int8.predict(xf.data(), yf.data()); });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--quick") {
+            g_options.min_seconds = 0.02;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            g_options.filter = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--quick] [--filter <substring>]" << std::endl;
+            return 2;
+        }
+    }
+
+    bench_graph_construction();
+    bench_backward();
+    bench_neuron_layer();
+    bench_mlp({4, {16, 16, 1}});
+    bench_mlp({16, {64, 64, 4}});
+    bench_mlp({64, {256, 256, 256, 10}});
+
+    print_json();
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file activation.hpp
+ * @brief Activation functions selectable per Layer, on plain scalars
+ *
+ * The graph versions are activate() in value.hpp (one node per neuron) and
+ * in tensor.hpp (one node per batch); the functions here are what they and
+ * the inference paths evaluate.
+ */
+
+#ifndef MICROGRAD_ACTIVATION_HPP
+#define MICROGRAD_ACTIVATION_HPP
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @enum Activation
+ * @brief Nonlinearity applied to a layer's weighted sums
+ */
+enum class Activation : std::uint8_t {
+    Tanh,    ///< tanh(x), the default
+    Relu,    ///< max(x, 0)
+    Sigmoid, ///< 1 / (1 + exp(-x))
+    Linear,  ///< x, e.g. for a regression output layer
+    Gelu,    ///< x * Phi(x), Phi the standard normal CDF
+};
+
+namespace activation {
+
+/// 1 / (1 + exp(-x)) without overflowing exp for x far below 0
+template <typename T> inline T sigmoid(T x) {
+    if (x >= T(0)) {
+        return T(1) / (T(1) + std::exp(-x));
+    }
+    const T e = std::exp(x);
+    return e / (T(1) + e);
+}
+
+/// x * Phi(x) in the exact erf form
+template <typename T> inline T gelu(T x) {
+    return T(0.5) * x * std::erfc(-x * T(0.70710678118654752440));
+}
+
+/// d gelu(x) / dx = Phi(x) + x * phi(x)
+template <typename T> inline T gelu_grad(T x) {
+    const T cdf = T(0.5) * std::erfc(-x * T(0.70710678118654752440));
+    const T pdf = T(0.39894228040143267794) * std::exp(T(-0.5) * x * x);
+    return cdf + x * pdf;
+}
+
+/// Evaluate an activation
+template <typename T> inline T apply(Activation act, T x) {
+    switch (act) {
+    case Activation::Tanh:
+        return std::tanh(x);
+    case Activation::Relu:
+        return x > T(0) ? x : T(0);
+    case Activation::Sigmoid:
+        return sigmoid(x);
+    case Activation::Linear:
+        return x;
+    case Activation::Gelu:
+        return gelu(x);
+    }
+    return x;
+}
+
+/**
+ * @brief Get the derivative of an activation at x.
+ * @param y apply(act, x), from which tanh, ReLU and sigmoid derive it.
+ */
+template <typename T> inline T derivative(Activation act, T x, T y) {
+    switch (act) {
+    case Activation::Tanh:
+        return T(1) - y * y;
+    case Activation::Relu:
+        return y > T(0) ? T(1) : T(0);
+    case Activation::Sigmoid:
+        return y * (T(1) - y);
+    case Activation::Linear:
+        return T(1);
+    case Activation::Gelu:
+        return gelu_grad(x);
+    }
+    return T(1);
+}
+
+/// Printable name, e.g. "relu"
+inline const char *name(Activation act) {
+    switch (act) {
+    case Activation::Tanh:
+        return "tanh";
+    case Activation::Relu:
+        return "relu";
+    case Activation::Sigmoid:
+        return "sigmoid";
+    case Activation::Linear:
+        return "linear";
+    case Activation::Gelu:
+        return "gelu";
+    }
+    return "?";
+}
+
+} // namespace activation
+
+#endif // MICROGRAD_ACTIVATION_HPP
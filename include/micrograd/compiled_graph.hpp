@@ -0,0 +1,182 @@
+/**
+ * @file compiled_graph.hpp
+ * @brief Trace a scalar graph once and replay it without rebuilding it
+ *
+ * A training step builds a graph of the same shape every iteration; only
+ * the inputs change. CompiledGraph walks such a graph once and lowers it
+ * to a flat instruction list over preallocated data and gradient slots,
+ * in topological order. Each replay then rebinds the inputs, runs the
+ * instructions forward, and sweeps them in reverse, with no node
+ * allocation, no reference counting and no graph traversal.
+ *
+ * Leaves other than the declared inputs keep their identity: forward()
+ * reads their current data and backward() adds their gradients into them,
+ * so parameter updates and optimizers work on the original Values exactly
+ * as with the dynamic graph. Op::Const leaves (the literals of the double
+ * overloads) are baked into their slots instead. The compiled graph holds
+ * references to the leaves; the traced graph itself can be
+ * released once compiled (it must not have been recorded on a Tape that
+ * is cleared while the compiled graph is in use).
+ */
+
+#ifndef MICROGRAD_COMPILED_GRAPH_HPP
+#define MICROGRAD_COMPILED_GRAPH_HPP
+
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @enum InstrOp
+ * @brief Operation of one compiled instruction
+ *
+ * The first group mirrors Op one to one; the rest are only produced by
+ * CompiledGraph::optimize().
+ */
+enum class InstrOp : std::uint8_t {
+    Add,      ///< a + b
+    Mul,      ///< a * b
+    Tanh,     ///< tanh(a)
+    Exp,      ///< exp(a)
+    Pow,      ///< a ^ aux
+    AddConst, ///< a + aux
+    MulConst, ///< a * aux
+    Fma,      ///< a * b + c
+    Dot,      ///< c + sum of the b operand pairs starting at a (c may be kNoSlot)
+    AddTanh,  ///< tanh(a + b)
+    DotTanh,  ///< tanh(Dot)
+    Relu,     ///< max(a, 0)
+    Sigmoid,  ///< 1 / (1 + exp(-a))
+    Gelu,     ///< a * Phi(a)
+};
+
+/**
+ * @struct Instruction
+ * @brief One node of a compiled graph
+ *
+ * Operands are slot indices; unused operands are ignored. Dot-style
+ * instructions keep their (x, y) operand pairs in a side array and store
+ * its offset in a and the number of pairs in b.
+ */
+struct Instruction {
+    InstrOp op;        ///< Operation to apply
+    std::uint32_t out; ///< Slot receiving the result
+    std::uint32_t a;   ///< First operand
+    std::uint32_t b;   ///< Second operand
+    std::uint32_t c;   ///< Third operand (Fma addend, Dot initial value)
+    double aux;        ///< Instruction constant (exponent, folded literal)
+};
+
+/**
+ * @struct OptimizeStats
+ * @brief Size of a compiled graph before and after CompiledGraph::optimize()
+ */
+struct OptimizeStats {
+    std::size_t instructions_before;
+    std::size_t instructions_after;
+    std::size_t slots_before;
+    std::size_t slots_after;
+};
+
+/**
+ * @class CompiledGraph
+ * @brief Flat, replayable form of a scalar graph
+ */
+class CompiledGraph {
+  public:
+    static constexpr std::uint32_t kNoSlot = 0xffffffffu; ///< Absent optional operand
+
+    /**
+     * @brief Trace and compile the graph rooted at root
+     * @param root The output to evaluate, typically a loss
+     * @param inputs Leaves whose values are supplied on each replay; input
+     *               i is set with set_input(i, ...)
+     * @throws std::invalid_argument if an input is not a leaf or is repeated
+     */
+    CompiledGraph(const ValuePtr &root, const std::vector<ValuePtr> &inputs);
+
+    /**
+     * @brief Rewrite the schedule into fewer, fused instructions
+     * @return Instruction and slot counts before and after
+     *
+     * Runs, in order:
+     * - constant folding: instructions whose operands are all constants
+     *   are evaluated once, and a constant operand of + or * becomes an
+     *   immediate (AddConst, MulConst), so x - y costs one multiply by an
+     *   immediate and one add instead of a constant leaf and two nodes;
+     * - fusion: a product consumed only by an addition becomes an Fma,
+     *   and chains of them (a neuron's weighted sum) a single Dot; an
+     *   addition or Dot consumed only by tanh is fused into it;
+     * - dead-node elimination: instructions and leaves that no longer
+     *   reach the root are dropped and the slots are renumbered densely.
+     *
+     * Results and gradients are unchanged up to floating-point rounding,
+     * and calling it again on an optimized graph is safe.
+     */
+    OptimizeStats optimize();
+
+    /**
+     * @brief Set one input for the next forward()
+     * @param index Position in the inputs passed at construction
+     * @param value The new value
+     */
+    void set_input(std::size_t index, double value);
+
+    /**
+     * @brief Set every input for the next forward()
+     * @param values num_inputs() values, in the order given at construction
+     */
+    void set_inputs(const double *values);
+
+    /**
+     * @brief Evaluate the graph with the current inputs and leaf values
+     * @return The value of the root
+     */
+    double forward();
+
+    /**
+     * @brief Backpropagate from the root of the last forward()
+     *
+     * Gradients of the inputs are available through input_grad(); the
+     * gradients of every other leaf are added into the original Values.
+     */
+    void backward();
+
+    /**
+     * @brief Get the root value computed by the last forward()
+     */
+    double value() const;
+
+    /**
+     * @brief Get the gradient of an input computed by the last backward()
+     * @param index Position in the inputs passed at construction
+     */
+    double input_grad(std::size_t index) const;
+
+    std::size_t num_inputs() const;
+    std::size_t num_slots() const;
+
+    /**
+     * @brief Get the compiled schedule, in forward order
+     */
+    const std::vector<Instruction> &instructions() const;
+
+  private:
+    void fold_constants(); ///< First pass of optimize()
+    void fuse();           ///< Second pass of optimize()
+    void eliminate_dead(); ///< Third pass of optimize()
+
+    std::vector<Instruction> m_code;          ///< Non-leaf nodes in topological order
+    std::vector<std::uint32_t> m_operands;    ///< Operand pairs of Dot-style instructions
+    std::vector<double> m_data;               ///< Value of every slot
+    std::vector<std::uint8_t> m_constant;     ///< 1 for slots holding a compile-time constant
+    std::vector<double> m_grad;               ///< Gradient of every slot
+    std::vector<std::uint32_t> m_input_slots; ///< Slot of each declared input
+    std::vector<ValuePtr> m_leaves;           ///< Other leaves, loaded and written back on replay
+    std::vector<std::uint32_t> m_leaf_slots;  ///< Slot of each entry of m_leaves
+    std::uint32_t m_root;                     ///< Slot of the root
+};
+
+#endif // MICROGRAD_COMPILED_GRAPH_HPP
@@ -0,0 +1,185 @@
+/**
+ * @file dataset.hpp
+ * @brief Streaming sample sources and a double-buffered batch loader
+ *
+ * A Dataset reads samples sequentially from disk into caller-provided
+ * row-major buffers, so nothing larger than one batch is ever resident and
+ * files larger than RAM can be trained on. BatchLoader runs a dataset on a
+ * background thread, filling one batch buffer while the training loop works
+ * on the other, and hands out batches in the [batch x nin] / [batch x nout]
+ * layout taken by MLP::forward_batch() and Trainer::step().
+ */
+
+#ifndef MICROGRAD_DATASET_HPP
+#define MICROGRAD_DATASET_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class Dataset
+ * @brief A sequential source of (input, target) samples.
+ */
+class Dataset {
+  public:
+    Dataset(std::size_t nin, std::size_t nout);
+    virtual ~Dataset() = default;
+
+    /**
+     * @brief Read the next samples.
+     * @param x Row-major [count x nin] destination for the inputs.
+     * @param y Row-major [count x nout] destination for the targets.
+     * @param count The maximum number of samples to read.
+     * @return The number of samples read; less than count only at the end.
+     * @throws std::runtime_error on malformed data.
+     */
+    virtual std::size_t read(double *x, double *y, std::size_t count) = 0;
+
+    /**
+     * @brief Start again from the first sample.
+     */
+    virtual void rewind() = 0;
+
+    std::size_t nin() const;
+    std::size_t nout() const;
+
+  protected:
+    std::size_t m_nin;  ///< Inputs per sample
+    std::size_t m_nout; ///< Targets per sample
+};
+
+/**
+ * @class CsvDataset
+ * @brief Text samples, one per line: nin inputs then nout targets, comma-separated.
+ *
+ * Blank lines are skipped.
+ */
+class CsvDataset : public Dataset {
+  public:
+    /**
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    CsvDataset(const std::string &path, std::size_t nin, std::size_t nout);
+
+    std::size_t read(double *x, double *y, std::size_t count) override;
+    void rewind() override;
+
+  private:
+    [[noreturn]] void fail(const std::string &what) const; ///< Throw a parse error for the current line
+
+    std::string m_path;    ///< For error messages
+    std::ifstream m_in;    ///< The open file
+    std::string m_line;    ///< Reused line buffer
+    std::size_t m_line_no; ///< Number of the last line read
+};
+
+/**
+ * @class BinaryDataset
+ * @brief Raw samples: back-to-back records of nin + nout native doubles.
+ *
+ * The format has no header; it is what writing each sample's inputs and
+ * targets as doubles produces, and it is read in large blocks.
+ */
+class BinaryDataset : public Dataset {
+  public:
+    /**
+     * @throws std::runtime_error if the file cannot be opened or its size
+     *         is not a whole number of records.
+     */
+    BinaryDataset(const std::string &path, std::size_t nin, std::size_t nout);
+
+    std::size_t read(double *x, double *y, std::size_t count) override;
+    void rewind() override;
+
+  private:
+    std::ifstream m_in;             ///< The open file
+    std::vector<double> m_records;  ///< Staging buffer for interleaved records
+};
+
+/**
+ * @struct Batch
+ * @brief One batch handed out by a BatchLoader.
+ */
+struct Batch {
+    const double *x;  ///< Row-major [size x nin] inputs
+    const double *y;  ///< Row-major [size x nout] targets
+    std::size_t size; ///< Number of samples; the last batch of an epoch may be short
+};
+
+/**
+ * @class BatchLoader
+ * @brief Prefetches batches from a Dataset on a background thread.
+ *
+ * Two batch buffers alternate: while the caller trains on the batch from
+ * next(), the loader thread reads the following one. A batch stays valid
+ * until the next call to next() or reset().
+ *
+ *     BatchLoader loader(std::make_unique<CsvDataset>("train.csv", 4, 1), 256);
+ *     while (const Batch *b = loader.next()) {
+ *         trainer.step(b->x, b->y, b->size, optimizer);
+ *     }
+ *     loader.reset(); // next epoch
+ */
+class BatchLoader {
+  public:
+    /**
+     * @brief Start prefetching the first epoch.
+     * @param dataset The sample source; owned by the loader.
+     * @param batch_size Samples per batch.
+     * @throws std::invalid_argument if batch_size is zero.
+     */
+    BatchLoader(std::unique_ptr<Dataset> dataset, std::size_t batch_size);
+    ~BatchLoader();
+
+    BatchLoader(const BatchLoader &) = delete;
+    BatchLoader &operator=(const BatchLoader &) = delete;
+
+    /**
+     * @brief Get the next batch of the epoch.
+     * @return The batch, or nullptr once the epoch is exhausted.
+     * @throws Whatever the dataset threw while reading this batch.
+     */
+    const Batch *next();
+
+    /**
+     * @brief Rewind the dataset and start prefetching a new epoch.
+     */
+    void reset();
+
+    std::size_t batch_size() const;
+    const Dataset &dataset() const;
+
+  private:
+    /// One of the two alternating buffers
+    struct Slot {
+        std::vector<double> x;
+        std::vector<double> y;
+        Batch batch;
+        bool ready = false; ///< Filled and not yet handed out
+    };
+
+    void start();
+    void stop();
+    void produce();
+
+    std::unique_ptr<Dataset> m_dataset; ///< The sample source
+    std::size_t m_batch_size;           ///< Samples per batch
+    Slot m_slots[2];                    ///< The alternating batch buffers
+    std::size_t m_next_slot;            ///< Slot the consumer takes next
+    int m_held_slot;                    ///< Slot the consumer currently holds, or -1
+    bool m_exhausted;                   ///< The loader thread reached the end of the epoch
+    bool m_stop;                        ///< Asks the loader thread to exit
+    std::exception_ptr m_error;         ///< Failure of the loader thread, rethrown by next()
+    std::mutex m_mutex;                 ///< Guards the slot states and flags
+    std::condition_variable m_changed;  ///< Signals any change of them
+    std::thread m_thread;               ///< The loader thread of the current epoch
+};
+
+#endif // MICROGRAD_DATASET_HPP
@@ -0,0 +1,95 @@
+/**
+ * @file derivatives.hpp
+ * @brief Forward-mode and second-order derivatives of a scalar graph
+ *
+ * Value::backward() computes the gradient of one scalar output and leaves
+ * it in the nodes' gradient fields. A Differentiator instead takes a built
+ * graph with several outputs and a list of inputs, indexes it once, and
+ * then answers derivative queries without touching any node:
+ *
+ * - jvp(): Jacobian-vector products by forward mode, tangents propagated
+ *   through the graph in topological order as dual numbers;
+ * - vjp(): vector-Jacobian products by reverse mode, one sweep for any
+ *   combination of outputs;
+ * - hvp(): Hessian-vector products of a scalar output by forward-over-
+ *   reverse mode (a reverse sweep over dual numbers);
+ * - jacobian(): the full matrix, by whichever mode needs fewer sweeps.
+ *
+ * Every query takes a batch of directions and evaluates all of them in the
+ * same sweep. The derivatives are taken at the values the nodes currently
+ * hold, i.e. where the graph was built.
+ */
+
+#ifndef MICROGRAD_DERIVATIVES_HPP
+#define MICROGRAD_DERIVATIVES_HPP
+
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class Differentiator
+ * @brief Indexed view of a graph for JVP, VJP and HVP queries
+ */
+class Differentiator {
+  public:
+    /**
+     * @brief Index the graph reaching outputs
+     * @param outputs The functions to differentiate, y_0 ... y_{m-1}
+     * @param inputs The leaves to differentiate with respect to, x_0 ... x_{n-1};
+     *               they need not all reach every output
+     * @throws std::invalid_argument if outputs is empty, or an input is not a
+     *         leaf or is repeated
+     */
+    Differentiator(const std::vector<ValuePtr> &outputs, const std::vector<ValuePtr> &inputs);
+
+    /**
+     * @brief Jacobian-vector products J v
+     * @param tangents Row-major [directions x n] input tangents
+     * @param out Row-major [directions x m] output tangents
+     * @param directions The number of directions
+     */
+    void jvp(const double *tangents, double *out, std::size_t directions = 1) const;
+
+    /**
+     * @brief Vector-Jacobian products u^T J
+     * @param cotangents Row-major [directions x m] output weights
+     * @param out Row-major [directions x n] input gradients
+     * @param directions The number of directions
+     */
+    void vjp(const double *cotangents, double *out, std::size_t directions = 1) const;
+
+    /**
+     * @brief Hessian-vector products H v of the first output
+     * @param tangents Row-major [directions x n] directions v
+     * @param out Row-major [directions x n] products
+     * @param directions The number of directions
+     *
+     * One forward sweep of tangents and one reverse sweep of dual adjoints
+     * for all directions; the Hessian itself is never formed.
+     */
+    void hvp(const double *tangents, double *out, std::size_t directions = 1) const;
+
+    /**
+     * @brief Get the full Jacobian
+     * @return Row-major [m x n], entry (i, j) = dy_i / dx_j; computed with
+     *         n forward directions or m reverse ones, whichever is fewer
+     */
+    std::vector<double> jacobian() const;
+
+    std::size_t num_inputs() const { return m_inputs.size(); }
+    std::size_t num_outputs() const { return m_outputs.size(); }
+
+  private:
+    std::vector<ValuePtr> m_outputs;      ///< Keep the graph alive
+    std::vector<ValuePtr> m_inputs;       ///< The leaves differentiated against
+    std::vector<const Value *> m_order;   ///< Every reachable node, children first
+    std::vector<std::uint32_t> m_begin;   ///< Node i's parents are m_parents[m_begin[i] .. m_begin[i + 1])
+    std::vector<std::uint32_t> m_parents; ///< Parent positions in m_order
+    std::vector<std::uint32_t> m_input_at;  ///< Position of each input in m_order
+    std::vector<std::uint32_t> m_output_at; ///< Position of each output in m_order
+};
+
+#endif // MICROGRAD_DERIVATIVES_HPP
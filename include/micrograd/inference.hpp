@@ -0,0 +1,84 @@
+#ifndef MICROGRAD_INFERENCE_HPP
+#define MICROGRAD_INFERENCE_HPP
+
+#include "mlp.hpp"
+#include "scalar.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class InferenceMLP
+ * @brief A frozen copy of an MLP's weights in a chosen scalar type.
+ * @tparam T The storage type: double, float or bfloat16.
+ *
+ * Training stays in double on the autograd graph; a deployment picks its
+ * own precision by snapshotting the trained network. float halves the
+ * bytes streamed per weight and doubles the SIMD lanes per instruction;
+ * bfloat16 halves the bytes again and accumulates in float. With T = double
+ * the outputs are bitwise identical to MLP::predict().
+ *
+ * Only float, double and bfloat16 are instantiated (in inference.cpp).
+ */
+template <typename T> class InferenceMLP {
+  public:
+    using compute_type = typename ScalarTraits<T>::compute_type; ///< Type of inputs, outputs and accumulators
+
+    /**
+     * @brief Snapshot a network.
+     * @param model The trained network; not referenced afterwards.
+     */
+    explicit InferenceMLP(const MLP &model);
+
+    /**
+     * @brief Refresh the snapshot after further training.
+     * @param model A network with the same architecture as the snapshot.
+     * @throws std::invalid_argument if the layer sizes or activations differ.
+     */
+    void load(const MLP &model);
+
+    /**
+     * @brief Forward pass for one sample.
+     * @param x nin inputs.
+     * @param y nout outputs.
+     *
+     * Allocation-free once the calling thread's scratch has grown to the
+     * widest layer, like MLP::predict().
+     */
+    void predict(const compute_type *x, compute_type *y) const;
+
+    /**
+     * @brief Forward pass over a batch.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] outputs.
+     * @param batch The number of samples.
+     */
+    void predict(const compute_type *x, compute_type *y, std::size_t batch) const;
+
+    std::size_t nin() const;
+    std::size_t nout() const;
+
+    /**
+     * @brief Get the number of bytes of weights and biases held.
+     */
+    std::size_t bytes() const;
+
+  private:
+    /// Weights and biases of one layer
+    struct DenseLayer {
+        std::size_t nin;
+        std::size_t nout;
+        std::vector<T> weights;          ///< [nout x nin] row-major
+        std::vector<compute_type> bias;  ///< [nout], kept at accumulator precision
+        Activation activation;
+    };
+
+    std::vector<DenseLayer> m_layers; ///< Input layer first
+    std::size_t m_nin;                ///< The number of inputs to the network
+    std::size_t m_max_width;          ///< Widest hidden layer, sizing the predict() scratch
+};
+
+extern template class InferenceMLP<double>;
+extern template class InferenceMLP<float>;
+extern template class InferenceMLP<bfloat16>;
+
+#endif // MICROGRAD_INFERENCE_HPP
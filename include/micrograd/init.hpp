@@ -0,0 +1,118 @@
+/**
+ * @file init.hpp
+ * @brief Seedable, counter-based random streams and weight initialization schemes
+ *
+ * An Rng holds no mutable state: the i-th number of a stream is a hash of
+ * the stream key and i (SplitMix64 finalizer). Streams can therefore be
+ * split per layer and per row and drawn from any number of threads at once,
+ * and the weights they produce do not depend on the thread count or on the
+ * order in which rows are filled.
+ */
+
+#ifndef MICROGRAD_INIT_HPP
+#define MICROGRAD_INIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+/**
+ * @enum Init
+ * @brief How weights are drawn; biases always start at 0.
+ */
+enum class Init : std::uint8_t {
+    Uniform,       ///< U(-1, 1), the historical default
+    XavierUniform, ///< U(-a, a), a = sqrt(6 / (fan_in + fan_out)); suits tanh
+    XavierNormal,  ///< N(0, 2 / (fan_in + fan_out))
+    HeUniform,     ///< U(-a, a), a = sqrt(6 / fan_in); suits ReLU
+    HeNormal,      ///< N(0, 2 / fan_in)
+};
+
+/**
+ * @class Rng
+ * @brief A stateless, counter-based random stream.
+ */
+class Rng {
+  public:
+    /**
+     * @brief Create the root stream of a seed.
+     */
+    explicit Rng(std::uint64_t seed);
+
+    /**
+     * @brief Derive an independent child stream, e.g. one per layer or row.
+     */
+    Rng stream(std::uint64_t id) const;
+
+    /**
+     * @brief Get the number at a position of the stream.
+     */
+    std::uint64_t bits(std::uint64_t counter) const;
+
+    /**
+     * @brief Get the number at a position of the stream as a double in [0, 1).
+     */
+    double uniform(std::uint64_t counter) const;
+
+    /**
+     * @brief Get a standard normal draw; uses positions 2 * counter and 2 * counter + 1.
+     */
+    double normal(std::uint64_t counter) const;
+
+  private:
+    struct Key {};
+    Rng(Key, std::uint64_t key);
+
+    std::uint64_t m_key; ///< Mixed seed of this stream
+};
+
+/**
+ * @brief Fill a row-major [nout x nin] weight block.
+ * @param w The weights; row r is drawn from rng.stream(r).
+ * @param nout Rows (fan-out).
+ * @param nin Columns (fan-in).
+ * @param scheme The distribution.
+ * @param rng The block's stream.
+ * @param pool Optional workers; rows are split across them.
+ */
+void init_weights(double *w, std::size_t nout, std::size_t nin, Init scheme, const Rng &rng,
+                  ThreadPool *pool = nullptr);
+
+/**
+ * @brief Fill one row of a weight block, exactly as init_weights() fills it.
+ * @param row The first of nin weights to fill.
+ * @param nout The number of rows of the block (fan-out).
+ * @param nin The length of the row (fan-in).
+ * @param scheme The distribution.
+ * @param rng The row's stream, i.e. the block's stream(r) for row r.
+ */
+void init_row(double *row, std::size_t nout, std::size_t nin, Init scheme, const Rng &rng);
+
+/**
+ * @brief Get the stream for the next default-initialized parameter block.
+ *
+ * Blocks created without an explicit Rng draw consecutive child streams of
+ * one process-wide seed, so a program constructing the same models in the
+ * same order gets the same weights on every run. Thread-safe.
+ */
+Rng next_default_init_stream();
+
+/**
+ * @brief Restart the default streams from a new seed.
+ */
+void seed_default_init(std::uint64_t seed);
+
+/**
+ * @brief Tag selecting constructors that leave the weights zero.
+ *
+ * For models whose weights are overwritten straight away, such as trainer
+ * replicas and loaded models. They take no default stream, so the models
+ * built after them get the same weights however many there were.
+ */
+struct NoInit {
+    explicit NoInit() = default;
+};
+inline constexpr NoInit no_init{};
+
+#endif // MICROGRAD_INIT_HPP
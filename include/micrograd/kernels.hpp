@@ -0,0 +1,146 @@
+/**
+ * @file kernels.hpp
+ * @brief Vectorized dense kernels with runtime instruction-set dispatch
+ *
+ * The kernels used by the tensor engine (dot products, axpy updates and
+ * the fused dense tanh layer) and by the optimizers are compiled for several instruction sets in
+ * the same binary: AVX-512 and AVX2+FMA on x86-64, NEON on AArch64, and a
+ * portable scalar fallback. The best variant supported by the running CPU
+ * is selected on first use, so one binary runs across heterogeneous
+ * machines. Setting the environment variable MICROGRAD_ISA to "scalar",
+ * "neon", "avx2" or "avx512" overrides the choice (unsupported values fall
+ * back to detection).
+ */
+
+#ifndef MICROGRAD_KERNELS_HPP
+#define MICROGRAD_KERNELS_HPP
+
+#include "scalar.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kernels {
+
+/**
+ * @enum Isa
+ * @brief Instruction sets with a dedicated kernel implementation
+ */
+enum class Isa {
+    Scalar, ///< Portable C++ loops
+    Neon,   ///< AArch64 Advanced SIMD, 2 doubles per register
+    Avx2,   ///< x86-64 AVX2 + FMA, 4 doubles per register
+    Avx512, ///< x86-64 AVX-512F, 8 doubles per register
+};
+
+/**
+ * @brief Get the printable name of an instruction set
+ * @param isa The instruction set
+ * @return Lower-case name, as accepted by MICROGRAD_ISA
+ */
+const char *isa_name(Isa isa);
+
+/**
+ * @brief Check whether this binary and the running CPU support an instruction set
+ * @param isa The instruction set
+ * @return true if select_isa(isa) would succeed
+ */
+bool isa_supported(Isa isa);
+
+/**
+ * @brief Get the instruction set currently used by the kernels
+ */
+Isa active_isa();
+
+/**
+ * @brief Force the kernels onto a specific instruction set
+ * @param isa A supported instruction set
+ * @throws std::invalid_argument if isa is not supported
+ */
+void select_isa(Isa isa);
+
+/**
+ * @brief Dot product of two contiguous vectors
+ * @return sum_i a[i] * b[i]
+ */
+double dot(const double *a, const double *b, std::size_t n);
+
+/**
+ * @brief Single-precision dot product, twice the lanes of the double one
+ */
+float dot(const float *a, const float *b, std::size_t n);
+
+/**
+ * @brief Dot product of bfloat16 weights with float activations
+ *
+ * Each weight is widened to float in registers and accumulated in float,
+ * so only half the bytes of a float dot are read from memory.
+ */
+float dot(const bfloat16 *a, const float *b, std::size_t n);
+
+/**
+ * @brief Exact dot product of int8 vectors with 32-bit accumulation
+ *
+ * Multiplies 32 bytes per AVX2 instruction pair and 64 per AVX-512 VNNI
+ * vpdpbusd, where the CPU has it. Valid for n up to 2^17 - 1 with any
+ * int8 inputs: each product is at most 2^14 in magnitude, so every
+ * partial sum and the result fit in int32. Longer vectors are not
+ * supported.
+ */
+std::int32_t dot(const std::int8_t *a, const std::int8_t *b, std::size_t n);
+
+/**
+ * @brief Scaled vector accumulation, y += alpha * x
+ */
+void axpy(double alpha, const double *x, double *y, std::size_t n);
+
+/**
+ * @brief Fused SGD-with-momentum update
+ * @param p Parameters, updated in place: p -= lr * v
+ * @param g Gradients
+ * @param v Velocity, updated in place first: v = mu * v + g
+ * @param lr Learning rate
+ * @param mu Momentum coefficient
+ */
+void momentum_update(double *p, const double *g, double *v, double lr, double mu, std::size_t n);
+
+/**
+ * @brief Fused Adam update
+ * @param p Parameters, updated in place: p -= step_size * m / (sqrt(v * inv_bias2) + eps)
+ * @param g Gradients
+ * @param m First moment, updated in place: m = beta1 * m + (1 - beta1) * g
+ * @param v Second moment, updated in place: v = beta2 * v + (1 - beta2) * g^2
+ * @param step_size Learning rate divided by the first-moment bias correction
+ * @param inv_bias2 Reciprocal of the second-moment bias correction
+ */
+void adam_update(double *p, const double *g, double *m, double *v, double beta1, double beta2, double step_size,
+                 double inv_bias2, double eps, std::size_t n);
+
+/**
+ * @brief Fused dense tanh layer forward for one sample
+ * @param W [nout x nin] row-major weights
+ * @param b [nout] biases
+ * @param x [nin] input
+ * @param y [nout] output, y[j] = tanh(dot(W[j], x) + b[j])
+ */
+void dense_tanh_forward(const double *W, const double *b, const double *x, double *y, std::size_t nout,
+                        std::size_t nin);
+
+/**
+ * @brief Fused dense tanh layer backward for one sample
+ * @param W [nout x nin] row-major weights
+ * @param x [nin] input of the forward pass
+ * @param y [nout] output of the forward pass
+ * @param gy [nout] gradient of the loss with respect to y
+ * @param dW [nout x nin] weight gradient, accumulated: dW += d . x^T (may be null)
+ * @param db [nout] bias gradient, accumulated: db += d (may be null)
+ * @param dx [nin] input gradient, accumulated: dx += W^T . d (may be null)
+ *
+ * Here d[j] = gy[j] * (1 - y[j]^2) is the gradient at the pre-activation.
+ */
+void dense_tanh_backward(const double *W, const double *x, const double *y, const double *gy, double *dW,
+                         double *db, double *dx, std::size_t nout, std::size_t nin);
+
+} // namespace kernels
+
+#endif // MICROGRAD_KERNELS_HPP
@@ -2,11 +2,19 @@
 #define MICROGRAD_LAYER_HPP
 
 #include "neuron.hpp"
+#include "tensor.hpp"
+#include "thread_pool.hpp"
+#include <cstddef>
 #include <vector>
 
 /**
  * @class Layer
  * @brief A layer of neurons in a neural network.
+ *
+ * The layer owns one contiguous ParameterBlock; each Neuron is a view of
+ * one of its rows. With a ThreadPool attached, both forward passes and the
+ * batched backward pass are split across neurons; results do not depend on
+ * the number of threads.
  */
 class Layer {
   public:
@@ -14,24 +22,130 @@ class Layer {
      * @brief Construct a Layer of neurons.
      * @param nin The number of inputs for each neuron in the layer.
      * @param nout The number of neurons in the layer (i.e., the output size).
+     * @param act The activation of every neuron.
      */
-    Layer(int nin, int nout);
+    Layer(int nin, int nout, Activation act = Activation::Tanh);
+
+    /**
+     * @brief Construct a Layer with zero weights and biases.
+     * @param nin The number of inputs for each neuron in the layer.
+     * @param nout The number of neurons in the layer.
+     * @param act The activation of every neuron.
+     */
+    Layer(int nin, int nout, Activation act, NoInit);
 
     /**
      * @brief Perform the forward pass for the entire layer.
      * @param x A vector of ValuePtrs representing the inputs.
      * @return A vector of ValuePtrs representing the outputs of all neurons.
+     *
+     * With a thread pool, neurons are evaluated concurrently unless a Tape
+     * is recording on this thread (tape recording is single-threaded).
      */
     std::vector<ValuePtr> operator()(const std::vector<ValuePtr> &x);
 
+    /**
+     * @brief Perform the forward pass for a whole batch at once.
+     * @param x A [batch x nin] tensor, one sample per row.
+     * @return A [batch x nout] tensor computed as act(x . W^T + b), where
+     *         row j of W holds neuron j's weights. For tanh this is one fused
+     *         dense_tanh node; other activations use a matrix product, a bias
+     *         and an activation node, without the thread pool.
+     */
+    TensorPtr operator()(const TensorPtr &x);
+
+    /**
+     * @brief Evaluate the layer on plain doubles, without building a graph.
+     * @param x nin inputs.
+     * @param y nout outputs, y[j] = act(w_j . x + b_j); must not alias x.
+     */
+    void predict(const double *x, double *y) const;
+
+    /**
+     * @brief Get the number of inputs of each neuron.
+     */
+    std::size_t nin() const;
+
+    /**
+     * @brief Get the number of neurons (outputs).
+     */
+    std::size_t nout() const;
+
+    /**
+     * @brief Get the activation of the neurons.
+     */
+    Activation activation() const;
+
     /**
      * @brief Get all parameters from all neurons in the layer.
-     * @return A single vector containing all parameters.
+     * @return Neuron 0's weights and bias, then neuron 1's, and so on. The
+     *         list is built once at construction, so this does not allocate.
+     */
+    const std::vector<ValuePtr> &parameters() const;
+
+    /**
+     * @brief Zero the gradients of every weight and bias in the layer.
+     */
+    void zero_grad();
+
+    /**
+     * @brief Freeze or unfreeze the layer's weights and biases.
+     * @param requires_grad false to leave them out of backward() on scalar
+     *                      graphs built afterwards and on every batched
+     *                      graph; their gradients stay as they are.
+     *
+     * Optimizers skip the layer's parameter spans while it is frozen, so
+     * momentum or Adam state does not keep moving it either.
+     */
+    void set_requires_grad(bool requires_grad);
+
+    /**
+     * @brief Check whether the layer's parameters require gradients.
+     */
+    bool requires_grad() const;
+
+    /**
+     * @brief Run this layer's forward and backward passes on a thread pool.
+     * @param pool The workers to use, or nullptr to run serially. Not owned;
+     *             it must outlive every graph built while it is attached.
+     */
+    void set_thread_pool(ThreadPool *pool);
+
+    /**
+     * @brief Get the attached thread pool, or nullptr.
      */
-    std::vector<ValuePtr> parameters() const;
+    ThreadPool *thread_pool() const;
+
+    /**
+     * @brief Get the [nout x nin] weight tensor (row j is neuron j's weights).
+     */
+    const TensorPtr &weights() const;
+
+    /**
+     * @brief Get the [1 x nout] bias tensor.
+     */
+    const TensorPtr &bias() const;
+
+    /**
+     * @brief Redraw the weights and zero the biases (see ParameterBlock::initialize).
+     * @param scheme The weight distribution.
+     * @param rng The layer's stream.
+     *
+     * Rows are filled on the attached thread pool, if any.
+     */
+    void initialize(Init scheme, const Rng &rng);
 
   private:
-    std::vector<Neuron> m_neurons; ///< The neurons in this layer
+    /**
+     * @brief Build the neurons over an allocated block.
+     */
+    Layer(std::shared_ptr<ParameterBlock> params, Activation act);
+
+    std::shared_ptr<ParameterBlock> m_params; ///< Contiguous weights and biases of all neurons
+    std::vector<Neuron> m_neurons;            ///< The neurons in this layer, views of m_params rows
+    std::vector<ValuePtr> m_parameters;       ///< Cached scalar views of every parameter, in neuron order
+    ThreadPool *m_pool = nullptr;             ///< Optional workers for the forward and backward passes
+    Activation m_activation;                  ///< Nonlinearity of every neuron
 };
 
 #endif // MICROGRAD_LAYER_HPP
\ No newline at end of file
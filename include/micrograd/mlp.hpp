@@ -2,8 +2,19 @@
 #define MICROGRAD_MLP_HPP
 
 #include "layer.hpp"
+#include "tensor.hpp"
+#include <cstddef>
 #include <vector>
 
+/**
+ * @struct BatchOutput
+ * @brief Result of a batched forward pass.
+ */
+struct BatchOutput {
+    TensorPtr output; ///< [batch x nout] network predictions, one row per sample
+    TensorPtr loss;   ///< 1 x 1 sum of squared errors over the whole batch (one fused node)
+};
+
 /**
  * @class MLP
  * @brief A Multi-Layer Perceptron (the full neural network).
@@ -17,6 +28,24 @@ class MLP {
      */
     MLP(int nin, const std::vector<int> &nouts);
 
+    /**
+     * @brief Construct the MLP with an activation per layer.
+     * @param nin The number of inputs to the network.
+     * @param nouts The size of each layer.
+     * @param activations The activation of each layer, e.g. {Relu, Relu, Linear}.
+     * @throws std::invalid_argument if the two lists differ in length.
+     */
+    MLP(int nin, const std::vector<int> &nouts, const std::vector<Activation> &activations);
+
+    /**
+     * @brief Construct the MLP with zero weights and biases, for callers that overwrite them.
+     * @param nin The number of inputs to the network.
+     * @param nouts The size of each layer.
+     * @param activations The activation of each layer.
+     * @throws std::invalid_argument if the two lists differ in length.
+     */
+    MLP(int nin, const std::vector<int> &nouts, const std::vector<Activation> &activations, NoInit);
+
     /**
      * @brief Perform the full forward pass through all layers.
      * @param x The initial input vector.
@@ -24,11 +53,79 @@ class MLP {
      */
     std::vector<ValuePtr> operator()(std::vector<ValuePtr> x);
 
+    /**
+     * @brief Perform the forward pass for a whole batch at once.
+     * @param x A [batch x nin] tensor, one sample per row.
+     * @return A [batch x nout] tensor from the final layer.
+     *
+     * Each layer runs as one matrix product instead of one scalar graph per
+     * sample; gradients reach the same parameters as the scalar path.
+     * With a checkpoint interval set, consecutive layers are grouped into
+     * checkpointed stacks (see set_checkpoint_interval()).
+     */
+    TensorPtr operator()(const TensorPtr &x);
+
+    /**
+     * @brief Run a batch forward and reduce it to a squared-error loss.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] targets.
+     * @param batch The number of samples.
+     * @return The batched predictions and the loss node to call backward() on.
+     */
+    BatchOutput forward_batch(const double *x, const double *y, std::size_t batch);
+
+    /**
+     * @brief Inference-only forward pass on plain doubles.
+     * @param x nin inputs.
+     * @param y nout outputs.
+     *
+     * No graph nodes are created and nothing is heap-allocated once the
+     * calling thread's scratch buffer has grown to the widest layer, so the
+     * call is safe to use concurrently from serving threads.
+     */
+    void predict(const double *x, double *y) const;
+
+    /**
+     * @brief Inference-only forward pass over a batch.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] outputs.
+     * @param batch The number of samples.
+     */
+    void predict(const double *x, double *y, std::size_t batch) const;
+
+    /**
+     * @brief Get the number of inputs to the network.
+     */
+    std::size_t nin() const;
+
+    /**
+     * @brief Get the size of the final layer.
+     */
+    std::size_t nout() const;
+
+    /**
+     * @brief Get the layers of the network, input layer first.
+     */
+    const std::vector<Layer> &layers() const;
+
+    /**
+     * @brief Get the activation of each layer, input layer first.
+     */
+    std::vector<Activation> activations() const;
+
     /**
      * @brief Get all parameters from all layers in the network.
-     * @return A single vector containing all network parameters.
+     * @return Every layer's parameters, input layer first. The list is built
+     *         once at construction, so this does not allocate.
      */
-    std::vector<ValuePtr> parameters() const;
+    const std::vector<ValuePtr> &parameters() const;
+
+    /**
+     * @brief Get flat views of every parameter buffer.
+     * @return Two spans per layer (weights, then biases), input layer first;
+     *         cached like parameters().
+     */
+    const std::vector<ParameterSpan> &parameter_spans() const;
 
     /**
      * @brief Zeros the gradients of all parameters in the network.
@@ -36,8 +133,67 @@ class MLP {
      */
     void zero_grad();
 
+    /**
+     * @brief Freeze or unfreeze one layer (see Layer::set_requires_grad).
+     * @param layer Index of the layer, input layer first.
+     * @param requires_grad false to freeze it, e.g. to fine-tune only the head.
+     * @throws std::out_of_range if layer is not a valid index.
+     */
+    void set_requires_grad(std::size_t layer, bool requires_grad);
+
+    /**
+     * @brief Redraw every layer's weights and zero the biases.
+     * @param scheme The weight distribution.
+     * @param rng The network's stream; layer l draws from rng.stream(l).
+     *
+     * The result depends only on the stream, not on any attached thread
+     * pool, so a seed reproduces a run:
+     *
+     *     mlp.initialize(Init::XavierUniform, Rng(42));
+     */
+    void initialize(Init scheme, const Rng &rng);
+
+    /**
+     * @brief Attach a thread pool to every layer (see Layer::set_thread_pool).
+     * @param pool The workers to use, or nullptr to run serially.
+     */
+    void set_thread_pool(ThreadPool *pool);
+
+    /**
+     * @brief Trade compute for memory in the batched forward and backward.
+     * @param interval Keep the activations only of every interval-th layer;
+     *                 0 or 1 keeps every layer's (the default).
+     *
+     * The batched path then runs each group of interval layers as one
+     * checkpoint_dense_tanh() node, which recomputes the group's inner
+     * activations during backward(). Peak memory drops from one activation
+     * per layer to one per group plus the inner activations of a single
+     * group, at the cost of about one extra forward pass. An interval near
+     * the square root of the depth minimizes the peak. Gradients are
+     * unchanged; the scalar path is not affected. Only runs of tanh layers
+     * are grouped: a group containing other activations is split into its
+     * runs of two or more tanh layers, and the other layers keep their
+     * activations.
+     */
+    void set_checkpoint_interval(std::size_t interval);
+
+    /**
+     * @brief Get the checkpoint interval (0 when checkpointing is off).
+     */
+    std::size_t checkpoint_interval() const;
+
   private:
-    std::vector<Layer> m_layers; ///< The layers of the network
+    /**
+     * @brief Build the layers, drawing default weights only if draw_weights is set.
+     */
+    MLP(int nin, const std::vector<int> &nouts, const std::vector<Activation> &activations, bool draw_weights);
+
+    std::vector<Layer> m_layers;         ///< The layers of the network
+    std::size_t m_nin;                   ///< The number of inputs to the network
+    std::size_t m_max_width;             ///< Widest hidden layer, sizing the predict() scratch
+    std::size_t m_checkpoint_interval;   ///< Layers per checkpointed group, or 0
+    std::vector<ValuePtr> m_parameters;  ///< Cached scalar views of every parameter
+    std::vector<ParameterSpan> m_spans;  ///< Cached weight and bias buffers of every layer
 };
 
 #endif // MICROGRAD_MLP_HPP
\ No newline at end of file
@@ -1,23 +1,133 @@
 #ifndef MICROGRAD_NEURON_HPP
 #define MICROGRAD_NEURON_HPP
 
+#include "init.hpp"
+#include "tensor.hpp"
 #include "value.hpp"
+#include <cstddef>
+#include <memory>
 #include <vector>
 
+/**
+ * @struct ParameterSpan
+ * @brief A contiguous run of parameters and their gradients.
+ */
+struct ParameterSpan {
+    double *data;                   ///< First parameter value
+    double *grad;                   ///< Gradient of the first parameter
+    std::size_t size;               ///< Number of parameters in the run
+    const Tensor *owner = nullptr;  ///< Tensor holding the run, if any
+
+    /**
+     * @brief Check whether the owning tensor is frozen, so updates must skip the run.
+     */
+    bool frozen() const { return owner && !owner->requires_grad(); }
+};
+
+/**
+ * @class ParameterBlock
+ * @brief Contiguous storage for the weights and biases of a group of neurons.
+ *
+ * Weights live in one [nout x nin] tensor (row j belongs to neuron j) and
+ * biases in one [1 x nout] tensor, each with a matching gradient buffer.
+ * The scalar ValuePtrs handed out for the parameters are bound to slots of
+ * these buffers and share ownership of the whole block, so the scalar and
+ * tensor paths read and accumulate into the same memory. Blocks must be
+ * owned by a std::shared_ptr (e.g. created with std::make_shared).
+ */
+class ParameterBlock : public std::enable_shared_from_this<ParameterBlock> {
+  public:
+    /**
+     * @brief Allocate and randomly initialize a block.
+     * @param nout The number of neurons (rows).
+     * @param nin The number of inputs per neuron (columns).
+     *
+     * Weights are uniform in [-1, 1] from next_default_init_stream(), biases 0.
+     */
+    ParameterBlock(std::size_t nout, std::size_t nin);
+
+    /**
+     * @brief Allocate a block with zero weights and biases.
+     * @param nout The number of neurons (rows).
+     * @param nin The number of inputs per neuron (columns).
+     */
+    ParameterBlock(std::size_t nout, std::size_t nin, NoInit);
+    ParameterBlock(const ParameterBlock &) = delete;
+    ParameterBlock &operator=(const ParameterBlock &) = delete;
+
+    std::size_t nout() const { return m_nout; }
+    std::size_t nin() const { return m_nin; }
+
+    /**
+     * @brief Get the [nout x nin] weight tensor.
+     */
+    const TensorPtr &weights() const { return m_weights; }
+
+    /**
+     * @brief Get the [1 x nout] bias tensor.
+     */
+    const TensorPtr &bias() const { return m_bias; }
+
+    /**
+     * @brief Get the scalar view of one weight.
+     * @param row The neuron index.
+     * @param col The input index.
+     */
+    ValuePtr weight_value(std::size_t row, std::size_t col);
+
+    /**
+     * @brief Get the scalar view of one bias.
+     * @param row The neuron index.
+     */
+    ValuePtr bias_value(std::size_t row);
+
+    /**
+     * @brief Zero every weight and bias gradient in one linear pass.
+     */
+    void zero_grad();
+
+    /**
+     * @brief Redraw the weights and zero the biases.
+     * @param scheme The weight distribution.
+     * @param rng The block's stream; row r draws from rng.stream(r).
+     * @param pool Optional workers filling rows in parallel; the result
+     *             does not depend on it.
+     */
+    void initialize(Init scheme, const Rng &rng, ThreadPool *pool = nullptr);
+
+  private:
+    std::size_t m_nout;          ///< The number of neurons
+    std::size_t m_nin;           ///< The number of inputs per neuron
+    TensorPtr m_weights;         ///< [nout x nin] weights and their gradients
+    TensorPtr m_bias;            ///< [1 x nout] biases and their gradients
+    std::vector<Value> m_values; ///< Bound scalar views: all weights row-major, then all biases
+};
+
 /**
  * @class Neuron
  * @brief A single neuron in a neural network layer.
  *
  * A neuron computes a weighted sum of its inputs, adds a bias,
- * and then applies an activation function (tanh).
+ * and then applies an activation function (tanh unless chosen otherwise). Its parameters are a
+ * view of one row of a ParameterBlock, which it may share with the other
+ * neurons of a Layer.
  */
 class Neuron {
   public:
     /**
-     * @brief Construct a Neuron.
+     * @brief Construct a Neuron that owns its own parameters.
      * @param nin The number of inputs to the neuron.
+     * @param act The activation applied to the weighted sum.
      */
-    explicit Neuron(int nin);
+    explicit Neuron(int nin, Activation act = Activation::Tanh);
+
+    /**
+     * @brief Construct a Neuron viewing one row of a shared block.
+     * @param block The parameter storage.
+     * @param row The row of the block holding this neuron's weights and bias.
+     * @param act The activation applied to the weighted sum.
+     */
+    Neuron(std::shared_ptr<ParameterBlock> block, std::size_t row, Activation act = Activation::Tanh);
 
     /**
      * @brief Perform the forward pass for the neuron.
@@ -32,9 +142,38 @@ class Neuron {
      */
     std::vector<ValuePtr> parameters() const;
 
+    /**
+     * @brief Get the weights of the neuron
+     * @return One ValuePtr per input
+     */
+    const std::vector<ValuePtr> &weights() const;
+
+    /**
+     * @brief Get the bias of the neuron
+     * @return The bias ValuePtr
+     */
+    const ValuePtr &bias() const;
+
+    /**
+     * @brief Get the activation applied to the weighted sum
+     */
+    Activation activation() const;
+
+    /**
+     * @brief Redraw this neuron's weights and zero its bias.
+     * @param scheme The weight distribution; fan-out is the number of rows
+     *               of the block.
+     * @param rng The block's stream; the neuron draws from rng.stream(row),
+     *            so it gets the same weights as ParameterBlock::initialize().
+     */
+    void initialize(Init scheme, const Rng &rng);
+
   private:
-    std::vector<ValuePtr> m_w; ///< The weights of the neuron
-    ValuePtr m_b;              ///< The bias of the neuron
+    std::shared_ptr<ParameterBlock> m_block; ///< Storage of the weights and bias
+    std::size_t m_row;                       ///< Row of m_block viewed by this neuron
+    std::vector<ValuePtr> m_w;               ///< The weights of the neuron (views into m_block)
+    ValuePtr m_b;                            ///< The bias of the neuron (view into m_block)
+    Activation m_activation;                 ///< Nonlinearity applied to the weighted sum
 };
 
-#endif // MICROGRAD_NEURON_HPP
\ No newline at end of file
+#endif // MICROGRAD_NEURON_HPP
@@ -0,0 +1,141 @@
+#ifndef MICROGRAD_OPTIMIZER_HPP
+#define MICROGRAD_OPTIMIZER_HPP
+
+#include "mlp.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class Optimizer
+ * @brief Base class for update rules over flat parameter buffers.
+ *
+ * The spans are captured once at construction; per-parameter optimizer
+ * state is kept in one contiguous buffer laid out in span order, so a
+ * step is a single streaming pass over parameters, gradients and state
+ * through the vectorized kernels in kernels.hpp.
+ *
+ * A step can also be applied one span at a time: begin_step() followed by
+ * update() of every span, in any order and from any one thread per span,
+ * equals step(). PipelinedTrainer uses this to update a layer as soon as
+ * its gradients are final.
+ */
+class Optimizer {
+  public:
+    /**
+     * @brief Capture the parameter buffers to update.
+     * @param spans The buffers, e.g. MLP::parameter_spans(); they must stay
+     *              valid for the optimizer's lifetime.
+     */
+    explicit Optimizer(std::vector<ParameterSpan> spans);
+    virtual ~Optimizer() = default;
+
+    /**
+     * @brief Apply one update using the current gradients.
+     */
+    void step();
+
+    /**
+     * @brief Advance the per-step state (e.g. Adam's bias corrections).
+     */
+    virtual void begin_step() {}
+
+    /**
+     * @brief Apply the current step to one span.
+     * @param span Index into spans(); begin_step() must have been called.
+     *
+     * Does nothing while the span is frozen (ParameterSpan::frozen()), so
+     * a frozen layer keeps its weights and its optimizer state.
+     */
+    virtual void update(std::size_t span) = 0;
+
+    /**
+     * @brief Reset every gradient in the captured spans to zero.
+     */
+    void zero_grad();
+
+    /**
+     * @brief Get the total number of parameters updated.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Get the captured parameter buffers.
+     */
+    const std::vector<ParameterSpan> &spans() const;
+
+  protected:
+    std::vector<ParameterSpan> m_spans; ///< The buffers to update
+    std::vector<std::size_t> m_offsets; ///< Offset of each span's state in the contiguous buffers
+    std::size_t m_size;                 ///< Sum of all span sizes
+};
+
+/**
+ * @class SGD
+ * @brief Stochastic gradient descent with optional momentum.
+ *
+ * Without momentum: p -= lr * g. With momentum mu: v = mu * v + g, then
+ * p -= lr * v.
+ */
+class SGD : public Optimizer {
+  public:
+    /**
+     * @brief Construct the optimizer.
+     * @param spans The parameter buffers to update.
+     * @param learning_rate The step size.
+     * @param momentum The momentum coefficient; 0 disables the velocity buffer.
+     */
+    SGD(std::vector<ParameterSpan> spans, double learning_rate, double momentum = 0.0);
+
+    void update(std::size_t span) override;
+
+    void set_learning_rate(double learning_rate);
+    double learning_rate() const;
+
+  private:
+    double m_learning_rate;          ///< Step size
+    double m_momentum;               ///< Velocity decay
+    std::vector<double> m_velocity;  ///< Contiguous velocity, one entry per parameter
+};
+
+/**
+ * @class Adam
+ * @brief Adam with bias-corrected first and second moment estimates.
+ */
+class Adam : public Optimizer {
+  public:
+    /**
+     * @brief Construct the optimizer.
+     * @param spans The parameter buffers to update.
+     * @param learning_rate The step size.
+     * @param beta1 Decay of the first moment estimate.
+     * @param beta2 Decay of the second moment estimate.
+     * @param eps Added to the denominator for numerical stability.
+     */
+    Adam(std::vector<ParameterSpan> spans, double learning_rate = 1e-3, double beta1 = 0.9, double beta2 = 0.999,
+         double eps = 1e-8);
+
+    void begin_step() override;
+    void update(std::size_t span) override;
+
+    void set_learning_rate(double learning_rate);
+    double learning_rate() const;
+
+    /**
+     * @brief Get the number of steps taken so far.
+     */
+    std::uint64_t steps() const;
+
+  private:
+    double m_learning_rate;   ///< Step size
+    double m_beta1;           ///< First moment decay
+    double m_beta2;           ///< Second moment decay
+    double m_eps;             ///< Denominator offset
+    std::uint64_t m_steps;    ///< Number of updates applied, for bias correction
+    double m_step_size;       ///< Bias-corrected step size of the current step
+    double m_inv_bias2;       ///< Inverse second moment bias correction of the current step
+    std::vector<double> m_m;  ///< Contiguous first moments, one entry per parameter
+    std::vector<double> m_v;  ///< Contiguous second moments, one entry per parameter
+};
+
+#endif // MICROGRAD_OPTIMIZER_HPP
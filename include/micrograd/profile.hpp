@@ -0,0 +1,146 @@
+/**
+ * @file profile.hpp
+ * @brief Optional instrumentation: node counters, allocated bytes and scoped timers
+ *
+ * Compiled out unless the build defines MICROGRAD_ENABLE_PROFILING (the CMake
+ * option of the same name). Disabled, the hook macros expand to nothing and
+ * the query functions report zeros, so calling code needs no #ifs of its own.
+ *
+ * Enabled, the library records:
+ * - the nodes make_value() creates, per Op;
+ * - the bytes allocated for heap nodes, tape blocks and tensor buffers;
+ * - a timed event per MLP layer forward, per Value::backward() topological
+ *   sort, and per run of the reverse sweep through nodes built by one layer.
+ *
+ * Results can be read as a text summary or written as a Chrome trace
+ * (chrome://tracing or https://ui.perfetto.dev).
+ */
+
+#ifndef MICROGRAD_PROFILE_HPP
+#define MICROGRAD_PROFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+enum class Op : std::uint8_t;
+
+namespace profile {
+
+#ifdef MICROGRAD_ENABLE_PROFILING
+constexpr bool enabled = true; ///< Whether this build records anything
+#else
+constexpr bool enabled = false;
+#endif
+
+/**
+ * @enum Alloc
+ * @brief What an allocation counted by count_bytes() was for
+ */
+enum class Alloc : std::uint8_t {
+    Node,   ///< Heap-allocated Value (excluding its shared_ptr control block)
+    Tape,   ///< Arena block of a Tape
+    Tensor, ///< Data and gradient buffers of a Tensor
+};
+
+/**
+ * @brief Count a node created by make_value()
+ */
+void count_node(Op op);
+
+/**
+ * @brief Count bytes allocated
+ */
+void count_bytes(Alloc kind, std::size_t bytes);
+
+/**
+ * @brief Microseconds since the first call; the trace clock
+ */
+double now_us();
+
+/**
+ * @brief Record a finished timed event
+ * @param name Phase name; must outlive the profile (a string literal)
+ * @param layer MLP layer the event belongs to, or -1
+ */
+void record(const char *name, int layer, double start_us, double end_us);
+
+/**
+ * @brief Get the MLP layer whose forward pass is running on this thread, or -1
+ *
+ * Nodes remember it when created, so the reverse sweep can be attributed
+ * to the layer that built each node.
+ */
+int current_layer();
+
+/**
+ * @class Scope
+ * @brief Times its own lifetime as one event
+ *
+ * A scope with a layer index also makes it the current_layer() of the
+ * thread until the scope ends.
+ */
+class Scope {
+  public:
+    explicit Scope(const char *name, int layer = -1);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    const char *m_name;    ///< Phase name
+    int m_layer;           ///< Layer index, or -1
+    int m_outer_layer;     ///< current_layer() to restore
+    double m_start_us;     ///< Start time
+};
+
+/**
+ * @brief Get the number of nodes created with an operation
+ */
+std::uint64_t nodes(Op op);
+
+/**
+ * @brief Get the number of bytes allocated of one kind
+ */
+std::uint64_t bytes(Alloc kind);
+
+/**
+ * @brief Clear all counters and recorded events
+ */
+void reset();
+
+/**
+ * @brief Get a table of node counts, bytes, and per-phase and per-layer times
+ */
+std::string summary();
+
+/**
+ * @brief Write the recorded events in Chrome trace event format
+ */
+void write_chrome_trace(std::ostream &out);
+
+/**
+ * @brief Write the recorded events in Chrome trace event format to a file
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void write_chrome_trace(const std::string &path);
+
+} // namespace profile
+
+#ifdef MICROGRAD_ENABLE_PROFILING
+#define MICROGRAD_PROFILE_CONCAT2(a, b) a##b
+#define MICROGRAD_PROFILE_CONCAT(a, b) MICROGRAD_PROFILE_CONCAT2(a, b)
+/// Time the rest of the enclosing block as an event of the given phase and layer
+#define MICROGRAD_PROFILE_SCOPE(name, layer) \
+    ::profile::Scope MICROGRAD_PROFILE_CONCAT(micrograd_profile_scope_, __LINE__)(name, layer)
+#define MICROGRAD_PROFILE_COUNT_NODE(op) ::profile::count_node(op)
+#define MICROGRAD_PROFILE_COUNT_BYTES(kind, n) ::profile::count_bytes(::profile::Alloc::kind, n)
+#else
+#define MICROGRAD_PROFILE_SCOPE(name, layer) ((void)0)
+#define MICROGRAD_PROFILE_COUNT_NODE(op) ((void)0)
+#define MICROGRAD_PROFILE_COUNT_BYTES(kind, n) ((void)0)
+#endif
+
+#endif // MICROGRAD_PROFILE_HPP
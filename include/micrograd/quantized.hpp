@@ -0,0 +1,105 @@
+#ifndef MICROGRAD_QUANTIZED_HPP
+#define MICROGRAD_QUANTIZED_HPP
+
+#include "mlp.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @enum WeightScale
+ * @brief How finely the int8 weights of a layer are scaled
+ */
+enum class WeightScale : std::uint8_t {
+    PerLayer, ///< One scale per layer, from its largest weight
+    PerRow,   ///< One scale per neuron, so a row of small weights keeps its resolution
+};
+
+/**
+ * @class QuantizedMLP
+ * @brief An int8 snapshot of an MLP for serving.
+ *
+ * Weights are stored as symmetric int8 with float scales, an eighth of the
+ * bytes of the double model. The input of every layer is quantized the
+ * same way, with one scale per layer calibrated on sample inputs: the
+ * largest magnitude the double model produces there maps to 127. Each
+ * neuron is then an exact int8 dot product (kernels::dot, AVX2 or
+ * AVX-512 VNNI where available), rescaled to float, plus a float bias.
+ * tanh layers use a lookup table with linear interpolation, accurate to
+ * about 1e-6, which is far below the quantization error.
+ *
+ * Inputs beyond the calibrated range saturate, so calibrate on data that
+ * is representative of what will be served, and check the result with
+ * max_error().
+ *
+ *     QuantizedMLP q(mlp, calibration.data(), 256);
+ *     if (q.max_error(mlp, validation.data(), 512) < 0.05) { ... }
+ */
+class QuantizedMLP {
+  public:
+    /**
+     * @brief Quantize a network.
+     * @param model The trained network; not referenced afterwards.
+     * @param calibration Row-major [samples x nin] representative inputs.
+     * @param samples The number of calibration samples.
+     * @param scale Per-layer or per-row weight scales.
+     * @throws std::invalid_argument if there are no calibration samples.
+     */
+    QuantizedMLP(const MLP &model, const double *calibration, std::size_t samples,
+                 WeightScale scale = WeightScale::PerRow);
+
+    /**
+     * @brief Forward pass for one sample.
+     * @param x nin inputs.
+     * @param y nout outputs.
+     *
+     * Allocation-free once the calling thread's scratch has grown to the
+     * widest layer, like MLP::predict().
+     */
+    void predict(const float *x, float *y) const;
+
+    /**
+     * @brief Forward pass over a batch.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] outputs.
+     * @param batch The number of samples.
+     */
+    void predict(const float *x, float *y, std::size_t batch) const;
+
+    /**
+     * @brief Compare against the double model.
+     * @param model The network this snapshot was taken from.
+     * @param x Row-major [samples x nin] inputs.
+     * @param samples The number of samples.
+     * @return The largest absolute difference between any output of
+     *         predict() and of model.predict().
+     * @throws std::invalid_argument if the model's sizes differ.
+     */
+    double max_error(const MLP &model, const double *x, std::size_t samples) const;
+
+    std::size_t nin() const;
+    std::size_t nout() const;
+
+    /**
+     * @brief Get the number of bytes of weights, scales and biases held.
+     */
+    std::size_t bytes() const;
+
+  private:
+    /// Quantized weights and float rescaling of one layer
+    struct QuantLayer {
+        std::size_t nin;
+        std::size_t nout;
+        std::vector<std::int8_t> weights; ///< [nout x nin] row-major
+        std::vector<float> dequant;       ///< [nout] weight scale times input scale
+        std::vector<float> bias;          ///< [nout]
+        float inv_input_scale;            ///< Maps the layer input to int8 units
+        Activation activation;
+    };
+
+    std::vector<QuantLayer> m_layers; ///< Input layer first
+    std::size_t m_nin;                ///< The number of inputs to the network
+    std::size_t m_max_width;          ///< Widest layer input, sizing the predict() scratch
+};
+
+#endif // MICROGRAD_QUANTIZED_HPP
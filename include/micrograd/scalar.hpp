@@ -0,0 +1,66 @@
+/**
+ * @file scalar.hpp
+ * @brief Reduced-precision storage types for inference
+ *
+ * Training always runs in double. A trained network can be served in a
+ * narrower type to halve or quarter the bytes streamed per weight and, on
+ * SIMD hardware, double the lanes per instruction; see InferenceMLP.
+ */
+
+#ifndef MICROGRAD_SCALAR_HPP
+#define MICROGRAD_SCALAR_HPP
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @struct bfloat16
+ * @brief 16-bit brain floating point: the top half of an IEEE float
+ *
+ * Same range as float with an 8-bit significand. Only used for storage;
+ * arithmetic is done after widening to float, which is exact.
+ */
+struct bfloat16 {
+    std::uint16_t bits; ///< Sign, 8 exponent bits, 7 mantissa bits
+
+    bfloat16() = default;
+
+    /**
+     * @brief Round a float to the nearest bfloat16, ties to even
+     */
+    explicit bfloat16(float f) {
+        std::uint32_t u;
+        std::memcpy(&u, &f, sizeof u);
+        if ((u & 0x7fffffffu) > 0x7f800000u) {
+            bits = static_cast<std::uint16_t>((u >> 16) | 0x0040u); // Keep NaNs quiet
+        } else {
+            bits = static_cast<std::uint16_t>((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+        }
+    }
+
+    /**
+     * @brief Widen to float (exact)
+     */
+    explicit operator float() const {
+        const std::uint32_t u = static_cast<std::uint32_t>(bits) << 16;
+        float f;
+        std::memcpy(&f, &u, sizeof f);
+        return f;
+    }
+};
+
+/**
+ * @struct ScalarTraits
+ * @brief Arithmetic type used for a storage type
+ *
+ * float and double compute in themselves; bfloat16 accumulates in float.
+ */
+template <typename T> struct ScalarTraits {
+    using compute_type = T;
+};
+
+template <> struct ScalarTraits<bfloat16> {
+    using compute_type = float;
+};
+
+#endif // MICROGRAD_SCALAR_HPP
@@ -0,0 +1,119 @@
+/**
+ * @file serialize.hpp
+ * @brief Versioned binary model files ("MGRD")
+ *
+ * Layout, in the byte order of the writing host (a loader on a host of the
+ * other byte order rejects the file through the byte-order mark):
+ *
+ *     offset 0   char[4]   magic "MGRD"
+ *            4   uint32    format version (2; version 1 files, without
+ *                          activations, load as all-tanh networks)
+ *            8   uint32    byte-order mark 0x01020304
+ *           12   uint32    bytes per scalar (8: IEEE double)
+ *           16   uint64    nin
+ *           24   uint64    number of layers L
+ *           32   uint64    offset of the parameter data (a multiple of 64)
+ *           40   uint64[L] nouts
+ *         40+8L   uint8[L]  activations (Activation enum values)
+ *            ... zero padding ...
+ *     data offset          per layer: weights [nout x nin] row-major, then
+ *                          biases [nout], back to back
+ *
+ * The parameter data is the same contiguous weight and bias blocks an MLP
+ * holds in memory, so saving is one write per block and a mapped file can
+ * be used in place.
+ */
+
+#ifndef MICROGRAD_SERIALIZE_HPP
+#define MICROGRAD_SERIALIZE_HPP
+
+#include "mlp.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Write a model to a file.
+ * @param model The network to save.
+ * @param path Destination; overwritten if it exists.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void save_model(const MLP &model, const std::string &path);
+
+/**
+ * @brief Read a model file into a trainable MLP.
+ * @param path A file written by save_model().
+ * @return A network with the saved architecture and parameters.
+ * @throws std::runtime_error if the file is missing, truncated or not a
+ *         supported MGRD file.
+ */
+MLP load_model(const std::string &path);
+
+/**
+ * @class MappedModel
+ * @brief Read-only, zero-copy view of a model file for inference.
+ *
+ * The file is memory-mapped rather than read, so opening costs no copying
+ * regardless of model size, pages are loaded on first touch, and every
+ * process that maps the same file shares one copy of the weights in the
+ * page cache. The file must not be modified while mapped.
+ */
+class MappedModel {
+  public:
+    /// Non-owning view of one layer's parameters inside the mapping
+    struct LayerView {
+        std::size_t nin;
+        std::size_t nout;
+        Activation activation;
+        const double *weights; ///< [nout x nin] row-major
+        const double *bias;    ///< [nout]
+    };
+
+    /**
+     * @brief Map a model file.
+     * @param path A file written by save_model().
+     * @throws std::runtime_error as for load_model().
+     */
+    explicit MappedModel(const std::string &path);
+    ~MappedModel();
+
+    MappedModel(const MappedModel &) = delete;
+    MappedModel &operator=(const MappedModel &) = delete;
+    MappedModel(MappedModel &&other) noexcept;
+    MappedModel &operator=(MappedModel &&other) noexcept;
+
+    /**
+     * @brief Inference-only forward pass, as MLP::predict().
+     * @param x nin inputs.
+     * @param y nout outputs.
+     */
+    void predict(const double *x, double *y) const;
+
+    /**
+     * @brief Inference-only forward pass over a batch.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] outputs.
+     * @param batch The number of samples.
+     */
+    void predict(const double *x, double *y, std::size_t batch) const;
+
+    std::size_t nin() const;
+    std::size_t nout() const;
+
+    /**
+     * @brief Get the layers, input layer first.
+     */
+    const std::vector<LayerView> &layers() const;
+
+  private:
+    void release() noexcept;
+
+    void *m_base;                    ///< Start of the mapping (or of the owned copy without mmap)
+    std::size_t m_length;            ///< Length of the mapping in bytes
+    std::vector<LayerView> m_layers; ///< Views into the mapping
+    std::size_t m_nin;               ///< The number of inputs to the network
+    std::size_t m_max_width;         ///< Widest hidden layer, sizing the predict() scratch
+};
+
+#endif // MICROGRAD_SERIALIZE_HPP
@@ -0,0 +1,147 @@
+/**
+ * @file tape.hpp
+ * @brief Arena-backed tape for recording the nodes of one forward pass
+ *
+ * While a TapeScope is active on a thread, every Value created through
+ * make_value() (including the intermediates produced by the operator
+ * overloads) is placement-constructed into a contiguous, bump-allocated
+ * block owned by the Tape instead of being heap-allocated through
+ * std::make_shared. The ValuePtrs handed out for these nodes are
+ * non-owning: they carry no reference count, so copying them costs no
+ * atomic traffic. All recorded nodes are destroyed in one shot by
+ * Tape::clear(), typically right after backward().
+ *
+ * Parameters (weights, biases) should be created outside of any TapeScope
+ * so that they keep regular shared ownership and survive clear().
+ */
+
+#ifndef MICROGRAD_TAPE_HPP
+#define MICROGRAD_TAPE_HPP
+
+#include "value.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class Tape
+ * @brief Bump allocator and reverse-sweep driver for graph nodes
+ *
+ * Nodes are stored in fixed-size blocks that are kept after clear(), so a
+ * training loop that records a graph of the same size every step stops
+ * allocating after the first iteration. Nodes are addressed by their
+ * recording index; because a node can only be created after its children,
+ * recording order is already a valid topological order.
+ */
+class Tape {
+  public:
+    /**
+     * @brief Construct an empty tape
+     * @param block_size Number of nodes stored per arena block
+     */
+    explicit Tape(std::size_t block_size = 4096);
+
+    /**
+     * @brief Destroy all recorded nodes and release the arena
+     */
+    ~Tape();
+
+    Tape(const Tape &) = delete;
+    Tape &operator=(const Tape &) = delete;
+
+    /**
+     * @brief Construct a new node at the end of the tape
+     * @param data The numerical value to store
+     * @param label Optional human-readable identifier
+     * @return Non-owning pointer to the recorded node
+     */
+    ValuePtr record(double data);
+    ValuePtr record(double data, const std::string &label);
+
+    /**
+     * @brief Construct a new node with parents at the end of the tape
+     * @param data The numerical value to store
+     * @param children The parent nodes of this value
+     * @param op The operation that created this value
+     * @param label Optional human-readable identifier
+     * @return Non-owning pointer to the recorded node
+     */
+    ValuePtr record(double data, ChildList children, Op op = Op::None);
+    ValuePtr record(double data, ChildList children, Op op, const std::string &label);
+
+    /**
+     * @brief Get the number of nodes currently recorded
+     * @return Node count
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Access a recorded node by its index
+     * @param index Recording index in [0, size())
+     * @return Reference to the node
+     */
+    Value &operator[](std::size_t index);
+    const Value &operator[](std::size_t index) const;
+
+    /**
+     * @brief Backpropagate from a recorded root by sweeping the tape in reverse
+     * @param root The output node (e.g. the loss); must have been recorded on this tape
+     *
+     * No topological sort is performed: recording order is used directly,
+     * and only nodes the root depends on are stepped, so other graphs on the
+     * same tape are left alone. Every node of the graph between the
+     * parameters and the root must have been recorded on this tape.
+     */
+    void backward(const ValuePtr &root);
+
+    /**
+     * @brief Destroy every recorded node and rewind the arena
+     *
+     * The blocks themselves are retained for reuse. All ValuePtrs that point
+     * at recorded nodes are dangling afterwards.
+     */
+    void clear();
+
+    /**
+     * @brief Get the tape recording on the calling thread
+     * @return The active tape, or nullptr when no TapeScope is alive
+     */
+    static Tape *active();
+
+  private:
+    friend class TapeScope;
+
+    /// Raw, correctly aligned storage for one node
+    struct alignas(Value) Slot {
+        unsigned char bytes[sizeof(Value)];
+    };
+
+    Value *slot(std::size_t index) const;
+    void *next_slot();
+
+    std::vector<std::unique_ptr<Slot[]>> m_blocks; ///< Arena blocks, kept across clear()
+    std::size_t m_block_size;                      ///< Nodes per block
+    std::size_t m_size;                            ///< Number of live recorded nodes
+};
+
+/**
+ * @class TapeScope
+ * @brief RAII guard that routes make_value() on this thread to a Tape
+ *
+ * Scopes nest: destroying a scope restores the previously active tape.
+ */
+class TapeScope {
+  public:
+    explicit TapeScope(Tape &tape);
+    ~TapeScope();
+
+    TapeScope(const TapeScope &) = delete;
+    TapeScope &operator=(const TapeScope &) = delete;
+
+  private:
+    Tape *m_previous; ///< Tape that was active before this scope
+};
+
+#endif // MICROGRAD_TAPE_HPP
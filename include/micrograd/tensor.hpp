@@ -0,0 +1,351 @@
+/**
+ * @file tensor.hpp
+ * @brief Tensor class declaration for batched automatic differentiation
+ *
+ * A Tensor is a graph node whose data and gradient are contiguous,
+ * row-major matrices. Each op (matmul, bias add, elementwise activations,
+ * reductions) is a single node with a single backward kernel, so a dense
+ * layer costs a handful of nodes instead of one scalar Value per multiply
+ * and add. The scalar Value API remains the reference engine for small
+ * graphs and tests.
+ */
+
+#ifndef MICROGRAD_TENSOR_HPP
+#define MICROGRAD_TENSOR_HPP
+
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class Tensor;
+class ThreadPool;
+
+/**
+ * Type alias for shared pointer to Tensor, mirroring ValuePtr
+ */
+using TensorPtr = std::shared_ptr<Tensor>;
+
+/**
+ * @enum TensorOp
+ * @brief Operation that produced a tensor node; selects its backward kernel
+ */
+enum class TensorOp : std::uint8_t {
+    None,            ///< Leaf (input or parameter)
+    Add,             ///< a + b, same shape
+    Sub,             ///< a - b, same shape
+    Mul,             ///< a * b elementwise, same shape
+    MatMul,          ///< a[m x k] . b[k x n]
+    MatMulTransposed,///< a[m x k] . b[n x k]^T
+    AddBias,         ///< x[m x n] + b[1 x n], bias broadcast over rows
+    Tanh,            ///< tanh(x) elementwise
+    Exp,             ///< exp(x) elementwise
+    Pow,             ///< x ^ n elementwise, constant n stored in the node
+    Sum,             ///< Sum of all elements, as a 1 x 1 tensor
+    FromValues,      ///< Scalar Values packed into a tensor; backward scatters into them
+    DenseTanh,       ///< tanh(x . W^T + b), a whole dense layer fused into one node
+    Recompute,       ///< A stack of dense tanh layers whose inner activations are recomputed in backward
+    Activate,        ///< Elementwise ReLU, sigmoid or GELU, the Activation stored in the node
+    LogSumExp,       ///< log(sum_j exp(x_ij)) of every row, as an [m x 1] tensor
+    SoftmaxCrossEntropy, ///< Mean over rows of -log softmax(x_i)_{t_i}; the classes are the second parent
+    SquaredError,    ///< s * sum (p - t)^2 as a 1 x 1 tensor, the scale s stored in the node
+};
+
+/**
+ * @brief Get the printable name of a tensor operation
+ * @param op The operation
+ * @return Short name such as "matmul"; empty for leaves
+ */
+const char *op_name(TensorOp op);
+
+/**
+ * @class Tensor
+ * @brief Graph node holding a row-major matrix and its gradient
+ *
+ * Vectors are represented as 1 x n (row) tensors and scalars as 1 x 1.
+ * Shape mismatches are reported with std::invalid_argument.
+ */
+class Tensor {
+  private:
+    std::size_t m_rows;         ///< Number of rows
+    std::size_t m_cols;         ///< Number of columns
+    std::vector<double> m_data; ///< Row-major values
+    std::vector<double> m_grad; ///< Row-major accumulated gradient
+
+    // --- Graph-related members ---
+    TensorOp m_op;                   ///< Operation that produced this tensor
+    double m_aux;                    ///< Op-specific constant (the exponent for TensorOp::Pow)
+    std::vector<TensorPtr> m_prev;   ///< Parent nodes, in operand order
+    std::vector<ValuePtr> m_sources; ///< Scalar parents of a TensorOp::FromValues node
+    ThreadPool *m_pool;              ///< Workers for a DenseTanh or Recompute backward, or nullptr
+    std::uint64_t m_visit_epoch;     ///< Epoch of the last traversal that visited this node
+    bool m_requires_grad;            ///< Whether backward() accumulates into this leaf
+
+  public:
+    /**
+     * @brief Construct a leaf tensor filled with a constant
+     * @param rows Number of rows
+     * @param cols Number of columns
+     * @param fill Initial value of every element
+     */
+    Tensor(std::size_t rows, std::size_t cols, double fill = 0.0);
+
+    /**
+     * @brief Construct a leaf tensor from row-major data
+     * @param rows Number of rows
+     * @param cols Number of columns
+     * @param data rows * cols values in row-major order
+     */
+    Tensor(std::size_t rows, std::size_t cols, std::vector<double> data);
+
+    /**
+     * @brief Construct an op node with uninitialized (zero) data
+     * @param rows Number of rows
+     * @param cols Number of columns
+     * @param children The parent nodes of this tensor
+     * @param op The operation that created this tensor
+     */
+    Tensor(std::size_t rows, std::size_t cols, std::vector<TensorPtr> children, TensorOp op);
+
+    // ======= ACCESSORS =======
+    std::size_t rows() const { return m_rows; }
+    std::size_t cols() const { return m_cols; }
+    std::size_t size() const { return m_data.size(); }
+
+    /**
+     * @brief Get the contiguous row-major data buffer
+     */
+    double *data() { return m_data.data(); }
+    const double *data() const { return m_data.data(); }
+
+    /**
+     * @brief Get the contiguous row-major gradient buffer
+     */
+    double *grad() { return m_grad.data(); }
+    const double *grad() const { return m_grad.data(); }
+
+    /**
+     * @brief Get a single element
+     * @param row Row index
+     * @param col Column index
+     * @return The value at (row, col)
+     */
+    double at(std::size_t row, std::size_t col) const { return m_data[row * m_cols + col]; }
+
+    /**
+     * @brief Get a single gradient element
+     * @param row Row index
+     * @param col Column index
+     * @return The gradient at (row, col)
+     */
+    double grad_at(std::size_t row, std::size_t col) const { return m_grad[row * m_cols + col]; }
+
+    const std::vector<TensorPtr> &prev() const { return m_prev; }
+    TensorOp op() const { return m_op; }
+
+    /**
+     * @brief Check whether backward() accumulates into this tensor's gradient
+     */
+    bool requires_grad() const { return m_requires_grad; }
+
+    // ======= MUTATORS =======
+    /**
+     * @brief Reset every gradient element to zero
+     */
+    void zero_grad();
+
+    /**
+     * @brief Mark a leaf as differentiable or not, e.g. to freeze a weight matrix
+     * @param requires_grad false to leave the leaf's gradient untouched by backward()
+     * @throws std::invalid_argument for an op node
+     *
+     * The flag is read during backward(), so it also applies to graphs built
+     * earlier. It is honoured by the ops that take parameters (matmul,
+     * matmul_transposed, add_bias, dense_tanh and checkpoint_dense_tanh);
+     * the elementwise ops and losses always propagate.
+     */
+    void set_requires_grad(bool requires_grad);
+
+    // ======== BACKPROPAGATION ========
+    /**
+     * @brief Perform backpropagation from this Tensor
+     *
+     * Seeds every element's gradient with 1, i.e. differentiates the sum of
+     * this tensor's elements; for a 1 x 1 loss that is the usual dL/dL = 1.
+     */
+    void backward();
+
+    /**
+     * @brief Backpropagate using a previously built topological order
+     * @param order Ordering produced by build_topo() on this Tensor
+     */
+    void backward(const std::vector<Tensor *> &order);
+
+    /**
+     * @brief Backpropagate, reporting each node as it finishes
+     * @param order Ordering produced by build_topo() on this Tensor
+     * @param after_step Called with i once order[i] has propagated to its
+     *                   parents; a leaf's gradient is final after the call for
+     *                   the lowest i among its users
+     */
+    void backward(const std::vector<Tensor *> &order, const std::function<void(std::size_t)> &after_step);
+
+    /**
+     * @brief Build a topological order of the graph rooted at this Tensor
+     * @param order Output vector, cleared first; children precede parents
+     *              and this Tensor is the last element
+     */
+    void build_topo(std::vector<Tensor *> &order);
+
+  private:
+    /**
+     * @brief Propagate this node's gradient to its parents
+     */
+    void backward_step();
+
+    friend TensorPtr pow(const TensorPtr &base, double exp);
+    friend TensorPtr from_values(const std::vector<ValuePtr> &values, std::size_t rows, std::size_t cols);
+    friend TensorPtr dense_tanh(const TensorPtr &x, const TensorPtr &weights, const TensorPtr &bias,
+                                ThreadPool *pool);
+    friend TensorPtr checkpoint_dense_tanh(const TensorPtr &x, const std::vector<TensorPtr> &layers,
+                                           ThreadPool *pool);
+    friend TensorPtr activate(const TensorPtr &x, Activation act);
+    friend TensorPtr squared_error(const TensorPtr &predictions, const TensorPtr &targets, double scale);
+};
+
+// ======== FACTORY FUNCTIONS =========
+TensorPtr make_tensor(std::size_t rows, std::size_t cols, double fill = 0.0);
+TensorPtr make_tensor(std::size_t rows, std::size_t cols, std::vector<double> data);
+
+/**
+ * @brief Pack scalar Values into a tensor, bridging the scalar and tensor engines
+ * @param values rows * cols Values in row-major order
+ * @param rows Number of rows
+ * @param cols Number of columns
+ * @return Tensor holding a copy of the values' data; its backward pass adds
+ *         the tensor gradient into each Value's grad
+ */
+TensorPtr from_values(const std::vector<ValuePtr> &values, std::size_t rows, std::size_t cols);
+
+// ======== TENSOR OPS ========
+TensorPtr operator+(const TensorPtr &lhs, const TensorPtr &rhs);
+TensorPtr operator-(const TensorPtr &lhs, const TensorPtr &rhs);
+TensorPtr operator*(const TensorPtr &lhs, const TensorPtr &rhs); // Elementwise
+
+/**
+ * @brief Matrix product a . b
+ * @param a [m x k] tensor
+ * @param b [k x n] tensor
+ * @return [m x n] tensor
+ */
+TensorPtr matmul(const TensorPtr &a, const TensorPtr &b);
+
+/**
+ * @brief Matrix product with the right operand transposed, a . b^T
+ * @param a [m x k] tensor, e.g. a batch of inputs
+ * @param b [n x k] tensor, e.g. a weight matrix with one row per neuron
+ * @return [m x n] tensor
+ */
+TensorPtr matmul_transposed(const TensorPtr &a, const TensorPtr &b);
+
+/**
+ * @brief Fused dense tanh layer, tanh(x . W^T + b)
+ * @param x [m x nin] tensor, one sample per row
+ * @param weights [nout x nin] tensor, one neuron per row
+ * @param bias [1 x nout] tensor
+ * @param pool Optional workers to split the forward and backward across
+ * @return [m x nout] tensor
+ *
+ * Equivalent to tanh(add_bias(matmul_transposed(x, weights), bias)) but a
+ * single node whose forward and backward run the vectorized kernels in
+ * kernels.hpp without materializing the pre-activations.
+ *
+ * With a pool, the forward and the weight and bias gradients are split by
+ * neuron, and the input gradient by (row, column block). Every output
+ * element has exactly one owner that accumulates it in neuron order, so
+ * the results are bitwise identical to the serial path for any pool size.
+ * The pool must outlive the backward pass of the returned node.
+ */
+TensorPtr dense_tanh(const TensorPtr &x, const TensorPtr &weights, const TensorPtr &bias,
+                     ThreadPool *pool = nullptr);
+
+/**
+ * @brief Apply a stack of dense tanh layers as one checkpointed node
+ * @param x [m x nin] tensor, kept alive as the checkpoint
+ * @param layers Weight and bias tensors of each layer in turn: W0, b0, W1, b1, ...
+ * @param pool Optional workers, used as in dense_tanh()
+ * @return [m x nout] output of the last layer
+ *
+ * Only the input and the output are stored. The backward pass rebuilds the
+ * inner layers from the input as a temporary graph of dense_tanh() nodes,
+ * backpropagates through it and frees it again, so the activations of a
+ * stack cost memory only while that stack is being differentiated. Values
+ * and parameter gradients are bitwise identical to chaining dense_tanh()
+ * directly; the input gradient is summed on its own before being added
+ * into x's.
+ * @throws std::invalid_argument if layers is empty or has an odd size, or
+ *         if the shapes do not chain
+ */
+TensorPtr checkpoint_dense_tanh(const TensorPtr &x, const std::vector<TensorPtr> &layers,
+                                ThreadPool *pool = nullptr);
+
+/**
+ * @brief Add a bias row to every row of x
+ * @param x [m x n] tensor
+ * @param bias [1 x n] tensor
+ * @return [m x n] tensor
+ */
+TensorPtr add_bias(const TensorPtr &x, const TensorPtr &bias);
+
+TensorPtr tanh(const TensorPtr &x);
+TensorPtr exp(const TensorPtr &x);
+TensorPtr pow(const TensorPtr &base, double exp);
+
+/**
+ * @brief Apply a layer activation elementwise
+ * @return tanh(x) for Tanh, x itself for Linear, otherwise one Activate node
+ */
+TensorPtr activate(const TensorPtr &x, Activation act);
+
+/**
+ * @brief Sum every element
+ * @param x Any tensor
+ * @return 1 x 1 tensor
+ */
+TensorPtr sum(const TensorPtr &x);
+
+// ======== FUSED LOSSES ========
+// One node each, with a closed-form backward and no intermediate tensors.
+
+/**
+ * @brief Row-wise log-sum-exp, computed with each row's maximum factored out
+ * @param x [m x k] tensor
+ * @return [m x 1] tensor
+ */
+TensorPtr logsumexp(const TensorPtr &x);
+
+/**
+ * @brief Mean softmax cross-entropy of the rows of logits against class indices
+ * @param logits [m x k] tensor, one sample per row
+ * @param classes m class indices in [0, k)
+ * @return 1 x 1 tensor; the logits gradient is (softmax - onehot) / m
+ * @throws std::invalid_argument if there is not one valid class per row
+ */
+TensorPtr softmax_cross_entropy(const TensorPtr &logits, const std::vector<std::size_t> &classes);
+
+/**
+ * @brief scale * sum of (predictions - targets)^2 over every element
+ * @return 1 x 1 tensor; equal to sum(pow(predictions - targets, 2)) * scale
+ * @throws std::invalid_argument if the shapes differ
+ */
+TensorPtr squared_error(const TensorPtr &predictions, const TensorPtr &targets, double scale = 1.0);
+
+/**
+ * @brief Mean squared error, squared_error() scaled by 1 / size
+ */
+TensorPtr mse(const TensorPtr &predictions, const TensorPtr &targets);
+
+#endif // MICROGRAD_TENSOR_HPP
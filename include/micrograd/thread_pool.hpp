@@ -0,0 +1,101 @@
+/**
+ * @file thread_pool.hpp
+ * @brief Fixed-size worker pool for splitting loops across cores
+ *
+ * A ThreadPool owns a set of worker threads that sleep until
+ * parallel_for() hands them a range to split. The calling thread takes
+ * part in the work and returns only once every chunk has finished, so a
+ * parallel_for() behaves like an ordinary loop to the code around it.
+ *
+ * The pool makes no promise about which thread runs which chunk or in
+ * what order. Callers that need reproducible floating-point results must
+ * give every output element a single owner, as the threaded dense layer
+ * kernels in tensor.cpp do, rather than accumulate across chunks.
+ */
+
+#ifndef MICROGRAD_THREAD_POOL_HPP
+#define MICROGRAD_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Workers that execute a parallel_for() alongside the calling thread
+ */
+class ThreadPool {
+  public:
+    /**
+     * @brief Function run on one chunk of a parallel_for(), covering [begin, end)
+     */
+    using RangeFn = std::function<void(std::size_t begin, std::size_t end)>;
+
+    /**
+     * @brief Start the workers
+     * @param threads Total number of threads including the caller; 0 or 1
+     *                starts no workers and runs every loop inline
+     */
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency());
+
+    /**
+     * @brief Stop and join the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Get the number of threads that share a loop, including the caller
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Split [0, count) into at most size() contiguous chunks and run them
+     * @param count Number of loop iterations
+     * @param body Called once per non-empty chunk
+     *
+     * Blocks until every chunk has returned. The first exception thrown by
+     * a chunk is rethrown here after the others finish. Calls made from
+     * inside a chunk (nested loops) run inline on the current thread;
+     * concurrent calls from unrelated threads are serialized.
+     */
+    void parallel_for(std::size_t count, const RangeFn &body);
+
+  private:
+    /**
+     * @brief Sleep until a job is posted, then help run it
+     */
+    void worker_loop();
+
+    /**
+     * @brief Claim and run chunks of the current job until none are left
+     */
+    void run_chunks(const RangeFn &body, std::size_t count, std::size_t chunks);
+
+    std::vector<std::thread> m_workers; ///< Worker threads, size() - 1 of them
+
+    std::mutex m_submit;             ///< Serializes parallel_for() callers
+    std::mutex m_mutex;              ///< Guards the job description below
+    std::condition_variable m_wake;  ///< Signals workers that a job was posted
+    std::condition_variable m_done;  ///< Signals the caller that the job finished
+
+    const RangeFn *m_body;           ///< Current job, or nullptr between jobs
+    std::size_t m_count;             ///< Iterations in the current job
+    std::size_t m_chunks;            ///< Chunks the current job is split into
+    std::atomic<std::size_t> m_next; ///< Next unclaimed chunk
+    std::size_t m_finished;          ///< Chunks completed so far
+    std::size_t m_active;            ///< Workers currently holding the job
+    std::uint64_t m_generation;      ///< Incremented for every posted job
+    std::exception_ptr m_error;      ///< First exception thrown by a chunk
+    bool m_stop;                     ///< Set by the destructor
+};
+
+#endif // MICROGRAD_THREAD_POOL_HPP
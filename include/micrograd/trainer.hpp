@@ -0,0 +1,195 @@
+#ifndef MICROGRAD_TRAINER_HPP
+#define MICROGRAD_TRAINER_HPP
+
+#include "mlp.hpp"
+#include "optimizer.hpp"
+#include "thread_pool.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class BatchLoader;
+
+/**
+ * @class Trainer
+ * @brief Data-parallel training driver for an MLP.
+ *
+ * A mini-batch is split into one contiguous shard per thread. Each thread
+ * owns a replica of the network: before every pass the replica's weights
+ * are refreshed from the model, and the shard's forward and backward
+ * graphs accumulate into the replica's own gradient buffers, so no two
+ * threads ever write the same gradient. The per-thread gradients are then
+ * combined by a pairwise tree reduction and added into the model's grads.
+ *
+ * The summation order depends only on the number of threads, so a given
+ * thread count always reproduces the same gradients bit for bit.
+ */
+class Trainer {
+  public:
+    /**
+     * @brief Create the replicas and the worker threads.
+     * @param model The network to train. Not owned; must outlive the trainer
+     *              and keep its architecture.
+     * @param threads The number of shards (and threads) per mini-batch.
+     */
+    Trainer(MLP &model, std::size_t threads);
+
+    /**
+     * @brief Add the gradient of a mini-batch's squared-error loss to the model.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] targets.
+     * @param batch The number of samples.
+     * @return The summed squared-error loss over the batch.
+     *
+     * Like backward(), this accumulates: call model.zero_grad() first to
+     * get the gradient of this batch alone.
+     */
+    double backward_batch(const double *x, const double *y, std::size_t batch);
+
+    /**
+     * @brief Run one plain gradient-descent step on a mini-batch.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] targets.
+     * @param batch The number of samples.
+     * @param learning_rate The step size.
+     * @return The loss before the update.
+     */
+    double step(const double *x, const double *y, std::size_t batch, double learning_rate);
+
+    /**
+     * @brief Run one optimizer step on a mini-batch.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] targets.
+     * @param batch The number of samples.
+     * @param optimizer An optimizer over the model's parameters.
+     * @return The loss before the update.
+     */
+    double step(const double *x, const double *y, std::size_t batch, Optimizer &optimizer);
+
+    /**
+     * @brief Get the number of threads a batch is split across.
+     */
+    std::size_t threads() const;
+
+  private:
+    /**
+     * @brief Copy the model's current weights, biases and checkpointing setting into a replica.
+     */
+    void sync_replica(MLP &replica) const;
+
+    /**
+     * @brief Tree-reduce the replicas' gradients into the model's.
+     */
+    void reduce_gradients();
+
+    MLP &m_model;                        ///< The network being trained
+    std::vector<MLP> m_replicas;         ///< One private copy of the network per thread
+    std::vector<double> m_losses;        ///< Loss of each shard in the current pass
+    std::vector<double *> m_shard_grads; ///< Scratch: one span's gradient buffer in every replica
+    ThreadPool m_pool;                   ///< Workers that run the shards and the reduction
+};
+
+/**
+ * @class PipelinedTrainer
+ * @brief Training driver that updates each layer as soon as its gradients are final.
+ *
+ * A plain step runs forward, backward, the optimizer and zero_grad() one
+ * after the other. Here the reverse sweep instead hands each layer to an
+ * update thread the moment the sweep has passed the layer's last use:
+ * from then on its gradients are final and the sweep never reads its
+ * weights again, so the optimizer update and the zeroing of its gradients
+ * run while the sweep continues through the layers below it.
+ *
+ * The last layer to finish is the input layer, whose update step() does
+ * not wait for: it overlaps whatever the caller does before the next
+ * step(), typically fetching the next batch from a BatchLoader. The next
+ * step() waits for it before its forward pass reads the weights.
+ *
+ * The arithmetic is that of model.zero_grad(), forward_batch(),
+ * backward() and optimizer.step(), so the results match that loop bit
+ * for bit.
+ *
+ *     Adam adam(mlp.parameter_spans(), 1e-3);
+ *     PipelinedTrainer trainer(mlp, adam);
+ *     for (int epoch = 0; epoch < 10; ++epoch) {
+ *         trainer.run_epoch(loader);
+ *     }
+ */
+class PipelinedTrainer {
+  public:
+    /**
+     * @brief Start the update thread and clear the model's gradients.
+     * @param model The network to train. Not owned; must outlive the trainer.
+     * @param optimizer An optimizer over exactly model.parameter_spans(). Not owned.
+     * @throws std::invalid_argument if the optimizer's spans are not the model's.
+     */
+    PipelinedTrainer(MLP &model, Optimizer &optimizer);
+
+    /**
+     * @brief Finish the pending updates and stop the update thread.
+     */
+    ~PipelinedTrainer();
+
+    PipelinedTrainer(const PipelinedTrainer &) = delete;
+    PipelinedTrainer &operator=(const PipelinedTrainer &) = delete;
+
+    /**
+     * @brief Run one optimizer step on a mini-batch.
+     * @param x Row-major [batch x nin] inputs.
+     * @param y Row-major [batch x nout] targets.
+     * @param batch The number of samples.
+     * @return The summed squared-error loss before the update.
+     *
+     * Returns once the reverse sweep is done; the updates of the layers it
+     * finished last may still be running (see synchronize()).
+     */
+    double step(const double *x, const double *y, std::size_t batch);
+
+    /**
+     * @brief Run step() on every remaining batch of the loader's epoch.
+     * @param loader The batch source; it prefetches while the updates run.
+     * @return The summed loss over the epoch.
+     */
+    double run_epoch(BatchLoader &loader);
+
+    /**
+     * @brief Wait until every update of the last step has been applied.
+     * @throws Whatever the optimizer threw while updating.
+     *
+     * Call before reading the weights outside the trainer, e.g. to predict
+     * or save the model. Afterwards all gradients are zero.
+     */
+    void synchronize();
+
+  private:
+    /**
+     * @brief Queue the update of one layer.
+     */
+    void post(std::size_t layer);
+
+    /**
+     * @brief Apply queued updates until stopped.
+     */
+    void update_loop();
+
+    MLP &m_model;                        ///< The network being trained
+    Optimizer &m_optimizer;              ///< Its update rule, two spans per layer
+    std::unordered_map<const Tensor *, std::size_t> m_layer_of; ///< Layer owning each parameter tensor
+    std::vector<Tensor *> m_order;       ///< Topological order of the current step's graph
+    std::vector<std::size_t> m_last_use; ///< Per layer: lowest position in m_order using its parameters
+    std::vector<std::size_t> m_by_use;   ///< Layers by descending m_last_use, i.e. in the order they finish
+    std::vector<std::size_t> m_queue;    ///< Layers posted this step, oldest first
+    std::size_t m_queue_head;            ///< Next layer in m_queue to update
+    bool m_stop;                         ///< Asks the update thread to exit
+    bool m_busy;                         ///< The update thread is applying a layer taken from the queue
+    std::exception_ptr m_error;          ///< First failure of the update thread, rethrown by synchronize()
+    std::mutex m_mutex;                  ///< Guards the queue and the flags above
+    std::condition_variable m_changed;   ///< Signals any change of them
+    std::thread m_thread;                ///< The update thread
+};
+
+#endif // MICROGRAD_TRAINER_HPP
@@ -11,9 +11,13 @@
 #ifndef MICROGRAD_VALUE_HPP
 #define MICROGRAD_VALUE_HPP
 
-#include <functional> // For std::function
+#include "activation.hpp"
+#include "profile.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <set> // For storing previous nodes
 #include <string>
 #include <vector>
 
@@ -32,6 +36,95 @@ class Value;
  */
 using ValuePtr = std::shared_ptr<Value>;
 
+/**
+ * @enum Op
+ * @brief Operation that produced a node; selects its backward kernel
+ */
+enum class Op : std::uint8_t {
+    None,                ///< Leaf (input or parameter)
+    Const,               ///< Leaf holding a literal from a double operand, e.g. the 2.0 in x + 2.0
+    Add,                 ///< lhs + rhs
+    Mul,                 ///< lhs * rhs
+    Tanh,                ///< tanh(x)
+    Exp,                 ///< exp(x)
+    Pow,                 ///< x ^ n, with the constant exponent n stored in the node
+    Relu,                ///< max(x, 0)
+    Sigmoid,             ///< 1 / (1 + exp(-x))
+    Gelu,                ///< x * Phi(x), Phi the standard normal CDF
+    LogSumExp,           ///< log(sum exp(z_i)) over all parents
+    SoftmaxCrossEntropy, ///< -log softmax(z)_t, with the target class t stored in the node
+    SquaredError,        ///< s * sum (p_i - t_i)^2 over parents p..., t..., with the scale s stored in the node
+};
+
+/**
+ * @brief Get the printable name of an operation
+ * @param op The operation
+ * @return Short name such as "+" or "tanh"; empty for leaves
+ */
+const char *op_name(Op op);
+
+/**
+ * @class ChildList
+ * @brief Compact storage for the parents of a node
+ *
+ * Every built-in op has at most two parents, which are stored inline; ops
+ * with more parents spill into a single heap array. Parents keep operand
+ * order, so iteration is deterministic and duplicates are preserved.
+ */
+class ChildList {
+  public:
+    static constexpr std::size_t inline_capacity = 2; ///< Parents stored without allocation
+
+    ChildList() noexcept = default;
+    ChildList(ValuePtr only) noexcept;
+    ChildList(ValuePtr first, ValuePtr second) noexcept;
+    explicit ChildList(const std::vector<ValuePtr> &children);
+
+    ChildList(const ChildList &other);
+    ChildList(ChildList &&other) noexcept;
+    ChildList &operator=(ChildList other) noexcept;
+    ~ChildList() = default;
+
+    const ValuePtr *begin() const noexcept { return m_size > inline_capacity ? m_spill.get() : m_inline; }
+    const ValuePtr *end() const noexcept { return begin() + m_size; }
+    std::size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    const ValuePtr &operator[](std::size_t index) const noexcept { return begin()[index]; }
+
+    /**
+     * @brief Drop all parents
+     */
+    void clear() noexcept;
+
+    friend void swap(ChildList &a, ChildList &b) noexcept;
+
+  private:
+    ValuePtr m_inline[inline_capacity];  ///< Inline parents (size <= inline_capacity)
+    std::unique_ptr<ValuePtr[]> m_spill; ///< Spilled parents (size > inline_capacity)
+    std::uint32_t m_size = 0;            ///< Number of parents
+};
+
+/**
+ * @class ValueCounter
+ * @brief Counts live Value objects
+ *
+ * Inherited privately by Value (so it takes no space); every construction,
+ * including copies and moves, counts as a new object.
+ */
+class ValueCounter {
+  public:
+    ValueCounter() noexcept { s_live.fetch_add(1, std::memory_order_relaxed); }
+    ValueCounter(const ValueCounter &) noexcept : ValueCounter() {}
+    ValueCounter &operator=(const ValueCounter &) noexcept { return *this; }
+    ~ValueCounter() { s_live.fetch_sub(1, std::memory_order_relaxed); }
+
+    /// Number of Value objects currently alive in the process
+    static long live() noexcept { return s_live.load(std::memory_order_relaxed); }
+
+  private:
+    static std::atomic<long> s_live;
+};
+
 /**
  * @class Value
  * @brief Core computational graph node for automatic differentiation
@@ -40,22 +133,42 @@ using ValuePtr = std::shared_ptr<Value>;
  * It stores:
  * - data: The actual numerical value
  * - grad: Accumulated gradient (∂Loss/∂this_value)
- * - _backward: A function to compute the local gradient and propagate it
- * - _prev: A set of parent nodes in the graph
- * - _op: The operation that created this node
+ * - _prev: The parent nodes in the graph, in operand order
+ * - _op: The operation that created this node; backward dispatches on it
  * - label: Optional human-readable identifier
  *
+ * Data and gradient normally live inside the node, but a leaf can instead be
+ * bound to slots of an external buffer (see the binding constructor), which
+ * lets parameters be stored contiguously while keeping the ValuePtr API.
+ *
+ * Every node records whether it requires a gradient: leaves do unless
+ * told otherwise, literals (Op::Const) never do, and an op node does when
+ * any of its parents does. backward() neither visits nor accumulates into
+ * nodes that do not, so input data, constants and frozen parameters cost
+ * no backward work.
+ *
+ * Labels are only read when printing, so they are not stored in the node:
+ * a labeled Value sets a flag and keeps its string in a process-wide side
+ * table. Unlabeled nodes, i.e. almost all of them, never touch a string,
+ * and a node fits in two cache lines together with its shared_ptr control
+ * block.
  */
-class Value : public std::enable_shared_from_this<Value> {
+class Value : private ValueCounter {
   private:
-    double m_data;       ///< The actual numerical value
-    double m_grad;       ///< Accumulated gradient ∂Loss/∂this_value
-    std::string m_label; ///< Optional label for debugging
+    double *m_data;        ///< The actual numerical value (m_storage[0] or an external slot)
+    double *m_grad;        ///< Accumulated gradient ∂Loss/∂this_value (m_storage[1] or an external slot)
+    double m_storage[2];   ///< Inline data and gradient used when the Value is not bound
 
     // --- Graph-related members ---
-    std::string m_op; ///< Operation that produced this value (e.g., "+", "*")
-    std::set<ValuePtr> m_prev; ///< Set of parent nodes
-    std::function<void()> m_backward_fn; ///< Function to run for backpropagation
+    double m_aux;     ///< Op-specific constant (the exponent for Op::Pow)
+    ChildList m_prev; ///< Parent nodes, in operand order
+    std::uint64_t m_visit_epoch; ///< Epoch of the last traversal that visited this node
+    Op m_op;          ///< Operation that produced this value
+    bool m_labeled;   ///< Whether the side table holds a label for this node
+    bool m_requires_grad; ///< Whether backward() propagates into this node
+#ifdef MICROGRAD_ENABLE_PROFILING
+    std::int16_t m_profile_layer = static_cast<std::int16_t>(profile::current_layer()); ///< MLP layer that built it
+#endif
 
   public:
     /**
@@ -64,80 +177,123 @@ class Value : public std::enable_shared_from_this<Value> {
      * @param children The parent nodes of this value
      * @param op The operation that created this value
      * @param label Optional human-readable identifier
+     *
+     * The overloads without a label are the ones the operators use; they
+     * never construct a string.
+     */
+    explicit Value(double data);
+    Value(double data, const std::string &label);
+    Value(double data, ChildList children, Op op = Op::None);
+    Value(double data, ChildList children, Op op, const std::string &label);
+
+    /**
+     * @brief Construct a leaf whose data and gradient live in external storage
+     * @param data Slot holding the value; must outlive this Value
+     * @param grad Slot holding the gradient; must outlive this Value
+     * @param label Optional human-readable identifier
      */
-    explicit Value(double data, const std::string &label = "");
-    Value(double data, const std::set<ValuePtr> &children,
-          const std::string &op = "", const std::string &label = "");
+    Value(double *data, double *grad);
+    Value(double *data, double *grad, const std::string &label);
 
-    ~Value() = default;
+    /**
+     * @brief Destroy the Value, releasing its parents iteratively
+     *
+     * Parents that become unreferenced are destroyed from a loop instead of
+     * recursively, so dropping a very deep graph cannot overflow the stack.
+     */
+    ~Value();
 
     /**
      * @brief Copy constructor
      * @param other Value to copy from
      *
+     * A copy of a bound Value is bound to the same external slots.
      */
-    Value(const Value& other) = default;
+    Value(const Value& other);
 
     /**
      * @brief Copy assignment operator
      * @param other Value to copy from
      * @return Reference to this object
      */
-    Value& operator=(const Value& other) = default;
+    Value& operator=(const Value& other);
 
     /**
      * @brief Move constructor
      * @param other Value to move from
      */
-    Value(Value&& other) noexcept = default;
+    Value(Value&& other) noexcept;
 
     /**
      * @brief Move assignment operator
      * @param other Value to move from
      * @return Reference to this object
      */
-    Value& operator=(Value&& other) noexcept = default;
+    Value& operator=(Value&& other) noexcept;
 
     // ======= ACCESSORS =======
     /**
      * @brief Get the stored data value
      * @return The numerical data
      */
-    double data() const;
+    double data() const { return *m_data; }
 
     /**
      * @brief Get the accumulated gradient
      * @return The gradient value ∂Loss/∂this_value
      */
-    double grad() const;
-    const std::set<ValuePtr>& prev() const;
-    const std::string& op() const;
+    double grad() const { return *m_grad; }
+
+    /**
+     * @brief Get the parent nodes
+     * @return The parents in operand order; duplicates (e.g. in x * x) are kept
+     */
+    const ChildList& prev() const { return m_prev; }
+
+    /**
+     * @brief Get the operation that produced this Value
+     * @return The opcode; Op::None or Op::Const for leaves
+     */
+    Op op() const { return m_op; }
 
     /**
      * @brief Get the label
-     * @return const reference to the label string
+     * @return const reference to the label string, empty if none; valid
+     *         until the label is changed or the Value is destroyed
      */
     const std::string& label() const;
 
+    /**
+     * @brief Check whether backward() computes a gradient for this Value
+     * @return false for literals and for nodes built only from such Values
+     */
+    bool requires_grad() const { return m_requires_grad; }
+
+    /**
+     * @brief Check whether data and gradient live in external storage
+     * @return true for Values created with the binding constructor
+     */
+    bool is_bound() const { return m_data != m_storage; }
+
     // ======= MUTATORS =======
 
     /**
      * @brief Set the data value
      * @param data New data value to store
      */
-    void set_data(double data);
+    void set_data(double data) { *m_data = data; }
 
     /**
      * @brief Set the gradient value
      * @param grad New gradient value
      */
-    void set_grad(double grad);
+    void set_grad(double grad) { *m_grad = grad; }
 
     /**
      * @brief Add to the current gradient (accumulation)
      * @param grad_increment Value to add to current gradient
      */
-    void add_to_grad(double grad_increment);
+    void add_to_grad(double grad_increment) { *m_grad += grad_increment; }
 
     /**
      * @brief Reset gradient to zero
@@ -146,14 +302,24 @@ class Value : public std::enable_shared_from_this<Value> {
      * so they must be zeroed before each backward pass.
      * Otherwise gradients from previous iterations will interfere.
      */
-    void zero_grad();
+    void zero_grad() { *m_grad = 0.0; }
 
     /**
      * @brief Set the label
-     * @param label New label string
+     * @param label New label string; an empty string removes the label
      */
     void set_label(const std::string& label);
 
+    /**
+     * @brief Mark a leaf as differentiable or not, e.g. to freeze a parameter
+     * @param requires_grad false to exclude the leaf from backward()
+     * @throws std::invalid_argument for an op node, whose flag follows its parents
+     *
+     * Op nodes read their parents' flags when they are built, so the change
+     * applies to graphs built afterwards.
+     */
+    void set_requires_grad(bool requires_grad);
+
     // ======== BACKPROPAGATION ========
     /**
      * @brief Perform backpropagation from this Value
@@ -163,7 +329,83 @@ class Value : public std::enable_shared_from_this<Value> {
      */
     void backward();
 
+    /**
+     * @brief Backpropagate using a previously built topological order
+     * @param order Ordering produced by build_topo() on this Value
+     *
+     * Lets a caller cache the ordering and reuse it across backward passes
+     * as long as the graph shape has not changed. Node data may change in
+     * between; adding or removing nodes invalidates the order.
+     */
+    void backward(const std::vector<Value *> &order);
+
+    /**
+     * @brief Build a topological order of the graph rooted at this Value
+     * @param order Output vector, cleared first; children precede parents
+     *              and this Value is the last element
+     * @param grad_only Leave out the nodes that do not require a gradient,
+     *                  which is all backward() needs; by default every node
+     *                  is included, as replaying the forward pass requires
+     *
+     * Uses an explicit stack and per-node visit epochs instead of recursion
+     * and a visited set, so it works on arbitrarily deep graphs and does not
+     * allocate once the vectors have grown. Concurrent traversals of graphs
+     * that share nodes are not supported.
+     */
+    void build_topo(std::vector<Value *> &order, bool grad_only = false);
+
+  private:
+    /**
+     * @brief Point m_data/m_grad at other's external slots, or at our own storage
+     * @param other The Value being copied or moved from
+     */
+    void bind_like(const Value &other) noexcept;
+
+    /**
+     * @brief Drop this node's entry from the label side table, if any
+     */
+    void clear_label() noexcept;
+
+    /**
+     * @brief Move other's label, if any, to this node (this must have none)
+     * @param other The Value being moved from
+     */
+    void take_label(Value &other) noexcept;
+
+    /**
+     * @brief Hand out a fresh visit epoch for a traversal over m_visit_epoch
+     * @return An epoch no node has been stamped with yet
+     */
+    static std::uint64_t next_visit_epoch() noexcept;
+
+    /**
+     * @brief Propagate this node's gradient to its parents
+     *
+     * Dispatches on m_op; leaves, and nodes that do not require a
+     * gradient, do nothing.
+     */
+    void backward_step();
+
+    /**
+     * @brief Add to a parent's gradient unless the parent does not require one
+     */
+    static void accumulate(Value &parent, double grad) {
+        if (parent.m_requires_grad) {
+            *parent.m_grad += grad;
+        }
+    }
+
+  public:
+
     // ======== UTILITY METHODS ========
+    /**
+     * @brief Get the number of Value objects currently alive
+     * @return Live object count across the whole process
+     *
+     * Useful for checking that a graph is released once its root goes out of scope.
+     */
+    static long live_count();
+
     void print() const;
 
     /**
@@ -176,14 +418,23 @@ class Value : public std::enable_shared_from_this<Value> {
     friend ValuePtr tanh(const ValuePtr &v);
     friend ValuePtr exp(const ValuePtr &v);
     friend ValuePtr pow(const ValuePtr &base, double exp);
+    friend ValuePtr softmax_cross_entropy(const std::vector<ValuePtr> &logits, std::size_t target);
+    friend ValuePtr squared_error(const std::vector<ValuePtr> &predictions, const std::vector<ValuePtr> &targets,
+                                  double scale);
     friend ValuePtr operator+(const ValuePtr &lhs, const ValuePtr &rhs);
     friend ValuePtr operator*(const ValuePtr &lhs, const ValuePtr &rhs);
+
+    friend class Tape;
+    friend class CompiledGraph;
+    friend class Differentiator;
 };
 
 // ======== FACTORY FUNCTIONS =========
-ValuePtr make_value(double data, const std::string &label = "");
-ValuePtr make_value(double data, const std::set<ValuePtr> &children,
-                    const std::string &op = "", const std::string &label = "");
+// While a TapeScope is active these record into the thread's Tape (see tape.hpp)
+ValuePtr make_value(double data);
+ValuePtr make_value(double data, const std::string &label);
+ValuePtr make_value(double data, ChildList children, Op op = Op::None);
+ValuePtr make_value(double data, ChildList children, Op op, const std::string &label);
 
 // ======== OPERATOR OVERLOADS ========
 ValuePtr operator-(const ValuePtr &lhs, const ValuePtr &rhs);
@@ -199,5 +450,44 @@ ValuePtr operator-(const ValuePtr &lhs, double rhs);
 ValuePtr operator-(double lhs, const ValuePtr &rhs);
 ValuePtr operator/(const ValuePtr &lhs, double rhs);
 
+// ======== MORE ACTIVATION FUNCTIONS ========
+ValuePtr relu(const ValuePtr &v);
+ValuePtr sigmoid(const ValuePtr &v);
+ValuePtr gelu(const ValuePtr &v); // Exact (erf) form
+
+/**
+ * @brief Apply a layer activation; Linear returns v itself without a node
+ */
+ValuePtr activate(const ValuePtr &v, Activation act);
+
+// ======== FUSED LOSSES ========
+// Each builds a single node whose backward is closed-form, instead of a
+// subgraph of scalar ops.
+
+/**
+ * @brief log(sum_i exp(z_i)), computed with the maximum factored out
+ * @throws std::invalid_argument if z is empty
+ */
+ValuePtr logsumexp(const std::vector<ValuePtr> &z);
+
+/**
+ * @brief Cross-entropy of softmax(logits) against a class index
+ * @return logsumexp(logits) - logits[target]; the gradient is softmax - onehot
+ * @throws std::invalid_argument if logits is empty or target is out of range
+ */
+ValuePtr softmax_cross_entropy(const std::vector<ValuePtr> &logits, std::size_t target);
+
+/**
+ * @brief scale * sum_i (predictions[i] - targets[i])^2
+ * @throws std::invalid_argument if the sizes differ or are zero
+ */
+ValuePtr squared_error(const std::vector<ValuePtr> &predictions, const std::vector<ValuePtr> &targets,
+                       double scale = 1.0);
+
+/**
+ * @brief Mean squared error, squared_error() scaled by 1 / n
+ */
+ValuePtr mse(const std::vector<ValuePtr> &predictions, const std::vector<ValuePtr> &targets);
+ValuePtr mse(const std::vector<ValuePtr> &predictions, const std::vector<double> &targets); // Constant targets
 
 #endif // MICROGRAD_VALUE_HPP
\ No newline at end of file
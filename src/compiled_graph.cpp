@@ -0,0 +1,667 @@
+/**
+ * @file compiled_graph.cpp
+ * @brief Implementation of the CompiledGraph and its optimization passes
+ */
+
+#include "micrograd/compiled_graph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+constexpr std::uint32_t kNoSlot = CompiledGraph::kNoSlot;
+constexpr std::size_t kNoProducer = static_cast<std::size_t>(-1);
+
+InstrOp lower(Op op)
+{
+    switch (op)
+    {
+    case Op::Add:
+        return InstrOp::Add;
+    case Op::Mul:
+        return InstrOp::Mul;
+    case Op::Tanh:
+        return InstrOp::Tanh;
+    case Op::Exp:
+        return InstrOp::Exp;
+    case Op::Pow:
+        return InstrOp::Pow;
+    case Op::Relu:
+        return InstrOp::Relu;
+    case Op::Sigmoid:
+        return InstrOp::Sigmoid;
+    case Op::Gelu:
+        return InstrOp::Gelu;
+    case Op::LogSumExp:
+    case Op::SoftmaxCrossEntropy:
+    case Op::SquaredError:
+        throw std::invalid_argument("CompiledGraph: fused loss nodes are not supported; compile the network output");
+    case Op::None:
+    case Op::Const:
+        break;
+    }
+    throw std::invalid_argument("CompiledGraph: leaf has no instruction");
+}
+
+bool is_binary(InstrOp op)
+{
+    return op == InstrOp::Add || op == InstrOp::Mul || op == InstrOp::AddTanh;
+}
+
+bool is_dot(InstrOp op)
+{
+    return op == InstrOp::Dot || op == InstrOp::DotTanh;
+}
+
+/// Value of a Dot-style instruction before its activation
+double dot_value(const Instruction &ins, const double *D, const std::uint32_t *pairs)
+{
+    double acc = ins.c == kNoSlot ? 0.0 : D[ins.c];
+    for (std::uint32_t k = 0; k < ins.b; ++k)
+    {
+        acc += D[pairs[2 * k]] * D[pairs[2 * k + 1]];
+    }
+    return acc;
+}
+
+/// Evaluate one instruction in place
+void execute(const Instruction &ins, double *D, const std::uint32_t *operands)
+{
+    switch (ins.op)
+    {
+    case InstrOp::Add:
+        D[ins.out] = D[ins.a] + D[ins.b];
+        break;
+    case InstrOp::Mul:
+        D[ins.out] = D[ins.a] * D[ins.b];
+        break;
+    case InstrOp::Tanh:
+        D[ins.out] = std::tanh(D[ins.a]);
+        break;
+    case InstrOp::Exp:
+        D[ins.out] = std::exp(D[ins.a]);
+        break;
+    case InstrOp::Pow:
+        D[ins.out] = std::pow(D[ins.a], ins.aux);
+        break;
+    case InstrOp::AddConst:
+        D[ins.out] = D[ins.a] + ins.aux;
+        break;
+    case InstrOp::MulConst:
+        D[ins.out] = D[ins.a] * ins.aux;
+        break;
+    case InstrOp::Fma:
+        D[ins.out] = D[ins.c] + D[ins.a] * D[ins.b];
+        break;
+    case InstrOp::Dot:
+        D[ins.out] = dot_value(ins, D, operands + ins.a);
+        break;
+    case InstrOp::AddTanh:
+        D[ins.out] = std::tanh(D[ins.a] + D[ins.b]);
+        break;
+    case InstrOp::DotTanh:
+        D[ins.out] = std::tanh(dot_value(ins, D, operands + ins.a));
+        break;
+    case InstrOp::Relu:
+        D[ins.out] = activation::apply(Activation::Relu, D[ins.a]);
+        break;
+    case InstrOp::Sigmoid:
+        D[ins.out] = activation::sigmoid(D[ins.a]);
+        break;
+    case InstrOp::Gelu:
+        D[ins.out] = activation::gelu(D[ins.a]);
+        break;
+    }
+}
+
+/// Slots read by an instruction, passed one by one to fn
+template <typename Fn>
+void for_each_operand(const Instruction &ins, const std::uint32_t *operands, Fn fn)
+{
+    switch (ins.op)
+    {
+    case InstrOp::Dot:
+    case InstrOp::DotTanh:
+        for (std::uint32_t k = 0; k < 2 * ins.b; ++k)
+        {
+            fn(operands[ins.a + k]);
+        }
+        if (ins.c != kNoSlot)
+        {
+            fn(ins.c);
+        }
+        break;
+    case InstrOp::Fma:
+        fn(ins.a);
+        fn(ins.b);
+        fn(ins.c);
+        break;
+    default:
+        fn(ins.a);
+        if (is_binary(ins.op))
+        {
+            fn(ins.b);
+        }
+        break;
+    }
+}
+
+/// An instruction under construction by the fusion pass; Dot operand pairs
+/// live here until the schedule is emitted
+struct FusionNode
+{
+    Instruction ins;
+    std::vector<std::uint32_t> pairs;
+    bool alive;
+};
+} // namespace
+
+// ======== COMPILATION ========
+CompiledGraph::CompiledGraph(const ValuePtr &root, const std::vector<ValuePtr> &inputs)
+{
+    std::vector<Value *> order;
+    root->build_topo(order);
+
+    // build_topo yields raw pointers; the edges pointing at each node carry
+    // its ownership (including the aliasing owner of block-bound parameters)
+    std::unordered_map<const Value *, ValuePtr> edge_to;
+    edge_to.emplace(root.get(), root);
+    for (Value *node : order)
+    {
+        for (const ValuePtr &child : node->prev())
+        {
+            edge_to.emplace(child.get(), child);
+        }
+    }
+
+    // Inputs take the first slots so set_inputs() writes a contiguous prefix
+    std::unordered_map<const Value *, std::uint32_t> slot_of;
+    slot_of.reserve(order.size() + inputs.size());
+    for (const auto &input : inputs)
+    {
+        if (!input->prev().empty())
+        {
+            throw std::invalid_argument("CompiledGraph: inputs must be leaves");
+        }
+        const auto slot = static_cast<std::uint32_t>(m_input_slots.size());
+        if (!slot_of.emplace(input.get(), slot).second)
+        {
+            throw std::invalid_argument("CompiledGraph: input listed twice");
+        }
+        m_input_slots.push_back(slot);
+    }
+
+    std::uint32_t next = static_cast<std::uint32_t>(inputs.size());
+    std::vector<std::pair<std::uint32_t, double>> constants;
+    for (Value *node : order)
+    {
+        if (slot_of.count(node))
+        {
+            continue; // A declared input
+        }
+        const std::uint32_t slot = next++;
+        slot_of.emplace(node, slot);
+        if (node->op() == Op::Const)
+        {
+            constants.emplace_back(slot, node->data());
+            continue;
+        }
+        if (node->op() == Op::None)
+        {
+            m_leaves.push_back(edge_to.at(node));
+            m_leaf_slots.push_back(slot);
+            continue;
+        }
+        Instruction ins{lower(node->op()), slot, slot_of.at(node->prev()[0].get()), 0, kNoSlot, node->m_aux};
+        if (node->prev().size() > 1)
+        {
+            ins.b = slot_of.at(node->prev()[1].get());
+        }
+        m_code.push_back(ins);
+    }
+
+    m_root = slot_of.at(root.get());
+    m_data.assign(next, 0.0);
+    m_grad.assign(next, 0.0);
+    m_constant.assign(next, 0);
+    for (const auto &constant : constants)
+    {
+        m_data[constant.first] = constant.second;
+        m_constant[constant.first] = 1;
+    }
+}
+
+// ======== OPTIMIZATION PASSES ========
+OptimizeStats CompiledGraph::optimize()
+{
+    OptimizeStats stats{m_code.size(), 0, m_data.size(), 0};
+    fold_constants();
+    fuse();
+    eliminate_dead();
+    stats.instructions_after = m_code.size();
+    stats.slots_after = m_data.size();
+    return stats;
+}
+
+void CompiledGraph::fold_constants()
+{
+    std::vector<Instruction> code;
+    code.reserve(m_code.size());
+    for (Instruction ins : m_code)
+    {
+        if (ins.op == InstrOp::Add || ins.op == InstrOp::Mul)
+        {
+            const bool ca = m_constant[ins.a], cb = m_constant[ins.b];
+            if (ca != cb)
+            {
+                // One literal operand becomes an immediate
+                const std::uint32_t var = ca ? ins.b : ins.a;
+                const double k = m_data[ca ? ins.a : ins.b];
+                ins = {ins.op == InstrOp::Add ? InstrOp::AddConst : InstrOp::MulConst, ins.out, var, 0, kNoSlot, k};
+            }
+        }
+
+        bool all_constant = true;
+        for_each_operand(ins, m_operands.data(), [&](std::uint32_t s) { all_constant = all_constant && m_constant[s]; });
+        if (all_constant)
+        {
+            execute(ins, m_data.data(), m_operands.data());
+            m_constant[ins.out] = 1;
+            continue;
+        }
+        code.push_back(ins);
+    }
+    m_code.swap(code);
+}
+
+void CompiledGraph::fuse()
+{
+    std::vector<std::uint32_t> uses(m_data.size(), 0);
+    for (const Instruction &ins : m_code)
+    {
+        for_each_operand(ins, m_operands.data(), [&](std::uint32_t s) { ++uses[s]; });
+    }
+    ++uses[m_root];
+
+    std::vector<FusionNode> nodes;
+    nodes.reserve(m_code.size());
+    std::vector<std::size_t> producer(m_data.size(), kNoProducer);
+
+    // The live node producing slot s if its only consumer is the current instruction
+    auto sole = [&](std::uint32_t s) -> FusionNode * {
+        const std::size_t p = producer[s];
+        return uses[s] == 1 && p != kNoProducer && nodes[p].alive ? &nodes[p] : nullptr;
+    };
+    auto emit = [&](FusionNode node) {
+        producer[node.ins.out] = nodes.size();
+        nodes.push_back(std::move(node));
+    };
+    // Re-emit a Dot at the current position, consumed into slot out
+    auto move_dot = [&](FusionNode *dot, InstrOp op, std::uint32_t out) {
+        FusionNode moved{dot->ins, std::move(dot->pairs), true};
+        dot->alive = false;
+        moved.ins.op = op;
+        moved.ins.out = out;
+        return moved;
+    };
+
+    for (const Instruction &ins : m_code)
+    {
+        if (ins.op == InstrOp::Add)
+        {
+            FusionNode *dot = nullptr, *mul = nullptr;
+            std::uint32_t other = kNoSlot;
+            for (int side = 0; side < 2; ++side)
+            {
+                const std::uint32_t x = side == 0 ? ins.a : ins.b, y = side == 0 ? ins.b : ins.a;
+                FusionNode *px = sole(x);
+                if (px && px->ins.op == InstrOp::Dot && !dot)
+                {
+                    dot = px;
+                    other = y;
+                }
+                else if (px && px->ins.op == InstrOp::Mul && !mul)
+                {
+                    mul = px;
+                }
+            }
+
+            if (dot && (mul || dot->ins.c == kNoSlot))
+            {
+                // Extend an existing weighted sum by one term, or give it its addend
+                FusionNode grown = move_dot(dot, InstrOp::Dot, ins.out);
+                if (mul && mul->ins.out == other)
+                {
+                    grown.pairs.push_back(mul->ins.a);
+                    grown.pairs.push_back(mul->ins.b);
+                    mul->alive = false;
+                }
+                else
+                {
+                    grown.ins.c = other;
+                }
+                emit(std::move(grown));
+                continue;
+            }
+            if (mul)
+            {
+                // Start a weighted sum: product plus addend (or plus another product)
+                FusionNode fused{{InstrOp::Dot, ins.out, 0, 0, kNoSlot, 0.0}, {mul->ins.a, mul->ins.b}, true};
+                mul->alive = false;
+                const std::uint32_t addend = mul->ins.out == ins.a ? ins.b : ins.a;
+                FusionNode *second = sole(addend);
+                if (second && second->ins.op == InstrOp::Mul && second != mul)
+                {
+                    fused.pairs.push_back(second->ins.a);
+                    fused.pairs.push_back(second->ins.b);
+                    second->alive = false;
+                }
+                else
+                {
+                    fused.ins.c = addend;
+                }
+                emit(std::move(fused));
+                continue;
+            }
+        }
+        else if (ins.op == InstrOp::Tanh)
+        {
+            FusionNode *arg = sole(ins.a);
+            if (arg && arg->ins.op == InstrOp::Add)
+            {
+                arg->alive = false;
+                emit({{InstrOp::AddTanh, ins.out, arg->ins.a, arg->ins.b, kNoSlot, 0.0}, {}, true});
+                continue;
+            }
+            if (arg && arg->ins.op == InstrOp::Dot)
+            {
+                emit(move_dot(arg, InstrOp::DotTanh, ins.out));
+                continue;
+            }
+        }
+        FusionNode node{ins, {}, true};
+        if (is_dot(ins.op))
+        {
+            // Fused by an earlier optimize(): unpack its pairs so re-emitting keeps them
+            const std::uint32_t *pairs = m_operands.data() + ins.a;
+            node.pairs.assign(pairs, pairs + 2 * ins.b);
+        }
+        emit(std::move(node));
+    }
+
+    // Emit the surviving nodes; Dot pairs are packed into m_operands
+    std::vector<Instruction> code;
+    std::vector<std::uint32_t> operands;
+    for (FusionNode &node : nodes)
+    {
+        if (!node.alive)
+        {
+            continue;
+        }
+        Instruction ins = node.ins;
+        if (is_dot(ins.op))
+        {
+            if (ins.op == InstrOp::Dot && node.pairs.size() == 2 && ins.c != kNoSlot)
+            {
+                ins = {InstrOp::Fma, ins.out, node.pairs[0], node.pairs[1], ins.c, 0.0};
+            }
+            else
+            {
+                ins.a = static_cast<std::uint32_t>(operands.size());
+                ins.b = static_cast<std::uint32_t>(node.pairs.size() / 2);
+                operands.insert(operands.end(), node.pairs.begin(), node.pairs.end());
+            }
+        }
+        code.push_back(ins);
+    }
+    m_code.swap(code);
+    m_operands.swap(operands);
+}
+
+void CompiledGraph::eliminate_dead()
+{
+    // Liveness from the root, sweeping the schedule backwards
+    std::vector<std::uint8_t> live(m_data.size(), 0);
+    live[m_root] = 1;
+    std::vector<std::uint8_t> keep(m_code.size(), 0);
+    for (std::size_t i = m_code.size(); i-- > 0;)
+    {
+        if (live[m_code[i].out])
+        {
+            keep[i] = 1;
+            for_each_operand(m_code[i], m_operands.data(), [&](std::uint32_t s) { live[s] = 1; });
+        }
+    }
+
+    // Renumber densely: inputs first (their positions are part of the API),
+    // then leaves, constants and instruction results in order of use
+    std::vector<std::uint32_t> remap(m_data.size(), kNoSlot);
+    std::uint32_t next = 0;
+    for (std::uint32_t s : m_input_slots)
+    {
+        remap[s] = next++;
+    }
+    auto assign = [&](std::uint32_t s) {
+        if (remap[s] == kNoSlot)
+        {
+            remap[s] = next++;
+        }
+    };
+
+    std::vector<ValuePtr> leaves;
+    std::vector<std::uint32_t> leaf_slots;
+    for (std::size_t i = 0; i < m_leaves.size(); ++i)
+    {
+        if (live[m_leaf_slots[i]])
+        {
+            assign(m_leaf_slots[i]);
+            leaves.push_back(std::move(m_leaves[i]));
+            leaf_slots.push_back(remap[m_leaf_slots[i]]);
+        }
+    }
+
+    std::vector<Instruction> code;
+    std::vector<std::uint32_t> operands;
+    for (std::size_t i = 0; i < m_code.size(); ++i)
+    {
+        if (!keep[i])
+        {
+            continue;
+        }
+        Instruction ins = m_code[i];
+        for_each_operand(ins, m_operands.data(), assign);
+        assign(ins.out);
+        ins.out = remap[ins.out];
+        if (is_dot(ins.op))
+        {
+            const std::uint32_t offset = static_cast<std::uint32_t>(operands.size());
+            for (std::uint32_t k = 0; k < 2 * ins.b; ++k)
+            {
+                operands.push_back(remap[m_operands[ins.a + k]]);
+            }
+            ins.a = offset;
+        }
+        else
+        {
+            ins.a = remap[ins.a];
+            if (is_binary(ins.op) || ins.op == InstrOp::Fma)
+            {
+                ins.b = remap[ins.b];
+            }
+        }
+        if (ins.c != kNoSlot)
+        {
+            ins.c = remap[ins.c];
+        }
+        code.push_back(ins);
+    }
+    assign(m_root); // A root that folded to a constant or is a leaf
+
+    std::vector<double> data(next, 0.0);
+    std::vector<std::uint8_t> constant(next, 0);
+    for (std::size_t s = 0; s < remap.size(); ++s)
+    {
+        if (remap[s] != kNoSlot && m_constant[s])
+        {
+            data[remap[s]] = m_data[s];
+            constant[remap[s]] = 1;
+        }
+    }
+    // Keep inputs set before optimize(); leaf and result slots are refreshed by forward()
+    for (std::uint32_t s : m_input_slots)
+    {
+        data[remap[s]] = m_data[s];
+    }
+
+    m_code.swap(code);
+    m_operands.swap(operands);
+    m_leaves.swap(leaves);
+    m_leaf_slots.swap(leaf_slots);
+    m_data.swap(data);
+    m_constant.swap(constant);
+    m_grad.assign(next, 0.0);
+    m_root = remap[m_root];
+}
+
+// ======== INPUTS ========
+void CompiledGraph::set_input(std::size_t index, double value)
+{
+    m_data[m_input_slots.at(index)] = value;
+}
+
+void CompiledGraph::set_inputs(const double *values)
+{
+    std::copy(values, values + m_input_slots.size(), m_data.begin());
+}
+
+// ======== REPLAY ========
+double CompiledGraph::forward()
+{
+    for (std::size_t i = 0; i < m_leaves.size(); ++i)
+    {
+        m_data[m_leaf_slots[i]] = m_leaves[i]->data();
+    }
+
+    double *D = m_data.data();
+    const std::uint32_t *operands = m_operands.data();
+    for (const Instruction &ins : m_code)
+    {
+        execute(ins, D, operands);
+    }
+    return D[m_root];
+}
+
+void CompiledGraph::backward()
+{
+    std::fill(m_grad.begin(), m_grad.end(), 0.0);
+    m_grad[m_root] = 1.0;
+
+    // Same chain rules as Value::backward_step, over slots
+    const double *D = m_data.data();
+    double *G = m_grad.data();
+    const std::uint32_t *operands = m_operands.data();
+    for (auto it = m_code.rbegin(); it != m_code.rend(); ++it)
+    {
+        const Instruction &ins = *it;
+        double g = G[ins.out];
+        switch (ins.op)
+        {
+        case InstrOp::Add:
+            G[ins.a] += g;
+            G[ins.b] += g;
+            break;
+        case InstrOp::Mul:
+            G[ins.a] += D[ins.b] * g;
+            G[ins.b] += D[ins.a] * g;
+            break;
+        case InstrOp::Tanh:
+            G[ins.a] += (1 - D[ins.out] * D[ins.out]) * g;
+            break;
+        case InstrOp::Exp:
+            G[ins.a] += D[ins.out] * g;
+            break;
+        case InstrOp::Pow:
+            G[ins.a] += (ins.aux * std::pow(D[ins.a], ins.aux - 1)) * g;
+            break;
+        case InstrOp::Relu:
+            G[ins.a] += D[ins.out] > 0.0 ? g : 0.0;
+            break;
+        case InstrOp::Sigmoid:
+            G[ins.a] += D[ins.out] * (1.0 - D[ins.out]) * g;
+            break;
+        case InstrOp::Gelu:
+            G[ins.a] += activation::gelu_grad(D[ins.a]) * g;
+            break;
+        case InstrOp::AddConst:
+            G[ins.a] += g;
+            break;
+        case InstrOp::MulConst:
+            G[ins.a] += ins.aux * g;
+            break;
+        case InstrOp::Fma:
+            G[ins.a] += D[ins.b] * g;
+            G[ins.b] += D[ins.a] * g;
+            G[ins.c] += g;
+            break;
+        case InstrOp::AddTanh:
+            g *= 1 - D[ins.out] * D[ins.out];
+            G[ins.a] += g;
+            G[ins.b] += g;
+            break;
+        case InstrOp::DotTanh:
+            g *= 1 - D[ins.out] * D[ins.out];
+            [[fallthrough]];
+        case InstrOp::Dot:
+        {
+            const std::uint32_t *pairs = operands + ins.a;
+            for (std::uint32_t k = 0; k < ins.b; ++k)
+            {
+                G[pairs[2 * k]] += D[pairs[2 * k + 1]] * g;
+                G[pairs[2 * k + 1]] += D[pairs[2 * k]] * g;
+            }
+            if (ins.c != kNoSlot)
+            {
+                G[ins.c] += g;
+            }
+            break;
+        }
+        }
+    }
+
+    for (std::size_t i = 0; i < m_leaves.size(); ++i)
+    {
+        if (m_leaves[i]->requires_grad())
+        {
+            m_leaves[i]->add_to_grad(G[m_leaf_slots[i]]);
+        }
+    }
+}
+
+// ======== ACCESSORS ========
+double CompiledGraph::value() const
+{
+    return m_data[m_root];
+}
+
+double CompiledGraph::input_grad(std::size_t index) const
+{
+    return m_grad[m_input_slots.at(index)];
+}
+
+std::size_t CompiledGraph::num_inputs() const
+{
+    return m_input_slots.size();
+}
+
+std::size_t CompiledGraph::num_slots() const
+{
+    return m_data.size();
+}
+
+const std::vector<Instruction> &CompiledGraph::instructions() const
+{
+    return m_code;
+}
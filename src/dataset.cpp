@@ -0,0 +1,220 @@
+#include "micrograd/dataset.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+// ======== DATASET ========
+Dataset::Dataset(std::size_t nin, std::size_t nout) : m_nin(nin), m_nout(nout) {}
+
+std::size_t Dataset::nin() const {
+    return m_nin;
+}
+
+std::size_t Dataset::nout() const {
+    return m_nout;
+}
+
+// ======== CSV ========
+CsvDataset::CsvDataset(const std::string &path, std::size_t nin, std::size_t nout)
+    : Dataset(nin, nout), m_path(path), m_in(path), m_line_no(0) {
+    if (!m_in) {
+        throw std::runtime_error("CsvDataset: cannot open " + path);
+    }
+}
+
+std::size_t CsvDataset::read(double *x, double *y, std::size_t count) {
+    std::size_t n = 0;
+    while (n < count && std::getline(m_in, m_line)) {
+        ++m_line_no;
+        const char *p = m_line.c_str();
+        while (*p == ' ' || *p == '\t' || *p == '\r') {
+            ++p;
+        }
+        if (*p == '\0') {
+            continue;
+        }
+        const std::size_t fields = m_nin + m_nout;
+        for (std::size_t k = 0; k < fields; ++k) {
+            char *end;
+            errno = 0;
+            const double v = std::strtod(p, &end);
+            if (end == p || errno == ERANGE) {
+                fail("expected " + std::to_string(fields) + " numbers");
+            }
+            (k < m_nin ? x[n * m_nin + k] : y[n * m_nout + k - m_nin]) = v;
+            p = end;
+            while (*p == ' ' || *p == '\t' || *p == '\r') {
+                ++p;
+            }
+            if (k + 1 < fields) {
+                if (*p != ',') {
+                    fail("expected " + std::to_string(fields) + " comma-separated numbers");
+                }
+                ++p;
+            }
+        }
+        if (*p != '\0') {
+            fail("trailing data");
+        }
+        ++n;
+    }
+    return n;
+}
+
+void CsvDataset::fail(const std::string &what) const {
+    throw std::runtime_error("CsvDataset: " + m_path + ":" + std::to_string(m_line_no) + ": " + what);
+}
+
+void CsvDataset::rewind() {
+    m_in.clear();
+    m_in.seekg(0);
+    m_line_no = 0;
+}
+
+// ======== BINARY ========
+BinaryDataset::BinaryDataset(const std::string &path, std::size_t nin, std::size_t nout)
+    : Dataset(nin, nout), m_in(path, std::ios::binary | std::ios::ate) {
+    if (!m_in) {
+        throw std::runtime_error("BinaryDataset: cannot open " + path);
+    }
+    const auto bytes = static_cast<std::size_t>(m_in.tellg());
+    if (bytes % ((nin + nout) * sizeof(double)) != 0) {
+        throw std::runtime_error("BinaryDataset: " + path + " is not a whole number of records");
+    }
+    m_in.seekg(0);
+}
+
+std::size_t BinaryDataset::read(double *x, double *y, std::size_t count) {
+    // One block read for the whole batch, then split the records into x and y
+    const std::size_t record = m_nin + m_nout;
+    m_records.resize(count * record);
+    m_in.read(reinterpret_cast<char *>(m_records.data()),
+              static_cast<std::streamsize>(m_records.size() * sizeof(double)));
+    const std::size_t n = static_cast<std::size_t>(m_in.gcount()) / (record * sizeof(double));
+    for (std::size_t i = 0; i < n; ++i) {
+        const double *r = m_records.data() + i * record;
+        std::copy(r, r + m_nin, x + i * m_nin);
+        std::copy(r + m_nin, r + record, y + i * m_nout);
+    }
+    return n;
+}
+
+void BinaryDataset::rewind() {
+    m_in.clear();
+    m_in.seekg(0);
+}
+
+// ======== BATCH LOADER ========
+BatchLoader::BatchLoader(std::unique_ptr<Dataset> dataset, std::size_t batch_size)
+    : m_dataset(std::move(dataset)), m_batch_size(batch_size), m_next_slot(0), m_held_slot(-1), m_exhausted(false),
+      m_stop(false) {
+    if (batch_size == 0) {
+        throw std::invalid_argument("BatchLoader: batch_size must be positive");
+    }
+    for (Slot &slot : m_slots) {
+        slot.x.resize(batch_size * m_dataset->nin());
+        slot.y.resize(batch_size * m_dataset->nout());
+    }
+    start();
+}
+
+BatchLoader::~BatchLoader() {
+    stop();
+}
+
+void BatchLoader::start() {
+    m_next_slot = 0;
+    m_held_slot = -1;
+    m_exhausted = false;
+    m_stop = false;
+    m_error = nullptr;
+    for (Slot &slot : m_slots) {
+        slot.ready = false;
+    }
+    m_thread = std::thread(&BatchLoader::produce, this);
+}
+
+void BatchLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void BatchLoader::reset() {
+    stop();
+    m_dataset->rewind();
+    start();
+}
+
+void BatchLoader::produce() {
+    for (std::size_t index = 0;; index ^= 1) {
+        Slot &slot = m_slots[index];
+        {
+            // Wait until the consumer has both taken and released this slot
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [&] { return m_stop || (!slot.ready && m_held_slot != static_cast<int>(index)); });
+            if (m_stop) {
+                return;
+            }
+        }
+
+        std::size_t n = 0;
+        std::exception_ptr error;
+        try {
+            n = m_dataset->read(slot.x.data(), slot.y.data(), m_batch_size);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (n > 0 && !error) {
+                slot.batch = {slot.x.data(), slot.y.data(), n};
+                slot.ready = true;
+            }
+            m_error = error;
+            m_exhausted = error || n < m_batch_size;
+        }
+        m_changed.notify_all();
+        if (error || n < m_batch_size) {
+            return;
+        }
+    }
+}
+
+const Batch *BatchLoader::next() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_held_slot >= 0) {
+        m_held_slot = -1; // The previous batch is released to the loader thread
+        m_changed.notify_all();
+    }
+    Slot &slot = m_slots[m_next_slot];
+    m_changed.wait(lock, [&] { return slot.ready || m_exhausted; });
+    if (!slot.ready) {
+        if (m_error) {
+            std::exception_ptr error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+        return nullptr;
+    }
+    slot.ready = false;
+    m_held_slot = static_cast<int>(m_next_slot);
+    m_next_slot ^= 1;
+    return &slot.batch;
+}
+
+std::size_t BatchLoader::batch_size() const {
+    return m_batch_size;
+}
+
+const Dataset &BatchLoader::dataset() const {
+    return *m_dataset;
+}
@@ -0,0 +1,399 @@
+/**
+ * @file derivatives.cpp
+ * @brief Implementation of the Differentiator
+ */
+
+#include "micrograd/derivatives.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+constexpr std::uint32_t kAbsent = 0xffffffffu;
+
+/// A value and its derivative along one direction
+struct Dual
+{
+    double v;
+    double d;
+    Dual(double value = 0.0, double tangent = 0.0) : v(value), d(tangent) {}
+};
+
+Dual operator+(Dual a, Dual b) { return {a.v + b.v, a.d + b.d}; }
+Dual operator-(Dual a, Dual b) { return {a.v - b.v, a.d - b.d}; }
+Dual operator*(Dual a, Dual b) { return {a.v * b.v, a.d * b.v + a.v * b.d}; }
+
+double value_of(double x) { return x; }
+double value_of(const Dual &x) { return x.v; }
+
+double exp_of(double x) { return std::exp(x); }
+Dual exp_of(const Dual &x)
+{
+    const double e = std::exp(x.v);
+    return {e, e * x.d};
+}
+
+double pow_of(double x, double n) { return std::pow(x, n); }
+Dual pow_of(const Dual &x, double n) { return {std::pow(x.v, n), n * std::pow(x.v, n - 1) * x.d}; }
+
+double gelu_grad_of(double x) { return activation::gelu_grad(x); }
+Dual gelu_grad_of(const Dual &x)
+{
+    // d/dx (Phi(x) + x phi(x)) = phi(x) (2 - x^2)
+    const double pdf = 0.39894228040143267794 * std::exp(-0.5 * x.v * x.v);
+    return {activation::gelu_grad(x.v), pdf * (2.0 - x.v * x.v) * x.d};
+}
+
+/**
+ * Local partial derivatives d node / d parent_i, given the parents' values
+ * x[0..n) and the node's own value y. With T = Dual the tangents carried by
+ * x and y give the partials' directional derivatives as well: the second
+ * order terms forward-over-reverse needs.
+ */
+template <typename T>
+void local_partials(Op op, double aux, const T *x, std::size_t n, const T &y, T *p)
+{
+    switch (op)
+    {
+    case Op::None:
+    case Op::Const:
+        break;
+    case Op::Add:
+        p[0] = T(1.0);
+        p[1] = T(1.0);
+        break;
+    case Op::Mul:
+        p[0] = x[1];
+        p[1] = x[0];
+        break;
+    case Op::Tanh:
+        p[0] = T(1.0) - y * y;
+        break;
+    case Op::Exp:
+        p[0] = y;
+        break;
+    case Op::Pow:
+        p[0] = T(aux) * pow_of(x[0], aux - 1);
+        break;
+    case Op::Relu:
+        p[0] = T(value_of(y) > 0.0 ? 1.0 : 0.0);
+        break;
+    case Op::Sigmoid:
+        p[0] = y * (T(1.0) - y);
+        break;
+    case Op::Gelu:
+        p[0] = gelu_grad_of(x[0]);
+        break;
+    case Op::LogSumExp:
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            p[i] = exp_of(x[i] - y);
+        }
+        break;
+    case Op::SoftmaxCrossEntropy:
+    {
+        const std::size_t target = static_cast<std::size_t>(aux);
+        const T lse = y + x[target];
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            p[i] = exp_of(x[i] - lse) - T(i == target ? 1.0 : 0.0);
+        }
+        break;
+    }
+    case Op::SquaredError:
+    {
+        const std::size_t half = n / 2;
+        for (std::size_t i = 0; i < half; ++i)
+        {
+            const T d = T(2.0 * aux) * (x[i] - x[half + i]);
+            p[i] = d;
+            p[half + i] = T(0.0) - d;
+        }
+        break;
+    }
+    }
+}
+} // namespace
+
+// ======== INDEXING ========
+Differentiator::Differentiator(const std::vector<ValuePtr> &outputs, const std::vector<ValuePtr> &inputs)
+    : m_outputs(outputs), m_inputs(inputs)
+{
+    if (outputs.empty())
+    {
+        throw std::invalid_argument("Differentiator: no outputs");
+    }
+
+    // Merge the outputs' topological orders; a node seen under an earlier
+    // output keeps its earlier position, which still precedes its parents' users
+    std::unordered_map<const Value *, std::uint32_t> position;
+    std::vector<Value *> order;
+    for (const ValuePtr &output : outputs)
+    {
+        output->build_topo(order);
+        for (const Value *node : order)
+        {
+            if (position.emplace(node, static_cast<std::uint32_t>(m_order.size())).second)
+            {
+                m_order.push_back(node);
+            }
+        }
+    }
+    for (const ValuePtr &input : inputs)
+    {
+        if (input->op() != Op::None)
+        {
+            throw std::invalid_argument("Differentiator: inputs must be leaves");
+        }
+        // An input no output depends on still gets a (zero-derivative) position
+        auto inserted = position.emplace(input.get(), static_cast<std::uint32_t>(m_order.size()));
+        if (inserted.second)
+        {
+            m_order.push_back(input.get());
+        }
+        const std::uint32_t at = inserted.first->second;
+        if (std::find(m_input_at.begin(), m_input_at.end(), at) != m_input_at.end())
+        {
+            throw std::invalid_argument("Differentiator: input listed twice");
+        }
+        m_input_at.push_back(at);
+    }
+    for (const ValuePtr &output : outputs)
+    {
+        m_output_at.push_back(position.at(output.get()));
+    }
+
+    m_begin.reserve(m_order.size() + 1);
+    for (const Value *node : m_order)
+    {
+        m_begin.push_back(static_cast<std::uint32_t>(m_parents.size()));
+        for (const ValuePtr &parent : node->prev())
+        {
+            m_parents.push_back(position.at(parent.get()));
+        }
+    }
+    m_begin.push_back(static_cast<std::uint32_t>(m_parents.size()));
+}
+
+// ======== FORWARD MODE ========
+void Differentiator::jvp(const double *tangents, double *out, std::size_t directions) const
+{
+    const std::size_t k = directions, n = m_order.size();
+    std::vector<double> T(n * k, 0.0);
+    for (std::size_t j = 0; j < m_input_at.size(); ++j)
+    {
+        for (std::size_t d = 0; d < k; ++d)
+        {
+            T[m_input_at[j] * k + d] = tangents[d * m_input_at.size() + j];
+        }
+    }
+
+    std::vector<double> x, p;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const Value *node = m_order[i];
+        const std::size_t first = m_begin[i], count = m_begin[i + 1] - first;
+        if (count == 0)
+        {
+            continue; // A leaf keeps its seed
+        }
+        x.resize(count);
+        p.resize(count);
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            x[c] = m_order[m_parents[first + c]]->data();
+        }
+        local_partials(node->op(), node->m_aux, x.data(), count, node->data(), p.data());
+        double *t = &T[i * k];
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            const double *tp = &T[m_parents[first + c] * k];
+            for (std::size_t d = 0; d < k; ++d)
+            {
+                t[d] += p[c] * tp[d];
+            }
+        }
+    }
+
+    for (std::size_t o = 0; o < m_output_at.size(); ++o)
+    {
+        for (std::size_t d = 0; d < k; ++d)
+        {
+            out[d * m_output_at.size() + o] = T[m_output_at[o] * k + d];
+        }
+    }
+}
+
+// ======== REVERSE MODE ========
+void Differentiator::vjp(const double *cotangents, double *out, std::size_t directions) const
+{
+    const std::size_t k = directions, n = m_order.size();
+    std::vector<double> A(n * k, 0.0);
+    for (std::size_t o = 0; o < m_output_at.size(); ++o)
+    {
+        for (std::size_t d = 0; d < k; ++d)
+        {
+            A[m_output_at[o] * k + d] += cotangents[d * m_output_at.size() + o];
+        }
+    }
+
+    std::vector<double> x, p;
+    for (std::size_t i = n; i-- > 0;)
+    {
+        const Value *node = m_order[i];
+        const std::size_t first = m_begin[i], count = m_begin[i + 1] - first;
+        if (count == 0)
+        {
+            continue;
+        }
+        x.resize(count);
+        p.resize(count);
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            x[c] = m_order[m_parents[first + c]]->data();
+        }
+        local_partials(node->op(), node->m_aux, x.data(), count, node->data(), p.data());
+        const double *a = &A[i * k];
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            double *ap = &A[m_parents[first + c] * k];
+            for (std::size_t d = 0; d < k; ++d)
+            {
+                ap[d] += p[c] * a[d];
+            }
+        }
+    }
+
+    for (std::size_t j = 0; j < m_input_at.size(); ++j)
+    {
+        for (std::size_t d = 0; d < k; ++d)
+        {
+            out[d * m_input_at.size() + j] = A[m_input_at[j] * k + d];
+        }
+    }
+}
+
+// ======== SECOND ORDER ========
+void Differentiator::hvp(const double *tangents, double *out, std::size_t directions) const
+{
+    const std::size_t k = directions, n = m_order.size(), nin = m_input_at.size();
+
+    // Forward: the tangent of every node along every direction
+    std::vector<double> T(n * k, 0.0);
+    for (std::size_t j = 0; j < nin; ++j)
+    {
+        for (std::size_t d = 0; d < k; ++d)
+        {
+            T[m_input_at[j] * k + d] = tangents[d * nin + j];
+        }
+    }
+    std::vector<double> x, p;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const std::size_t first = m_begin[i], count = m_begin[i + 1] - first;
+        if (count == 0)
+        {
+            continue;
+        }
+        x.resize(count);
+        p.resize(count);
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            x[c] = m_order[m_parents[first + c]]->data();
+        }
+        local_partials(m_order[i]->op(), m_order[i]->m_aux, x.data(), count, m_order[i]->data(), p.data());
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            for (std::size_t d = 0; d < k; ++d)
+            {
+                T[i * k + d] += p[c] * T[m_parents[first + c] * k + d];
+            }
+        }
+    }
+
+    // Reverse over duals: the adjoint A is the same for every direction,
+    // its tangent Ad = d(gradient)/dv is what accumulates H v
+    std::vector<double> A(n, 0.0), Ad(n * k, 0.0);
+    A[m_output_at[0]] = 1.0;
+    std::vector<Dual> xd, pd;
+    for (std::size_t i = n; i-- > 0;)
+    {
+        const Value *node = m_order[i];
+        const std::size_t first = m_begin[i], count = m_begin[i + 1] - first;
+        if (count == 0)
+        {
+            continue;
+        }
+        x.resize(count);
+        p.resize(count);
+        xd.resize(count);
+        pd.resize(count);
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            x[c] = m_order[m_parents[first + c]]->data();
+        }
+        local_partials(node->op(), node->m_aux, x.data(), count, node->data(), p.data());
+        for (std::size_t c = 0; c < count; ++c)
+        {
+            A[m_parents[first + c]] += p[c] * A[i];
+        }
+        for (std::size_t d = 0; d < k; ++d)
+        {
+            for (std::size_t c = 0; c < count; ++c)
+            {
+                xd[c] = Dual(x[c], T[m_parents[first + c] * k + d]);
+            }
+            local_partials(node->op(), node->m_aux, xd.data(), count, Dual(node->data(), T[i * k + d]), pd.data());
+            for (std::size_t c = 0; c < count; ++c)
+            {
+                Ad[m_parents[first + c] * k + d] += p[c] * Ad[i * k + d] + pd[c].d * A[i];
+            }
+        }
+    }
+
+    for (std::size_t j = 0; j < nin; ++j)
+    {
+        for (std::size_t d = 0; d < k; ++d)
+        {
+            out[d * nin + j] = Ad[m_input_at[j] * k + d];
+        }
+    }
+}
+
+// ======== JACOBIAN ========
+std::vector<double> Differentiator::jacobian() const
+{
+    const std::size_t m = m_output_at.size(), nin = m_input_at.size();
+    std::vector<double> J(m * nin, 0.0);
+    if (nin <= m)
+    {
+        // Forward: direction j is the unit vector e_j and yields column j
+        std::vector<double> unit(nin * nin, 0.0), columns(nin * m);
+        for (std::size_t j = 0; j < nin; ++j)
+        {
+            unit[j * nin + j] = 1.0;
+        }
+        jvp(unit.data(), columns.data(), nin);
+        for (std::size_t j = 0; j < nin; ++j)
+        {
+            for (std::size_t i = 0; i < m; ++i)
+            {
+                J[i * nin + j] = columns[j * m + i];
+            }
+        }
+    }
+    else
+    {
+        // Reverse: direction i is e_i over the outputs and yields row i
+        std::vector<double> unit(m * m, 0.0);
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            unit[i * m + i] = 1.0;
+        }
+        vjp(unit.data(), J.data(), m);
+    }
+    return J;
+}
@@ -0,0 +1,83 @@
+#include "micrograd/inference.hpp"
+#include "micrograd/kernels.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+template <typename T> InferenceMLP<T>::InferenceMLP(const MLP &model) : m_nin(model.nin()), m_max_width(0) {
+    for (const Layer &layer : model.layers()) {
+        m_layers.push_back({layer.nin(), layer.nout(), std::vector<T>(layer.nin() * layer.nout()),
+                            std::vector<compute_type>(layer.nout()), layer.activation()});
+    }
+    for (std::size_t l = 0; l + 1 < m_layers.size(); ++l) {
+        m_max_width = std::max(m_max_width, m_layers[l].nout);
+    }
+    load(model);
+}
+
+template <typename T> void InferenceMLP<T>::load(const MLP &model) {
+    const auto &layers = model.layers();
+    if (model.nin() != m_nin || layers.size() != m_layers.size()) {
+        throw std::invalid_argument("InferenceMLP::load: architecture mismatch");
+    }
+    for (std::size_t l = 0; l < layers.size(); ++l) {
+        DenseLayer &dst = m_layers[l];
+        if (layers[l].nin() != dst.nin || layers[l].nout() != dst.nout || layers[l].activation() != dst.activation) {
+            throw std::invalid_argument("InferenceMLP::load: architecture mismatch");
+        }
+        const double *w = layers[l].weights()->data();
+        const double *b = layers[l].bias()->data();
+        std::transform(w, w + dst.weights.size(), dst.weights.begin(), [](double v) { return static_cast<T>(v); });
+        std::transform(b, b + dst.bias.size(), dst.bias.begin(), [](double v) { return static_cast<compute_type>(v); });
+    }
+}
+
+template <typename T> void InferenceMLP<T>::predict(const compute_type *x, compute_type *y) const {
+    if (m_layers.empty()) {
+        std::copy(x, x + m_nin, y);
+        return;
+    }
+    // Same ping-pong scheme as MLP::predict(), one scratch per scalar type
+    thread_local std::vector<compute_type> scratch;
+    if (scratch.size() < 2 * m_max_width) {
+        scratch.resize(2 * m_max_width);
+    }
+    compute_type *buffers[2] = {scratch.data(), scratch.data() + m_max_width};
+    const compute_type *in = x;
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        const DenseLayer &layer = m_layers[l];
+        compute_type *out = l + 1 == m_layers.size() ? y : buffers[l % 2];
+        for (std::size_t j = 0; j < layer.nout; ++j) {
+            const compute_type sum = kernels::dot(layer.weights.data() + j * layer.nin, in, layer.nin) + layer.bias[j];
+            out[j] = activation::apply(layer.activation, sum);
+        }
+        in = out;
+    }
+}
+
+template <typename T>
+void InferenceMLP<T>::predict(const compute_type *x, compute_type *y, std::size_t batch) const {
+    for (std::size_t i = 0; i < batch; ++i) {
+        predict(x + i * nin(), y + i * nout());
+    }
+}
+
+template <typename T> std::size_t InferenceMLP<T>::nin() const {
+    return m_nin;
+}
+
+template <typename T> std::size_t InferenceMLP<T>::nout() const {
+    return m_layers.empty() ? m_nin : m_layers.back().nout;
+}
+
+template <typename T> std::size_t InferenceMLP<T>::bytes() const {
+    std::size_t total = 0;
+    for (const DenseLayer &layer : m_layers) {
+        total += layer.weights.size() * sizeof(T) + layer.bias.size() * sizeof(compute_type);
+    }
+    return total;
+}
+
+template class InferenceMLP<double>;
+template class InferenceMLP<float>;
+template class InferenceMLP<bfloat16>;
@@ -0,0 +1,98 @@
+#include "micrograd/init.hpp"
+#include "micrograd/thread_pool.hpp"
+
+#include <atomic>
+#include <cmath>
+
+namespace {
+constexpr std::uint64_t kGolden = 0x9e3779b97f4a7c15ULL; ///< SplitMix64 increment
+constexpr std::uint64_t kDefaultSeed = 0x6d6963726f677264ULL;
+
+std::uint64_t mix(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+std::atomic<std::uint64_t> g_default_seed{kDefaultSeed};
+std::atomic<std::uint64_t> g_default_ticket{0};
+} // namespace
+
+// ======== RNG ========
+Rng::Rng(std::uint64_t seed) : m_key(mix(seed + kGolden)) {}
+
+Rng::Rng(Key, std::uint64_t key) : m_key(key) {}
+
+Rng Rng::stream(std::uint64_t id) const {
+    return Rng(Key{}, mix(m_key ^ mix(id + kGolden)));
+}
+
+std::uint64_t Rng::bits(std::uint64_t counter) const {
+    return mix(m_key + (counter + 1) * kGolden);
+}
+
+double Rng::uniform(std::uint64_t counter) const {
+    // The top 53 bits fill a double's mantissa exactly
+    return static_cast<double>(bits(counter) >> 11) * 0x1.0p-53;
+}
+
+double Rng::normal(std::uint64_t counter) const {
+    // Box-Muller; 1 - u keeps the logarithm finite
+    const double u1 = 1.0 - uniform(2 * counter);
+    const double u2 = uniform(2 * counter + 1);
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+// ======== SCHEMES ========
+void init_row(double *row, std::size_t nout, std::size_t nin, Init scheme, const Rng &rng) {
+    const double fan_in = static_cast<double>(nin == 0 ? 1 : nin);
+    const double fan_out = static_cast<double>(nout == 0 ? 1 : nout);
+    double limit = 1.0, stddev = 0.0;
+    switch (scheme) {
+    case Init::Uniform:
+        break;
+    case Init::XavierUniform:
+        limit = std::sqrt(6.0 / (fan_in + fan_out));
+        break;
+    case Init::XavierNormal:
+        stddev = std::sqrt(2.0 / (fan_in + fan_out));
+        break;
+    case Init::HeUniform:
+        limit = std::sqrt(6.0 / fan_in);
+        break;
+    case Init::HeNormal:
+        stddev = std::sqrt(2.0 / fan_in);
+        break;
+    }
+    if (stddev > 0.0) {
+        for (std::size_t i = 0; i < nin; ++i) {
+            row[i] = stddev * rng.normal(i);
+        }
+    } else {
+        for (std::size_t i = 0; i < nin; ++i) {
+            row[i] = limit * (2.0 * rng.uniform(i) - 1.0);
+        }
+    }
+}
+
+void init_weights(double *w, std::size_t nout, std::size_t nin, Init scheme, const Rng &rng, ThreadPool *pool) {
+    auto fill = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t r = begin; r < end; ++r) {
+            init_row(w + r * nin, nout, nin, scheme, rng.stream(r));
+        }
+    };
+    if (pool) {
+        pool->parallel_for(nout, fill);
+    } else {
+        fill(0, nout);
+    }
+}
+
+Rng next_default_init_stream() {
+    return Rng(g_default_seed.load()).stream(g_default_ticket.fetch_add(1));
+}
+
+void seed_default_init(std::uint64_t seed) {
+    g_default_seed.store(seed);
+    g_default_ticket.store(0);
+}
@@ -0,0 +1,803 @@
+/**
+ * @file kernels.cpp
+ * @brief Scalar, NEON, AVX2 and AVX-512 kernel variants and their dispatch
+ *
+ * The x86 variants are compiled with per-function target attributes rather
+ * than global -m flags, so the rest of the library keeps the baseline ISA
+ * and only the selected variant ever executes wider instructions.
+ */
+
+#include "micrograd/kernels.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MICROGRAD_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define MICROGRAD_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace kernels {
+namespace {
+
+/// Entry points of one instruction-set variant
+struct KernelTable
+{
+    Isa isa;
+    double (*dot)(const double *, const double *, std::size_t);
+    void (*axpy)(double, const double *, double *, std::size_t);
+    void (*momentum)(double *, const double *, double *, double, double, std::size_t);
+    void (*adam)(double *, const double *, double *, double *, double, double, double, double, double, std::size_t);
+    float (*dot_f32)(const float *, const float *, std::size_t);
+    float (*dot_bf16)(const bfloat16 *, const float *, std::size_t);
+    std::int32_t (*dot_i8)(const std::int8_t *, const std::int8_t *, std::size_t);
+};
+
+// ======== SCALAR ========
+double dot_scalar(const double *a, const double *b, std::size_t n)
+{
+    // Independent accumulators break the loop-carried dependency on one sum
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i)
+    {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+void axpy_scalar(double alpha, const double *x, double *y, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        y[i] += alpha * x[i];
+    }
+}
+
+void momentum_scalar(double *p, const double *g, double *v, double lr, double mu, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        v[i] = mu * v[i] + g[i];
+        p[i] -= lr * v[i];
+    }
+}
+
+void adam_scalar(double *p, const double *g, double *m, double *v, double beta1, double beta2, double step_size,
+                 double inv_bias2, double eps, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        m[i] = beta1 * m[i] + (1 - beta1) * g[i];
+        v[i] = beta2 * v[i] + (1 - beta2) * g[i] * g[i];
+        p[i] -= step_size * m[i] / (std::sqrt(v[i] * inv_bias2) + eps);
+    }
+}
+
+float dot_f32_scalar(const float *a, const float *b, std::size_t n)
+{
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i)
+    {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+float dot_bf16_scalar(const bfloat16 *a, const float *b, std::size_t n)
+{
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += static_cast<float>(a[i]) * b[i];
+        s1 += static_cast<float>(a[i + 1]) * b[i + 1];
+        s2 += static_cast<float>(a[i + 2]) * b[i + 2];
+        s3 += static_cast<float>(a[i + 3]) * b[i + 3];
+    }
+    for (; i < n; ++i)
+    {
+        s0 += static_cast<float>(a[i]) * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+std::int32_t dot_i8_scalar(const std::int8_t *a, const std::int8_t *b, std::size_t n)
+{
+    std::int32_t s0 = 0, s1 = 0;
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+    }
+    for (; i < n; ++i)
+    {
+        s0 += a[i] * b[i];
+    }
+    return s0 + s1;
+}
+
+constexpr KernelTable kScalarTable{Isa::Scalar,   dot_scalar,     axpy_scalar,     momentum_scalar,
+                                   adam_scalar,   dot_f32_scalar, dot_bf16_scalar, dot_i8_scalar};
+
+// ======== AVX2 / AVX-512 ========
+#if MICROGRAD_KERNELS_X86
+__attribute__((target("avx2,fma"))) double dot_avx2(const double *a, const double *b, std::size_t n)
+{
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), s1);
+        s2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), s2);
+        s3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), s3);
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+    }
+    __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+    double acc = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    for (; i < n; ++i)
+    {
+        acc += a[i] * b[i];
+    }
+    return acc;
+}
+
+__attribute__((target("avx2,fma"))) void axpy_avx2(double alpha, const double *x, double *y, std::size_t n)
+{
+    const __m256d va = _mm256_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        _mm256_storeu_pd(y + i + 4, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i)
+    {
+        y[i] += alpha * x[i];
+    }
+}
+
+// The optimizer kernels finish their tails with the scalar loop
+__attribute__((target("avx2,fma"))) void momentum_avx2(double *p, const double *g, double *v, double lr, double mu,
+                                                      std::size_t n)
+{
+    const __m256d vlr = _mm256_set1_pd(lr), vmu = _mm256_set1_pd(mu);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d vv = _mm256_fmadd_pd(vmu, _mm256_loadu_pd(v + i), _mm256_loadu_pd(g + i));
+        _mm256_storeu_pd(v + i, vv);
+        _mm256_storeu_pd(p + i, _mm256_fnmadd_pd(vlr, vv, _mm256_loadu_pd(p + i)));
+    }
+    momentum_scalar(p + i, g + i, v + i, lr, mu, n - i);
+}
+
+__attribute__((target("avx2,fma"))) void adam_avx2(double *p, const double *g, double *m, double *v, double beta1,
+                                                  double beta2, double step_size, double inv_bias2, double eps,
+                                                  std::size_t n)
+{
+    const __m256d b1 = _mm256_set1_pd(beta1), b2 = _mm256_set1_pd(beta2);
+    const __m256d c1 = _mm256_set1_pd(1 - beta1), c2 = _mm256_set1_pd(1 - beta2);
+    const __m256d step = _mm256_set1_pd(step_size), inv2 = _mm256_set1_pd(inv_bias2), veps = _mm256_set1_pd(eps);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256d vg = _mm256_loadu_pd(g + i);
+        const __m256d vm = _mm256_fmadd_pd(b1, _mm256_loadu_pd(m + i), _mm256_mul_pd(c1, vg));
+        const __m256d vv = _mm256_fmadd_pd(b2, _mm256_loadu_pd(v + i), _mm256_mul_pd(c2, _mm256_mul_pd(vg, vg)));
+        const __m256d denom = _mm256_add_pd(_mm256_sqrt_pd(_mm256_mul_pd(vv, inv2)), veps);
+        _mm256_storeu_pd(m + i, vm);
+        _mm256_storeu_pd(v + i, vv);
+        _mm256_storeu_pd(p + i, _mm256_fnmadd_pd(step, _mm256_div_pd(vm, denom), _mm256_loadu_pd(p + i)));
+    }
+    adam_scalar(p + i, g + i, m + i, v + i, beta1, beta2, step_size, inv_bias2, eps, n - i);
+}
+
+__attribute__((target("avx2,fma"))) float hsum_avx2(__m256 s)
+{
+    __m128 q = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    q = _mm_add_ps(q, _mm_movehl_ps(q, q));
+    return _mm_cvtss_f32(_mm_add_ss(q, _mm_shuffle_ps(q, q, 1)));
+}
+
+/// Widen 8 bfloat16 values to floats: they are the upper halves of the float bit patterns
+__attribute__((target("avx2,fma"))) __m256 load_bf16_avx2(const bfloat16 *p)
+{
+    const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(raw), 16));
+}
+
+__attribute__((target("avx2,fma"))) float dot_f32_avx2(const float *a, const float *b, std::size_t n)
+{
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+    }
+    for (; i + 8 <= n; i += 8)
+    {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+    }
+    float acc = hsum_avx2(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+    for (; i < n; ++i)
+    {
+        acc += a[i] * b[i];
+    }
+    return acc;
+}
+
+__attribute__((target("avx2,fma"))) float dot_bf16_avx2(const bfloat16 *a, const float *b, std::size_t n)
+{
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        s0 = _mm256_fmadd_ps(load_bf16_avx2(a + i), _mm256_loadu_ps(b + i), s0);
+        s1 = _mm256_fmadd_ps(load_bf16_avx2(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+    }
+    for (; i + 8 <= n; i += 8)
+    {
+        s0 = _mm256_fmadd_ps(load_bf16_avx2(a + i), _mm256_loadu_ps(b + i), s0);
+    }
+    float acc = hsum_avx2(_mm256_add_ps(s0, s1));
+    for (; i < n; ++i)
+    {
+        acc += static_cast<float>(a[i]) * b[i];
+    }
+    return acc;
+}
+
+__attribute__((target("avx2"))) std::int32_t dot_i8_avx2(const std::int8_t *a, const std::int8_t *b, std::size_t n)
+{
+    // Widen to 16 bits, then vpmaddwd sums adjacent products into 32-bit lanes
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_castsi256_si128(va)),
+                                                    _mm256_cvtepi8_epi16(_mm256_castsi256_si128(vb))));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_extracti128_si256(va, 1)),
+                                                    _mm256_cvtepi8_epi16(_mm256_extracti128_si256(vb, 1))));
+    }
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_cvtepi8_epi16(va), _mm256_cvtepi8_epi16(vb)));
+    }
+    const __m256i s = _mm256_add_epi32(s0, s1);
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    std::int32_t acc = _mm_cvtsi128_si32(half);
+    for (; i < n; ++i)
+    {
+        acc += a[i] * b[i];
+    }
+    return acc;
+}
+
+// GCC's AVX-512 intrinsics pass _mm*_undefined_*() as the unused merge
+// source, which GCC 12 at -O2 reports as an uninitialized read
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f"))) double dot_avx512(const double *a, const double *b, std::size_t n)
+{
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), s1);
+    }
+    if (i + 8 <= n)
+    {
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), s0);
+        i += 8;
+    }
+    if (i < n)
+    {
+        // Masked tail: lanes past n load as zero
+        const __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1u);
+        s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i), s1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+}
+
+__attribute__((target("avx512f"))) void axpy_avx512(double alpha, const double *x, double *y, std::size_t n)
+{
+    const __m512d va = _mm512_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+    }
+    if (i < n)
+    {
+        const __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1u);
+        __m512d vy = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+        _mm512_mask_storeu_pd(y + i, mask, vy);
+    }
+}
+
+__attribute__((target("avx512f"))) void momentum_avx512(double *p, const double *g, double *v, double lr, double mu,
+                                                       std::size_t n)
+{
+    const __m512d vlr = _mm512_set1_pd(lr), vmu = _mm512_set1_pd(mu);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d vv = _mm512_fmadd_pd(vmu, _mm512_loadu_pd(v + i), _mm512_loadu_pd(g + i));
+        _mm512_storeu_pd(v + i, vv);
+        _mm512_storeu_pd(p + i, _mm512_fnmadd_pd(vlr, vv, _mm512_loadu_pd(p + i)));
+    }
+    momentum_scalar(p + i, g + i, v + i, lr, mu, n - i);
+}
+
+__attribute__((target("avx512f"))) void adam_avx512(double *p, const double *g, double *m, double *v, double beta1,
+                                                   double beta2, double step_size, double inv_bias2, double eps,
+                                                   std::size_t n)
+{
+    const __m512d b1 = _mm512_set1_pd(beta1), b2 = _mm512_set1_pd(beta2);
+    const __m512d c1 = _mm512_set1_pd(1 - beta1), c2 = _mm512_set1_pd(1 - beta2);
+    const __m512d step = _mm512_set1_pd(step_size), inv2 = _mm512_set1_pd(inv_bias2), veps = _mm512_set1_pd(eps);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m512d vg = _mm512_loadu_pd(g + i);
+        const __m512d vm = _mm512_fmadd_pd(b1, _mm512_loadu_pd(m + i), _mm512_mul_pd(c1, vg));
+        const __m512d vv = _mm512_fmadd_pd(b2, _mm512_loadu_pd(v + i), _mm512_mul_pd(c2, _mm512_mul_pd(vg, vg)));
+        const __m512d denom = _mm512_add_pd(_mm512_sqrt_pd(_mm512_mul_pd(vv, inv2)), veps);
+        _mm512_storeu_pd(m + i, vm);
+        _mm512_storeu_pd(v + i, vv);
+        _mm512_storeu_pd(p + i, _mm512_fnmadd_pd(step, _mm512_div_pd(vm, denom), _mm512_loadu_pd(p + i)));
+    }
+    adam_scalar(p + i, g + i, m + i, v + i, beta1, beta2, step_size, inv_bias2, eps, n - i);
+}
+
+__attribute__((target("avx512f"))) float dot_f32_avx512(const float *a, const float *b, std::size_t n)
+{
+    __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+        s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), s1);
+    }
+    if (i + 16 <= n)
+    {
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+        i += 16;
+    }
+    if (i < n)
+    {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1u);
+        s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), s1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+}
+
+__attribute__((target("avx512f"))) float dot_bf16_avx512(const bfloat16 *a, const float *b, std::size_t n)
+{
+    __m512 s0 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m512 wa = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(raw), 16));
+        s0 = _mm512_fmadd_ps(wa, _mm512_loadu_ps(b + i), s0);
+    }
+    // A masked 16-bit load needs AVX-512BW, so the tail stays scalar
+    float acc = _mm512_reduce_add_ps(s0);
+    for (; i < n; ++i)
+    {
+        acc += static_cast<float>(a[i]) * b[i];
+    }
+    return acc;
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) std::int32_t dot_i8_avx512vnni(const std::int8_t *a,
+                                                                                      const std::int8_t *b,
+                                                                                      std::size_t n)
+{
+    // vpdpbusd multiplies unsigned by signed bytes. Flipping b's sign bit
+    // gives b + 128 as unsigned, so sum (b + 128) a - 128 sum a = sum a b;
+    // the second sum is another vpdpbusd against a vector of ones.
+    const __m512i flip = _mm512_set1_epi8(static_cast<char>(0x80));
+    const __m512i ones = _mm512_set1_epi8(1);
+    __m512i acc = _mm512_setzero_si512(), sum_a = _mm512_setzero_si512();
+    for (std::size_t i = 0; i < n; i += 64)
+    {
+        // Masked loads cover the tail; lanes past n contribute (0 + 128) * 0
+        const __mmask64 mask = n - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (n - i)) - 1;
+        const __m512i va = _mm512_maskz_loadu_epi8(mask, a + i);
+        const __m512i vb = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, b + i), flip);
+        acc = _mm512_dpbusd_epi32(acc, vb, va);
+        sum_a = _mm512_dpbusd_epi32(sum_a, ones, va);
+    }
+    // acc alone wraps from n near 2^16 although the dot fits until 2^17, so
+    // the two sums are combined modulo 2^32 instead of in signed int
+    const auto total = static_cast<std::uint32_t>(_mm512_reduce_add_epi32(acc)) -
+                       128u * static_cast<std::uint32_t>(_mm512_reduce_add_epi32(sum_a));
+    return static_cast<std::int32_t>(total);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+constexpr KernelTable kAvx2Table{Isa::Avx2, dot_avx2,     axpy_avx2,     momentum_avx2,
+                                 adam_avx2, dot_f32_avx2, dot_bf16_avx2, dot_i8_avx2};
+// AVX-512F alone has no byte arithmetic, so without VNNI the int8 dot uses AVX2
+constexpr KernelTable kAvx512Table{Isa::Avx512, dot_avx512,     axpy_avx512,     momentum_avx512,
+                                   adam_avx512, dot_f32_avx512, dot_bf16_avx512, dot_i8_avx2};
+constexpr KernelTable kAvx512VnniTable{Isa::Avx512, dot_avx512,     axpy_avx512,     momentum_avx512,
+                                       adam_avx512, dot_f32_avx512, dot_bf16_avx512, dot_i8_avx512vnni};
+#endif // MICROGRAD_KERNELS_X86
+
+// ======== NEON ========
+#if MICROGRAD_KERNELS_NEON
+double dot_neon(const double *a, const double *b, std::size_t n)
+{
+    float64x2_t s0 = vdupq_n_f64(0.0), s1 = vdupq_n_f64(0.0);
+    float64x2_t s2 = vdupq_n_f64(0.0), s3 = vdupq_n_f64(0.0);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        s0 = vfmaq_f64(s0, vld1q_f64(a + i), vld1q_f64(b + i));
+        s1 = vfmaq_f64(s1, vld1q_f64(a + i + 2), vld1q_f64(b + i + 2));
+        s2 = vfmaq_f64(s2, vld1q_f64(a + i + 4), vld1q_f64(b + i + 4));
+        s3 = vfmaq_f64(s3, vld1q_f64(a + i + 6), vld1q_f64(b + i + 6));
+    }
+    for (; i + 2 <= n; i += 2)
+    {
+        s0 = vfmaq_f64(s0, vld1q_f64(a + i), vld1q_f64(b + i));
+    }
+    double acc = vaddvq_f64(vaddq_f64(vaddq_f64(s0, s1), vaddq_f64(s2, s3)));
+    for (; i < n; ++i)
+    {
+        acc += a[i] * b[i];
+    }
+    return acc;
+}
+
+void axpy_neon(double alpha, const double *x, double *y, std::size_t n)
+{
+    const float64x2_t va = vdupq_n_f64(alpha);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        vst1q_f64(y + i, vfmaq_f64(vld1q_f64(y + i), va, vld1q_f64(x + i)));
+    }
+    for (; i < n; ++i)
+    {
+        y[i] += alpha * x[i];
+    }
+}
+
+void momentum_neon(double *p, const double *g, double *v, double lr, double mu, std::size_t n)
+{
+    const float64x2_t vlr = vdupq_n_f64(lr), vmu = vdupq_n_f64(mu);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        float64x2_t vv = vfmaq_f64(vld1q_f64(g + i), vmu, vld1q_f64(v + i));
+        vst1q_f64(v + i, vv);
+        vst1q_f64(p + i, vfmsq_f64(vld1q_f64(p + i), vlr, vv));
+    }
+    momentum_scalar(p + i, g + i, v + i, lr, mu, n - i);
+}
+
+void adam_neon(double *p, const double *g, double *m, double *v, double beta1, double beta2, double step_size,
+               double inv_bias2, double eps, std::size_t n)
+{
+    const float64x2_t b1 = vdupq_n_f64(beta1), b2 = vdupq_n_f64(beta2);
+    const float64x2_t c1 = vdupq_n_f64(1 - beta1), c2 = vdupq_n_f64(1 - beta2);
+    const float64x2_t step = vdupq_n_f64(step_size), inv2 = vdupq_n_f64(inv_bias2), veps = vdupq_n_f64(eps);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        const float64x2_t vg = vld1q_f64(g + i);
+        const float64x2_t vm = vfmaq_f64(vmulq_f64(c1, vg), b1, vld1q_f64(m + i));
+        const float64x2_t vv = vfmaq_f64(vmulq_f64(c2, vmulq_f64(vg, vg)), b2, vld1q_f64(v + i));
+        const float64x2_t denom = vaddq_f64(vsqrtq_f64(vmulq_f64(vv, inv2)), veps);
+        vst1q_f64(m + i, vm);
+        vst1q_f64(v + i, vv);
+        vst1q_f64(p + i, vfmsq_f64(vld1q_f64(p + i), step, vdivq_f64(vm, denom)));
+    }
+    adam_scalar(p + i, g + i, m + i, v + i, beta1, beta2, step_size, inv_bias2, eps, n - i);
+}
+
+float dot_f32_neon(const float *a, const float *b, std::size_t n)
+{
+    float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        s0 = vfmaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+        s1 = vfmaq_f32(s1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 = vfmaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float acc = vaddvq_f32(vaddq_f32(s0, s1));
+    for (; i < n; ++i)
+    {
+        acc += a[i] * b[i];
+    }
+    return acc;
+}
+
+float dot_bf16_neon(const bfloat16 *a, const float *b, std::size_t n)
+{
+    float32x4_t s0 = vdupq_n_f32(0.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const uint16x4_t raw = vld1_u16(reinterpret_cast<const std::uint16_t *>(a + i));
+        s0 = vfmaq_f32(s0, vreinterpretq_f32_u32(vshll_n_u16(raw, 16)), vld1q_f32(b + i));
+    }
+    float acc = vaddvq_f32(s0);
+    for (; i < n; ++i)
+    {
+        acc += static_cast<float>(a[i]) * b[i];
+    }
+    return acc;
+}
+
+std::int32_t dot_i8_neon(const std::int8_t *a, const std::int8_t *b, std::size_t n)
+{
+    // vmull widens the products to 16 bits; vpadal pairs them into 32-bit lanes
+    int32x4_t s0 = vdupq_n_s32(0), s1 = vdupq_n_s32(0);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const int8x16_t va = vld1q_s8(a + i), vb = vld1q_s8(b + i);
+        s0 = vpadalq_s16(s0, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        s1 = vpadalq_s16(s1, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+    }
+    for (; i + 8 <= n; i += 8)
+    {
+        s0 = vpadalq_s16(s0, vmull_s8(vld1_s8(a + i), vld1_s8(b + i)));
+    }
+    std::int32_t acc = vaddvq_s32(vaddq_s32(s0, s1));
+    for (; i < n; ++i)
+    {
+        acc += a[i] * b[i];
+    }
+    return acc;
+}
+
+constexpr KernelTable kNeonTable{Isa::Neon, dot_neon,     axpy_neon,     momentum_neon,
+                                 adam_neon, dot_f32_neon, dot_bf16_neon, dot_i8_neon};
+#endif // MICROGRAD_KERNELS_NEON
+
+// ======== DISPATCH ========
+const KernelTable *table_for(Isa isa)
+{
+#if MICROGRAD_KERNELS_X86
+    __builtin_cpu_init();
+#endif
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return &kScalarTable;
+    case Isa::Neon:
+#if MICROGRAD_KERNELS_NEON
+        return &kNeonTable;
+#else
+        return nullptr;
+#endif
+    case Isa::Avx2:
+#if MICROGRAD_KERNELS_X86
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? &kAvx2Table : nullptr;
+#else
+        return nullptr;
+#endif
+    case Isa::Avx512:
+#if MICROGRAD_KERNELS_X86
+        if (!__builtin_cpu_supports("avx512f"))
+        {
+            return nullptr;
+        }
+        return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni") ? &kAvx512VnniTable
+                                                                                            : &kAvx512Table;
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const KernelTable *detect()
+{
+    if (const char *forced = std::getenv("MICROGRAD_ISA"))
+    {
+        for (Isa isa : {Isa::Scalar, Isa::Neon, Isa::Avx2, Isa::Avx512})
+        {
+            if (std::strcmp(forced, isa_name(isa)) == 0 && table_for(isa))
+            {
+                return table_for(isa);
+            }
+        }
+    }
+    for (Isa isa : {Isa::Avx512, Isa::Avx2, Isa::Neon})
+    {
+        if (const KernelTable *table = table_for(isa))
+        {
+            return table;
+        }
+    }
+    return &kScalarTable;
+}
+
+std::atomic<const KernelTable *> g_table{nullptr}; ///< Selected variant, resolved on first use
+
+const KernelTable &table()
+{
+    const KernelTable *t = g_table.load(std::memory_order_acquire);
+    if (!t)
+    {
+        // Racing first calls all compute the same answer, so a plain store is fine
+        t = detect();
+        g_table.store(t, std::memory_order_release);
+    }
+    return *t;
+}
+
+} // namespace
+
+// ======== PUBLIC API ========
+const char *isa_name(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::Neon:
+        return "neon";
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Avx512:
+        return "avx512";
+    }
+    return "?";
+}
+
+bool isa_supported(Isa isa)
+{
+    return table_for(isa) != nullptr;
+}
+
+Isa active_isa()
+{
+    return table().isa;
+}
+
+void select_isa(Isa isa)
+{
+    const KernelTable *t = table_for(isa);
+    if (!t)
+    {
+        throw std::invalid_argument(std::string("select_isa: ") + isa_name(isa) + " is not supported here");
+    }
+    g_table.store(t, std::memory_order_release);
+}
+
+double dot(const double *a, const double *b, std::size_t n)
+{
+    return table().dot(a, b, n);
+}
+
+float dot(const float *a, const float *b, std::size_t n)
+{
+    return table().dot_f32(a, b, n);
+}
+
+float dot(const bfloat16 *a, const float *b, std::size_t n)
+{
+    return table().dot_bf16(a, b, n);
+}
+
+std::int32_t dot(const std::int8_t *a, const std::int8_t *b, std::size_t n)
+{
+    return table().dot_i8(a, b, n);
+}
+
+void axpy(double alpha, const double *x, double *y, std::size_t n)
+{
+    table().axpy(alpha, x, y, n);
+}
+
+void momentum_update(double *p, const double *g, double *v, double lr, double mu, std::size_t n)
+{
+    table().momentum(p, g, v, lr, mu, n);
+}
+
+void adam_update(double *p, const double *g, double *m, double *v, double beta1, double beta2, double step_size,
+                 double inv_bias2, double eps, std::size_t n)
+{
+    table().adam(p, g, m, v, beta1, beta2, step_size, inv_bias2, eps, n);
+}
+
+void dense_tanh_forward(const double *W, const double *b, const double *x, double *y, std::size_t nout,
+                        std::size_t nin)
+{
+    const KernelTable &k = table();
+    for (std::size_t j = 0; j < nout; ++j)
+    {
+        y[j] = std::tanh(k.dot(W + j * nin, x, nin) + b[j]);
+    }
+}
+
+void dense_tanh_backward(const double *W, const double *x, const double *y, const double *gy, double *dW,
+                         double *db, double *dx, std::size_t nout, std::size_t nin)
+{
+    const KernelTable &k = table();
+    for (std::size_t j = 0; j < nout; ++j)
+    {
+        // Gradient at the pre-activation: d tanh(z) = 1 - tanh(z)^2
+        const double d = gy[j] * (1 - y[j] * y[j]);
+        if (db)
+        {
+            db[j] += d;
+        }
+        if (dW)
+        {
+            k.axpy(d, x, dW + j * nin, nin);
+        }
+        if (dx)
+        {
+            k.axpy(d, W + j * nin, dx, nin);
+        }
+    }
+}
+
+} // namespace kernels
@@ -1,13 +1,42 @@
 #include "micrograd/layer.hpp"
+#include "micrograd/kernels.hpp"
+#include "micrograd/tape.hpp"
 
-Layer::Layer(int nin, int nout) {
-    // Create nout neurons, each with nin inputs
-    for (int i = 0; i < nout; ++i) {
-        m_neurons.emplace_back(nin);
+#include <utility>
+
+Layer::Layer(int nin, int nout, Activation act)
+    : Layer(std::make_shared<ParameterBlock>(static_cast<std::size_t>(nout), static_cast<std::size_t>(nin)), act) {}
+
+Layer::Layer(int nin, int nout, Activation act, NoInit)
+    : Layer(std::make_shared<ParameterBlock>(static_cast<std::size_t>(nout), static_cast<std::size_t>(nin), no_init),
+            act) {}
+
+Layer::Layer(std::shared_ptr<ParameterBlock> params, Activation act) : m_params(std::move(params)), m_activation(act) {
+    // Create nout neurons, each viewing one row of the shared parameter block
+    m_neurons.reserve(m_params->nout());
+    for (std::size_t i = 0; i < m_params->nout(); ++i) {
+        m_neurons.emplace_back(m_params, i, act);
+    }
+
+    m_parameters.reserve(m_params->nout() * (m_params->nin() + 1));
+    for (const auto &neuron : m_neurons) {
+        m_parameters.insert(m_parameters.end(), neuron.weights().begin(), neuron.weights().end());
+        m_parameters.push_back(neuron.bias());
     }
 }
 
 std::vector<ValuePtr> Layer::operator()(const std::vector<ValuePtr> &x) {
+    if (m_pool && !Tape::active()) {
+        // Each neuron builds its own subgraph; they share only the inputs
+        std::vector<ValuePtr> outs(m_neurons.size());
+        m_pool->parallel_for(m_neurons.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                outs[i] = m_neurons[i](x);
+            }
+        });
+        return outs;
+    }
+
     std::vector<ValuePtr> outs;
     outs.reserve(m_neurons.size()); // Pre-allocate memory for efficiency
     for (auto &neuron : m_neurons) {
@@ -16,11 +45,74 @@ std::vector<ValuePtr> Layer::operator()(const std::vector<ValuePtr> &x) {
     return outs;
 }
 
-std::vector<ValuePtr> Layer::parameters() const {
-    std::vector<ValuePtr> params;
-    for (const auto &neuron : m_neurons) {
-        auto neuron_params = neuron.parameters();
-        params.insert(params.end(), neuron_params.begin(), neuron_params.end());
+const std::vector<ValuePtr> &Layer::parameters() const {
+    return m_parameters;
+}
+
+TensorPtr Layer::operator()(const TensorPtr &x) {
+    // The parameter tensors are graph leaves; their gradient buffers are the
+    // same memory the scalar parameter Values accumulate into
+    if (m_activation == Activation::Tanh) {
+        return dense_tanh(x, m_params->weights(), m_params->bias(), m_pool);
+    }
+    return activate(add_bias(matmul_transposed(x, m_params->weights()), m_params->bias()), m_activation);
+}
+
+void Layer::predict(const double *x, double *y) const {
+    const double *w = m_params->weights()->data(), *b = m_params->bias()->data();
+    if (m_activation == Activation::Tanh) {
+        kernels::dense_tanh_forward(w, b, x, y, nout(), nin());
+        return;
+    }
+    for (std::size_t j = 0; j < nout(); ++j) {
+        y[j] = activation::apply(m_activation, kernels::dot(w + j * nin(), x, nin()) + b[j]);
+    }
+}
+
+void Layer::zero_grad() {
+    m_params->zero_grad();
+}
+
+void Layer::set_requires_grad(bool requires_grad) {
+    for (const auto &p : m_parameters) {
+        p->set_requires_grad(requires_grad);
     }
-    return params;
-}
\ No newline at end of file
+    m_params->weights()->set_requires_grad(requires_grad);
+    m_params->bias()->set_requires_grad(requires_grad);
+}
+
+bool Layer::requires_grad() const {
+    return m_params->weights()->requires_grad();
+}
+
+void Layer::set_thread_pool(ThreadPool *pool) {
+    m_pool = pool;
+}
+
+ThreadPool *Layer::thread_pool() const {
+    return m_pool;
+}
+
+const TensorPtr &Layer::weights() const {
+    return m_params->weights();
+}
+
+const TensorPtr &Layer::bias() const {
+    return m_params->bias();
+}
+
+std::size_t Layer::nin() const {
+    return m_params->nin();
+}
+
+std::size_t Layer::nout() const {
+    return m_params->nout();
+}
+
+Activation Layer::activation() const {
+    return m_activation;
+}
+
+void Layer::initialize(Init scheme, const Rng &rng) {
+    m_params->initialize(scheme, rng, m_pool);
+}
@@ -1,33 +1,186 @@
 #include "micrograd/mlp.hpp"
+#include "micrograd/profile.hpp"
 
-MLP::MLP(int nin, const std::vector<int> &nouts) {
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+thread_local std::vector<double> t_predict_scratch; ///< Ping-pong activations for predict()
+}
+
+MLP::MLP(int nin, const std::vector<int> &nouts)
+    : MLP(nin, nouts, std::vector<Activation>(nouts.size(), Activation::Tanh)) {}
+
+MLP::MLP(int nin, const std::vector<int> &nouts, const std::vector<Activation> &activations)
+    : MLP(nin, nouts, activations, true) {}
+
+MLP::MLP(int nin, const std::vector<int> &nouts, const std::vector<Activation> &activations, NoInit)
+    : MLP(nin, nouts, activations, false) {}
+
+MLP::MLP(int nin, const std::vector<int> &nouts, const std::vector<Activation> &activations, bool draw_weights)
+    : m_nin(static_cast<std::size_t>(nin)), m_max_width(0), m_checkpoint_interval(0) {
+    if (activations.size() != nouts.size()) {
+        throw std::invalid_argument("MLP: need one activation per layer");
+    }
     // Create the sequence of layers
     int size = nin;
-    for (int nout : nouts) {
-        m_layers.emplace_back(size, nout);
-        size = nout; // The input size for the next layer is the output size of this one
+    for (std::size_t l = 0; l < nouts.size(); ++l) {
+        if (draw_weights) {
+            m_layers.emplace_back(size, nouts[l], activations[l]);
+        } else {
+            m_layers.emplace_back(size, nouts[l], activations[l], no_init);
+        }
+        size = nouts[l]; // The input size for the next layer is the output size of this one
+    }
+    for (std::size_t l = 0; l + 1 < m_layers.size(); ++l) {
+        m_max_width = std::max(m_max_width, m_layers[l].nout());
+    }
+
+    // The topology is fixed from here on, so the parameter index is built once
+    for (const auto &layer : m_layers) {
+        const auto &layer_params = layer.parameters();
+        m_parameters.insert(m_parameters.end(), layer_params.begin(), layer_params.end());
+        for (const TensorPtr &p : {layer.weights(), layer.bias()}) {
+            m_spans.push_back({p->data(), p->grad(), p->size(), p.get()});
+        }
     }
 }
 
 std::vector<ValuePtr> MLP::operator()(std::vector<ValuePtr> x) {
     // Pass the input through each layer sequentially
-    for (auto &layer : m_layers) {
-        x = layer(x);
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        MICROGRAD_PROFILE_SCOPE("forward", static_cast<int>(l));
+        x = m_layers[l](x);
     }
     return x;
 }
 
-std::vector<ValuePtr> MLP::parameters() const {
-    std::vector<ValuePtr> params;
+const std::vector<Layer> &MLP::layers() const {
+    return m_layers;
+}
+
+std::vector<Activation> MLP::activations() const {
+    std::vector<Activation> acts;
     for (const auto &layer : m_layers) {
-        auto layer_params = layer.parameters();
-        params.insert(params.end(), layer_params.begin(), layer_params.end());
+        acts.push_back(layer.activation());
     }
-    return params;
+    return acts;
+}
+
+const std::vector<ValuePtr> &MLP::parameters() const {
+    return m_parameters;
+}
+
+const std::vector<ParameterSpan> &MLP::parameter_spans() const {
+    return m_spans;
 }
 
 void MLP::zero_grad() {
-    for (const auto &p : parameters()) {
-        p->zero_grad();
+    // Each layer's gradients are two contiguous buffers, so this is a few fills
+    for (const auto &span : m_spans) {
+        std::fill(span.grad, span.grad + span.size, 0.0);
+    }
+}
+
+void MLP::set_requires_grad(std::size_t layer, bool requires_grad) {
+    m_layers.at(layer).set_requires_grad(requires_grad);
+}
+
+void MLP::initialize(Init scheme, const Rng &rng) {
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        m_layers[l].initialize(scheme, rng.stream(l));
+    }
+}
+
+void MLP::set_thread_pool(ThreadPool *pool) {
+    for (auto &layer : m_layers) {
+        layer.set_thread_pool(pool);
     }
+}
+
+void MLP::set_checkpoint_interval(std::size_t interval) {
+    m_checkpoint_interval = interval > 1 ? interval : 0;
+}
+
+std::size_t MLP::checkpoint_interval() const {
+    return m_checkpoint_interval;
+}
+
+TensorPtr MLP::operator()(const TensorPtr &x) {
+    TensorPtr out = x;
+    if (m_checkpoint_interval == 0) {
+        for (std::size_t l = 0; l < m_layers.size(); ++l) {
+            MICROGRAD_PROFILE_SCOPE("forward", static_cast<int>(l));
+            out = m_layers[l](out);
+        }
+        return out;
+    }
+
+    std::vector<TensorPtr> group;
+    for (std::size_t begin = 0; begin < m_layers.size(); begin += m_checkpoint_interval) {
+        const std::size_t end = std::min(begin + m_checkpoint_interval, m_layers.size());
+        MICROGRAD_PROFILE_SCOPE("forward", static_cast<int>(begin)); // A group is timed as its first layer
+        for (std::size_t l = begin; l < end;) {
+            // Checkpoint each maximal run of tanh layers; other activations have no
+            // recomputing node, and a single layer has nothing inside to drop
+            std::size_t run_end = l;
+            while (run_end < end && m_layers[run_end].activation() == Activation::Tanh) {
+                ++run_end;
+            }
+            if (run_end - l < 2) {
+                out = m_layers[l](out);
+                ++l;
+                continue;
+            }
+            group.clear();
+            for (std::size_t r = l; r < run_end; ++r) {
+                group.push_back(m_layers[r].weights());
+                group.push_back(m_layers[r].bias());
+            }
+            out = checkpoint_dense_tanh(out, group, m_layers[l].thread_pool());
+            l = run_end;
+        }
+    }
+    return out;
+}
+
+BatchOutput MLP::forward_batch(const double *x, const double *y, std::size_t batch) {
+    auto inputs = make_tensor(batch, nin(), std::vector<double>(x, x + batch * nin()));
+    auto targets = make_tensor(batch, nout(), std::vector<double>(y, y + batch * nout()));
+    auto output = (*this)(inputs);
+    auto loss = squared_error(output, targets);
+    return {output, loss};
+}
+
+void MLP::predict(const double *x, double *y) const {
+    if (m_layers.empty()) {
+        std::copy(x, x + m_nin, y);
+        return;
+    }
+    // Hidden activations alternate between the two halves of the scratch;
+    // the last layer writes straight into y
+    if (t_predict_scratch.size() < 2 * m_max_width) {
+        t_predict_scratch.resize(2 * m_max_width);
+    }
+    double *buffers[2] = {t_predict_scratch.data(), t_predict_scratch.data() + m_max_width};
+    const double *in = x;
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        double *out = l + 1 == m_layers.size() ? y : buffers[l % 2];
+        m_layers[l].predict(in, out);
+        in = out;
+    }
+}
+
+void MLP::predict(const double *x, double *y, std::size_t batch) const {
+    for (std::size_t i = 0; i < batch; ++i) {
+        predict(x + i * nin(), y + i * nout());
+    }
+}
+
+std::size_t MLP::nin() const {
+    return m_nin;
+}
+
+std::size_t MLP::nout() const {
+    return m_layers.empty() ? m_nin : m_layers.back().nout();
 }
\ No newline at end of file
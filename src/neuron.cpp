@@ -1,21 +1,55 @@
 #include "micrograd/neuron.hpp"
-#include <random> // For random weight initialization
 
-// Helper function for random number generation
-double random_uniform() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> dis(-1.0, 1.0);
-    return dis(gen);
+#include <algorithm>
+
+// ======== PARAMETER BLOCK ========
+ParameterBlock::ParameterBlock(std::size_t nout, std::size_t nin) : ParameterBlock(nout, nin, no_init) {
+    // Initialize weights with random values between -1 and 1; biases start at 0
+    init_weights(m_weights->data(), nout, nin, Init::Uniform, next_default_init_stream());
 }
 
-Neuron::Neuron(int nin) {
-    // Initialize weights with random values between -1 and 1
-    for (int i = 0; i < nin; ++i) {
-        m_w.push_back(make_value(random_uniform()));
+ParameterBlock::ParameterBlock(std::size_t nout, std::size_t nin, NoInit)
+    : m_nout(nout), m_nin(nin), m_weights(make_tensor(nout, nin)), m_bias(make_tensor(1, nout)) {
+    // The buffers never resize, so the views can point straight into them
+    m_values.reserve(nout * nin + nout);
+    for (std::size_t i = 0; i < nout * nin; ++i) {
+        m_values.emplace_back(m_weights->data() + i, m_weights->grad() + i);
+    }
+    for (std::size_t j = 0; j < nout; ++j) {
+        m_values.emplace_back(m_bias->data() + j, m_bias->grad() + j);
     }
-    // Initialize bias to 0 for simplicity (could also be random)
-    m_b = make_value(0.0);
+}
+
+ValuePtr ParameterBlock::weight_value(std::size_t row, std::size_t col) {
+    // Aliasing constructor: the view keeps the whole block alive
+    return ValuePtr(shared_from_this(), &m_values[row * m_nin + col]);
+}
+
+ValuePtr ParameterBlock::bias_value(std::size_t row) {
+    return ValuePtr(shared_from_this(), &m_values[m_nout * m_nin + row]);
+}
+
+void ParameterBlock::zero_grad() {
+    m_weights->zero_grad();
+    m_bias->zero_grad();
+}
+
+void ParameterBlock::initialize(Init scheme, const Rng &rng, ThreadPool *pool) {
+    init_weights(m_weights->data(), m_nout, m_nin, scheme, rng, pool);
+    std::fill(m_bias->data(), m_bias->data() + m_nout, 0.0);
+}
+
+// ======== NEURON ========
+Neuron::Neuron(int nin, Activation act)
+    : Neuron(std::make_shared<ParameterBlock>(1, static_cast<std::size_t>(nin)), 0, act) {}
+
+Neuron::Neuron(std::shared_ptr<ParameterBlock> block, std::size_t row, Activation act)
+    : m_block(std::move(block)), m_row(row), m_activation(act) {
+    m_w.reserve(m_block->nin());
+    for (std::size_t i = 0; i < m_block->nin(); ++i) {
+        m_w.push_back(m_block->weight_value(m_row, i));
+    }
+    m_b = m_block->bias_value(m_row);
 }
 
 ValuePtr Neuron::operator()(const std::vector<ValuePtr> &x) {
@@ -26,11 +60,29 @@ ValuePtr Neuron::operator()(const std::vector<ValuePtr> &x) {
         act = act + m_w[i] * x[i];
     }
     // Apply the activation function
-    return tanh(act);
+    return activate(act, m_activation);
 }
 
 std::vector<ValuePtr> Neuron::parameters() const {
     std::vector<ValuePtr> params = m_w;
     params.push_back(m_b);
     return params;
-}
\ No newline at end of file
+}
+
+const std::vector<ValuePtr> &Neuron::weights() const {
+    return m_w;
+}
+
+const ValuePtr &Neuron::bias() const {
+    return m_b;
+}
+
+Activation Neuron::activation() const {
+    return m_activation;
+}
+
+void Neuron::initialize(Init scheme, const Rng &rng) {
+    const std::size_t nin = m_block->nin();
+    init_row(m_block->weights()->data() + m_row * nin, m_block->nout(), nin, scheme, rng.stream(m_row));
+    m_block->bias()->data()[m_row] = 0.0;
+}
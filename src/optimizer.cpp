@@ -0,0 +1,107 @@
+#include "micrograd/optimizer.hpp"
+#include "micrograd/kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+// ======== OPTIMIZER ========
+Optimizer::Optimizer(std::vector<ParameterSpan> spans) : m_spans(std::move(spans)), m_size(0) {
+    m_offsets.reserve(m_spans.size());
+    for (const auto &span : m_spans) {
+        m_offsets.push_back(m_size);
+        m_size += span.size;
+    }
+}
+
+void Optimizer::step() {
+    begin_step();
+    for (std::size_t k = 0; k < m_spans.size(); ++k) {
+        update(k);
+    }
+}
+
+void Optimizer::zero_grad() {
+    for (const auto &span : m_spans) {
+        std::fill(span.grad, span.grad + span.size, 0.0);
+    }
+}
+
+std::size_t Optimizer::size() const {
+    return m_size;
+}
+
+const std::vector<ParameterSpan> &Optimizer::spans() const {
+    return m_spans;
+}
+
+// ======== SGD ========
+SGD::SGD(std::vector<ParameterSpan> spans, double learning_rate, double momentum)
+    : Optimizer(std::move(spans)), m_learning_rate(learning_rate), m_momentum(momentum) {
+    if (momentum < 0.0 || momentum >= 1.0) {
+        throw std::invalid_argument("SGD: momentum must be in [0, 1)");
+    }
+    if (momentum > 0.0) {
+        m_velocity.assign(m_size, 0.0);
+    }
+}
+
+void SGD::update(std::size_t k) {
+    const ParameterSpan &span = m_spans[k];
+    if (span.frozen()) {
+        return;
+    }
+    if (m_velocity.empty()) {
+        kernels::axpy(-m_learning_rate, span.grad, span.data, span.size);
+    } else {
+        kernels::momentum_update(span.data, span.grad, m_velocity.data() + m_offsets[k], m_learning_rate, m_momentum,
+                                 span.size);
+    }
+}
+
+void SGD::set_learning_rate(double learning_rate) {
+    m_learning_rate = learning_rate;
+}
+
+double SGD::learning_rate() const {
+    return m_learning_rate;
+}
+
+// ======== ADAM ========
+Adam::Adam(std::vector<ParameterSpan> spans, double learning_rate, double beta1, double beta2, double eps)
+    : Optimizer(std::move(spans)), m_learning_rate(learning_rate), m_beta1(beta1), m_beta2(beta2), m_eps(eps),
+      m_steps(0), m_step_size(0.0), m_inv_bias2(1.0), m_m(m_size, 0.0), m_v(m_size, 0.0) {
+    if (beta1 < 0.0 || beta1 >= 1.0 || beta2 < 0.0 || beta2 >= 1.0) {
+        throw std::invalid_argument("Adam: betas must be in [0, 1)");
+    }
+}
+
+void Adam::begin_step() {
+    ++m_steps;
+    // Fold both bias corrections into scalars so the kernel stays one pass
+    const double t = static_cast<double>(m_steps);
+    m_step_size = m_learning_rate / (1.0 - std::pow(m_beta1, t));
+    m_inv_bias2 = 1.0 / (1.0 - std::pow(m_beta2, t));
+}
+
+void Adam::update(std::size_t k) {
+    const ParameterSpan &span = m_spans[k];
+    if (span.frozen()) {
+        return;
+    }
+    kernels::adam_update(span.data, span.grad, m_m.data() + m_offsets[k], m_v.data() + m_offsets[k], m_beta1,
+                         m_beta2, m_step_size, m_inv_bias2, m_eps, span.size);
+}
+
+void Adam::set_learning_rate(double learning_rate) {
+    m_learning_rate = learning_rate;
+}
+
+double Adam::learning_rate() const {
+    return m_learning_rate;
+}
+
+std::uint64_t Adam::steps() const {
+    return m_steps;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file profile.cpp
+ * @brief Counters, event log and exporters behind profile.hpp
+ */
+
+#include "micrograd/profile.hpp"
+#include "micrograd/value.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace profile
+{
+namespace
+{
+constexpr std::size_t kOpCount = static_cast<std::size_t>(Op::SquaredError) + 1;
+constexpr std::size_t kAllocCount = static_cast<std::size_t>(Alloc::Tensor) + 1;
+/// Events kept for the trace; later events still reach the summary
+constexpr std::size_t kMaxTraceEvents = std::size_t(1) << 20;
+
+struct Event
+{
+    const char *name;
+    int layer;
+    unsigned thread;
+    double start_us;
+    double duration_us;
+};
+
+/// Aggregate of all events of one phase and layer
+struct Stat
+{
+    std::uint64_t calls = 0;
+    double total_us = 0.0;
+};
+
+struct State
+{
+    std::atomic<std::uint64_t> nodes[kOpCount] = {};
+    std::atomic<std::uint64_t> bytes[kAllocCount] = {};
+    std::mutex mutex; ///< Guards events and stats
+    std::vector<Event> events;
+    std::map<std::pair<std::string, int>, Stat> stats;
+    std::atomic<unsigned> next_thread{0};
+};
+
+/// Leaked like the label table, so worker threads can record during static destruction
+State &state()
+{
+    static State *s = new State();
+    return *s;
+}
+
+const std::chrono::steady_clock::time_point &epoch()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return start;
+}
+
+thread_local int t_current_layer = -1;
+
+unsigned thread_index()
+{
+    thread_local const unsigned index = state().next_thread.fetch_add(1);
+    return index;
+}
+
+const char *node_name(Op op)
+{
+    switch (op)
+    {
+    case Op::None:
+        return "leaf";
+    case Op::Const:
+        return "const";
+    default:
+        return op_name(op);
+    }
+}
+
+const char *alloc_name(Alloc kind)
+{
+    switch (kind)
+    {
+    case Alloc::Node:
+        return "nodes";
+    case Alloc::Tape:
+        return "tape blocks";
+    case Alloc::Tensor:
+        return "tensors";
+    }
+    return "";
+}
+
+std::string event_name(const char *name, int layer)
+{
+    return layer < 0 ? std::string(name) : std::string(name) + " layer " + std::to_string(layer);
+}
+} // namespace
+
+void count_node(Op op)
+{
+    state().nodes[static_cast<std::size_t>(op)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void count_bytes(Alloc kind, std::size_t bytes)
+{
+    state().bytes[static_cast<std::size_t>(kind)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+double now_us()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch()).count();
+}
+
+void record(const char *name, int layer, double start_us, double end_us)
+{
+    State &s = state();
+    const unsigned thread = thread_index();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.events.size() < kMaxTraceEvents)
+    {
+        s.events.push_back({name, layer, thread, start_us, end_us - start_us});
+    }
+    Stat &stat = s.stats[{name, layer}];
+    ++stat.calls;
+    stat.total_us += end_us - start_us;
+}
+
+int current_layer()
+{
+    return t_current_layer;
+}
+
+Scope::Scope(const char *name, int layer)
+    : m_name(name), m_layer(layer), m_outer_layer(t_current_layer), m_start_us(now_us())
+{
+    if (layer >= 0)
+    {
+        t_current_layer = layer;
+    }
+}
+
+Scope::~Scope()
+{
+    record(m_name, m_layer, m_start_us, now_us());
+    t_current_layer = m_outer_layer;
+}
+
+std::uint64_t nodes(Op op)
+{
+    return state().nodes[static_cast<std::size_t>(op)].load(std::memory_order_relaxed);
+}
+
+std::uint64_t bytes(Alloc kind)
+{
+    return state().bytes[static_cast<std::size_t>(kind)].load(std::memory_order_relaxed);
+}
+
+void reset()
+{
+    State &s = state();
+    for (auto &count : s.nodes)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+    for (auto &count : s.bytes)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.events.clear();
+    s.stats.clear();
+}
+
+std::string summary()
+{
+    if (!enabled)
+    {
+        return "profiling disabled (configure with -DMICROGRAD_ENABLE_PROFILING=ON)\n";
+    }
+    State &s = state();
+    std::ostringstream out;
+    char line[128];
+
+    out << "nodes created\n";
+    for (std::size_t i = 0; i < kOpCount; ++i)
+    {
+        const std::uint64_t count = nodes(static_cast<Op>(i));
+        if (count != 0)
+        {
+            std::snprintf(line, sizeof(line), "  %-24s %14llu\n", node_name(static_cast<Op>(i)),
+                          static_cast<unsigned long long>(count));
+            out << line;
+        }
+    }
+
+    out << "bytes allocated\n";
+    for (std::size_t i = 0; i < kAllocCount; ++i)
+    {
+        std::snprintf(line, sizeof(line), "  %-24s %14llu\n", alloc_name(static_cast<Alloc>(i)),
+                      static_cast<unsigned long long>(bytes(static_cast<Alloc>(i))));
+        out << line;
+    }
+
+    std::snprintf(line, sizeof(line), "%-26s %10s %14s %12s\n", "phase", "calls", "total ms", "mean us");
+    out << line;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (const auto &entry : s.stats)
+    {
+        const Stat &stat = entry.second;
+        std::snprintf(line, sizeof(line), "  %-24s %10llu %14.3f %12.3f\n",
+                      event_name(entry.first.first.c_str(), entry.first.second).c_str(),
+                      static_cast<unsigned long long>(stat.calls), stat.total_us / 1e3,
+                      stat.total_us / static_cast<double>(stat.calls));
+        out << line;
+    }
+    return out.str();
+}
+
+void write_chrome_trace(std::ostream &out)
+{
+    State &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    char number[64];
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (std::size_t i = 0; i < s.events.size(); ++i)
+    {
+        const Event &e = s.events[i];
+        // Names are string literals from the library, so they need no escaping
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << event_name(e.name, e.layer) << "\",\"cat\":\"" << e.name
+            << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread;
+        std::snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f", e.start_us, e.duration_us);
+        out << number;
+        if (e.layer >= 0)
+        {
+            out << ",\"args\":{\"layer\":" << e.layer << "}";
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+void write_chrome_trace(const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (out)
+    {
+        write_chrome_trace(out);
+    }
+    if (!out)
+    {
+        throw std::runtime_error("profile: cannot write trace " + path);
+    }
+}
+
+} // namespace profile
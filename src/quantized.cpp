@@ -0,0 +1,176 @@
+#include "micrograd/quantized.hpp"
+#include "micrograd/kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+constexpr float kTanhRange = 8.0f;     ///< tanh(8) rounds to 1 in float
+constexpr std::size_t kTanhSteps = 2048; ///< Table entries over [0, kTanhRange]
+
+/// tanh at kTanhSteps + 1 evenly spaced points of [0, kTanhRange], plus a guard entry
+const std::array<float, kTanhSteps + 2> &tanh_table() {
+    static const std::array<float, kTanhSteps + 2> table = [] {
+        std::array<float, kTanhSteps + 2> t{};
+        for (std::size_t i = 0; i < t.size(); ++i) {
+            t[i] = static_cast<float>(std::tanh(static_cast<double>(i) * kTanhRange / kTanhSteps));
+        }
+        return t;
+    }();
+    return table;
+}
+
+/// tanh by linear interpolation in the table; odd, so only x >= 0 is stored
+float lookup_tanh(float x) {
+    const float a = std::fabs(x);
+    if (!(a < kTanhRange)) {
+        return std::copysign(1.0f, x); // Also maps NaN to +-1 rather than indexing with it
+    }
+    const auto &table = tanh_table();
+    const float pos = a * (kTanhSteps / kTanhRange);
+    const std::size_t i = static_cast<std::size_t>(pos);
+    const float y = table[i] + (pos - static_cast<float>(i)) * (table[i + 1] - table[i]);
+    return std::copysign(y, x);
+}
+
+/// Step that maps max_abs onto 127; 1 for an all-zero range
+float symmetric_scale(double max_abs) {
+    return max_abs > 0.0 ? static_cast<float>(max_abs / 127.0) : 1.0f;
+}
+
+std::int8_t quantize(float x, float inv_scale) {
+    const float q = std::nearbyint(x * inv_scale);
+    return static_cast<std::int8_t>(std::max(-127.0f, std::min(127.0f, q)));
+}
+} // namespace
+
+QuantizedMLP::QuantizedMLP(const MLP &model, const double *calibration, std::size_t samples, WeightScale scale)
+    : m_nin(model.nin()), m_max_width(model.nin()) {
+    if (samples == 0 || calibration == nullptr) {
+        throw std::invalid_argument("QuantizedMLP: calibration needs at least one sample");
+    }
+    const auto &layers = model.layers();
+
+    // Largest magnitude reaching each layer's input on the calibration set
+    std::vector<double> input_range(layers.size(), 0.0);
+    std::size_t width = model.nin();
+    for (const Layer &layer : layers) {
+        width = std::max(width, layer.nout());
+    }
+    std::vector<double> a(width), b(width);
+    for (std::size_t s = 0; s < samples; ++s) {
+        std::copy(calibration + s * m_nin, calibration + (s + 1) * m_nin, a.begin());
+        for (std::size_t l = 0; l < layers.size(); ++l) {
+            for (std::size_t i = 0; i < layers[l].nin(); ++i) {
+                input_range[l] = std::max(input_range[l], std::fabs(a[i]));
+            }
+            layers[l].predict(a.data(), b.data());
+            std::swap(a, b);
+        }
+    }
+
+    for (std::size_t l = 0; l < layers.size(); ++l) {
+        const Layer &layer = layers[l];
+        const std::size_t nin = layer.nin(), nout = layer.nout();
+        const double *w = layer.weights()->data();
+        const double *bias = layer.bias()->data();
+        const float input_scale = symmetric_scale(input_range[l]);
+
+        // Per-row maxima, folded into one layer maximum when asked
+        std::vector<double> row_range(nout, 0.0);
+        for (std::size_t j = 0; j < nout; ++j) {
+            for (std::size_t i = 0; i < nin; ++i) {
+                row_range[j] = std::max(row_range[j], std::fabs(w[j * nin + i]));
+            }
+        }
+        if (scale == WeightScale::PerLayer && nout > 0) {
+            std::fill(row_range.begin(), row_range.end(), *std::max_element(row_range.begin(), row_range.end()));
+        }
+
+        QuantLayer q{nin, nout, std::vector<std::int8_t>(nin * nout), std::vector<float>(nout),
+                     std::vector<float>(bias, bias + nout), 1.0f / input_scale, layer.activation()};
+        for (std::size_t j = 0; j < nout; ++j) {
+            const float row_scale = symmetric_scale(row_range[j]);
+            for (std::size_t i = 0; i < nin; ++i) {
+                q.weights[j * nin + i] = quantize(static_cast<float>(w[j * nin + i]), 1.0f / row_scale);
+            }
+            q.dequant[j] = row_scale * input_scale;
+        }
+        m_layers.push_back(std::move(q));
+        m_max_width = std::max(m_max_width, nout);
+    }
+}
+
+void QuantizedMLP::predict(const float *x, float *y) const {
+    if (m_layers.empty()) {
+        std::copy(x, x + m_nin, y);
+        return;
+    }
+    // Float activations ping-pong as in MLP::predict(); each layer's input is
+    // requantized into the int8 scratch
+    thread_local std::vector<float> scratch;
+    thread_local std::vector<std::int8_t> quantized;
+    if (scratch.size() < 2 * m_max_width) {
+        scratch.resize(2 * m_max_width);
+    }
+    if (quantized.size() < m_max_width) {
+        quantized.resize(m_max_width);
+    }
+    float *buffers[2] = {scratch.data(), scratch.data() + m_max_width};
+    const float *in = x;
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        const QuantLayer &layer = m_layers[l];
+        float *out = l + 1 == m_layers.size() ? y : buffers[l % 2];
+        for (std::size_t i = 0; i < layer.nin; ++i) {
+            quantized[i] = quantize(in[i], layer.inv_input_scale);
+        }
+        for (std::size_t j = 0; j < layer.nout; ++j) {
+            const std::int32_t acc = kernels::dot(layer.weights.data() + j * layer.nin, quantized.data(), layer.nin);
+            const float sum = static_cast<float>(acc) * layer.dequant[j] + layer.bias[j];
+            out[j] = layer.activation == Activation::Tanh ? lookup_tanh(sum) : activation::apply(layer.activation, sum);
+        }
+        in = out;
+    }
+}
+
+void QuantizedMLP::predict(const float *x, float *y, std::size_t batch) const {
+    for (std::size_t i = 0; i < batch; ++i) {
+        predict(x + i * nin(), y + i * nout());
+    }
+}
+
+double QuantizedMLP::max_error(const MLP &model, const double *x, std::size_t samples) const {
+    if (model.nin() != nin() || model.nout() != nout()) {
+        throw std::invalid_argument("QuantizedMLP::max_error: model sizes differ");
+    }
+    std::vector<double> expected(nout());
+    std::vector<float> input(nin()), actual(nout());
+    double worst = 0.0;
+    for (std::size_t s = 0; s < samples; ++s) {
+        model.predict(x + s * nin(), expected.data());
+        std::transform(x + s * nin(), x + (s + 1) * nin(), input.begin(), [](double v) { return static_cast<float>(v); });
+        predict(input.data(), actual.data());
+        for (std::size_t j = 0; j < nout(); ++j) {
+            worst = std::max(worst, std::fabs(expected[j] - static_cast<double>(actual[j])));
+        }
+    }
+    return worst;
+}
+
+std::size_t QuantizedMLP::nin() const {
+    return m_nin;
+}
+
+std::size_t QuantizedMLP::nout() const {
+    return m_layers.empty() ? m_nin : m_layers.back().nout;
+}
+
+std::size_t QuantizedMLP::bytes() const {
+    std::size_t total = 0;
+    for (const QuantLayer &layer : m_layers) {
+        total += layer.weights.size() * sizeof(std::int8_t) + (layer.dequant.size() + layer.bias.size()) * sizeof(float);
+    }
+    return total;
+}
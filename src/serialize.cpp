@@ -0,0 +1,259 @@
+#include "micrograd/serialize.hpp"
+#include "micrograd/kernels.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MICROGRAD_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr char kMagic[4] = {'M', 'G', 'R', 'D'};
+constexpr std::uint32_t kVersion = 2;      ///< Written; 2 added the activations
+constexpr std::uint32_t kOldestVersion = 1; ///< Oldest still read; all-tanh networks
+constexpr std::uint32_t kByteOrderMark = 0x01020304u;
+constexpr std::size_t kFixedHeader = 40; ///< Bytes before the nouts array
+constexpr std::size_t kDataAlignment = 64;
+
+thread_local std::vector<double> t_predict_scratch; ///< Ping-pong activations for MappedModel::predict()
+
+template <typename T> void put(std::vector<unsigned char> &out, T value) {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof value);
+}
+
+template <typename T> T get(const unsigned char *bytes, std::size_t offset) {
+    T value;
+    std::memcpy(&value, bytes + offset, sizeof value);
+    return value;
+}
+
+[[noreturn]] void fail(const std::string &path, const char *what) {
+    throw std::runtime_error("MGRD file " + path + ": " + what);
+}
+
+/// Check the header and build views of the parameter blocks in a file image
+std::vector<MappedModel::LayerView> parse(const unsigned char *bytes, std::size_t length, const std::string &path,
+                                          std::size_t &nin) {
+    if (length < kFixedHeader || std::memcmp(bytes, kMagic, sizeof kMagic) != 0) {
+        fail(path, "not a model file");
+    }
+    const std::uint32_t version = get<std::uint32_t>(bytes, 4);
+    if (version < kOldestVersion || version > kVersion) {
+        fail(path, "unsupported format version");
+    }
+    if (get<std::uint32_t>(bytes, 8) != kByteOrderMark || get<std::uint32_t>(bytes, 12) != sizeof(double)) {
+        fail(path, "written with a different byte order or scalar type");
+    }
+    nin = get<std::uint64_t>(bytes, 16);
+    const std::uint64_t count = get<std::uint64_t>(bytes, 24);
+    const std::uint64_t offset = get<std::uint64_t>(bytes, 32);
+    const std::size_t entry = version >= 2 ? 9 : 8; ///< Header bytes per layer: nout, then an activation byte
+    if (nin > length / sizeof(double) || count > (length - kFixedHeader) / entry || offset % kDataAlignment != 0 ||
+        offset < kFixedHeader + entry * count || offset > length) {
+        fail(path, "corrupt header");
+    }
+
+    std::vector<MappedModel::LayerView> layers;
+    std::size_t in = nin, at = offset;
+    for (std::uint64_t l = 0; l < count; ++l) {
+        const std::size_t nout = get<std::uint64_t>(bytes, kFixedHeader + 8 * l);
+        const std::size_t doubles = nout * (in + 1);
+        if (nout == 0 || doubles / (in + 1) != nout || doubles > (length - at) / sizeof(double)) {
+            fail(path, "truncated parameter data");
+        }
+        const std::uint8_t act = version >= 2 ? bytes[kFixedHeader + 8 * count + l] : 0;
+        if (act > static_cast<std::uint8_t>(Activation::Gelu)) {
+            fail(path, "unknown activation");
+        }
+        const auto *weights = reinterpret_cast<const double *>(bytes + at);
+        layers.push_back({in, nout, static_cast<Activation>(act), weights, weights + nout * in});
+        at += doubles * sizeof(double);
+        in = nout;
+    }
+    return layers;
+}
+} // namespace
+
+void save_model(const MLP &model, const std::string &path) {
+    const auto &layers = model.layers();
+    const std::size_t header = kFixedHeader + 9 * layers.size();
+    const std::size_t offset = (header + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+
+    std::vector<unsigned char> head(kMagic, kMagic + sizeof kMagic);
+    put<std::uint32_t>(head, kVersion);
+    put<std::uint32_t>(head, kByteOrderMark);
+    put<std::uint32_t>(head, sizeof(double));
+    put<std::uint64_t>(head, model.nin());
+    put<std::uint64_t>(head, layers.size());
+    put<std::uint64_t>(head, offset);
+    for (const auto &layer : layers) {
+        put<std::uint64_t>(head, layer.nout());
+    }
+    for (const auto &layer : layers) {
+        put<std::uint8_t>(head, static_cast<std::uint8_t>(layer.activation()));
+    }
+    head.resize(offset, 0);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(head.data()), static_cast<std::streamsize>(head.size()));
+    // Each layer's weights and biases are already contiguous
+    for (const auto &span : model.parameter_spans()) {
+        out.write(reinterpret_cast<const char *>(span.data), static_cast<std::streamsize>(span.size * sizeof(double)));
+    }
+    out.close();
+    if (!out) {
+        fail(path, "write failed");
+    }
+}
+
+MLP load_model(const std::string &path) {
+    MappedModel mapped(path);
+    std::vector<int> nouts;
+    std::vector<Activation> activations;
+    for (const auto &layer : mapped.layers()) {
+        nouts.push_back(static_cast<int>(layer.nout));
+        activations.push_back(layer.activation);
+    }
+    MLP model(static_cast<int>(mapped.nin()), nouts, activations, no_init);
+    const auto &spans = model.parameter_spans();
+    for (std::size_t l = 0; l < mapped.layers().size(); ++l) {
+        const auto &layer = mapped.layers()[l];
+        std::copy(layer.weights, layer.weights + spans[2 * l].size, spans[2 * l].data);
+        std::copy(layer.bias, layer.bias + spans[2 * l + 1].size, spans[2 * l + 1].data);
+    }
+    return model;
+}
+
+MappedModel::MappedModel(const std::string &path) : m_base(nullptr), m_length(0), m_nin(0), m_max_width(0) {
+#if MICROGRAD_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fail(path, "cannot open");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        fail(path, "cannot stat");
+    }
+    m_length = static_cast<std::size_t>(st.st_size);
+    if (m_length > 0) {
+        void *base = ::mmap(nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0);
+        m_base = base == MAP_FAILED ? nullptr : base;
+    }
+    ::close(fd); // The mapping keeps the file referenced
+    if (!m_base) {
+        fail(path, m_length == 0 ? "not a model file" : "cannot map");
+    }
+#else
+    // Without mmap, fall back to one owned copy of the file
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        fail(path, "cannot open");
+    }
+    m_length = static_cast<std::size_t>(in.tellg());
+    m_base = ::operator new(m_length ? m_length : 1);
+    in.seekg(0);
+    in.read(static_cast<char *>(m_base), static_cast<std::streamsize>(m_length));
+    if (!in) {
+        release();
+        fail(path, "read failed");
+    }
+#endif
+
+    try {
+        m_layers = parse(static_cast<const unsigned char *>(m_base), m_length, path, m_nin);
+    } catch (...) {
+        release();
+        throw;
+    }
+    for (std::size_t l = 0; l + 1 < m_layers.size(); ++l) {
+        m_max_width = std::max(m_max_width, m_layers[l].nout);
+    }
+}
+
+MappedModel::~MappedModel() {
+    release();
+}
+
+MappedModel::MappedModel(MappedModel &&other) noexcept
+    : m_base(other.m_base), m_length(other.m_length), m_layers(std::move(other.m_layers)), m_nin(other.m_nin),
+      m_max_width(other.m_max_width) {
+    other.m_base = nullptr;
+    other.m_length = 0;
+}
+
+MappedModel &MappedModel::operator=(MappedModel &&other) noexcept {
+    if (this != &other) {
+        release();
+        m_base = other.m_base;
+        m_length = other.m_length;
+        m_layers = std::move(other.m_layers);
+        m_nin = other.m_nin;
+        m_max_width = other.m_max_width;
+        other.m_base = nullptr;
+        other.m_length = 0;
+    }
+    return *this;
+}
+
+void MappedModel::release() noexcept {
+    if (m_base) {
+#if MICROGRAD_HAVE_MMAP
+        ::munmap(m_base, m_length);
+#else
+        ::operator delete(m_base);
+#endif
+        m_base = nullptr;
+    }
+}
+
+void MappedModel::predict(const double *x, double *y) const {
+    if (m_layers.empty()) {
+        std::copy(x, x + m_nin, y);
+        return;
+    }
+    if (t_predict_scratch.size() < 2 * m_max_width) {
+        t_predict_scratch.resize(2 * m_max_width);
+    }
+    double *buffers[2] = {t_predict_scratch.data(), t_predict_scratch.data() + m_max_width};
+    const double *in = x;
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        const LayerView &layer = m_layers[l];
+        double *out = l + 1 == m_layers.size() ? y : buffers[l % 2];
+        if (layer.activation == Activation::Tanh) {
+            kernels::dense_tanh_forward(layer.weights, layer.bias, in, out, layer.nout, layer.nin);
+        } else {
+            for (std::size_t j = 0; j < layer.nout; ++j) {
+                out[j] = activation::apply(layer.activation,
+                                           kernels::dot(layer.weights + j * layer.nin, in, layer.nin) + layer.bias[j]);
+            }
+        }
+        in = out;
+    }
+}
+
+void MappedModel::predict(const double *x, double *y, std::size_t batch) const {
+    for (std::size_t i = 0; i < batch; ++i) {
+        predict(x + i * nin(), y + i * nout());
+    }
+}
+
+std::size_t MappedModel::nin() const {
+    return m_nin;
+}
+
+std::size_t MappedModel::nout() const {
+    return m_layers.empty() ? m_nin : m_layers.back().nout;
+}
+
+const std::vector<MappedModel::LayerView> &MappedModel::layers() const {
+    return m_layers;
+}
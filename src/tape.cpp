@@ -0,0 +1,142 @@
+/**
+ * @file tape.cpp
+ * @brief Implementation of the arena-backed Tape
+ */
+
+#include "micrograd/tape.hpp"
+
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+thread_local Tape *t_active_tape = nullptr; ///< Tape recording on this thread
+}
+
+// ======== TAPE ========
+Tape::Tape(std::size_t block_size) : m_block_size(block_size == 0 ? 1 : block_size), m_size(0) {}
+
+Tape::~Tape()
+{
+    clear();
+}
+
+Value *Tape::slot(std::size_t index) const
+{
+    Slot &s = m_blocks[index / m_block_size][index % m_block_size];
+    return std::launder(reinterpret_cast<Value *>(s.bytes));
+}
+
+void *Tape::next_slot()
+{
+    std::size_t block = m_size / m_block_size;
+    if (block == m_blocks.size())
+    {
+        m_blocks.emplace_back(new Slot[m_block_size]);
+        MICROGRAD_PROFILE_COUNT_BYTES(Tape, m_block_size * sizeof(Slot));
+    }
+    return m_blocks[block][m_size % m_block_size].bytes;
+}
+
+ValuePtr Tape::record(double data)
+{
+    Value *node = new (next_slot()) Value(data);
+    ++m_size;
+    // Aliasing constructor with an empty owner: no control block, no refcount
+    return ValuePtr(ValuePtr(), node);
+}
+
+ValuePtr Tape::record(double data, const std::string &label)
+{
+    Value *node = new (next_slot()) Value(data, label);
+    ++m_size;
+    return ValuePtr(ValuePtr(), node);
+}
+
+ValuePtr Tape::record(double data, ChildList children, Op op)
+{
+    Value *node = new (next_slot()) Value(data, std::move(children), op);
+    ++m_size;
+    return ValuePtr(ValuePtr(), node);
+}
+
+ValuePtr Tape::record(double data, ChildList children, Op op, const std::string &label)
+{
+    Value *node = new (next_slot()) Value(data, std::move(children), op, label);
+    ++m_size;
+    return ValuePtr(ValuePtr(), node);
+}
+
+std::size_t Tape::size() const
+{
+    return m_size;
+}
+
+Value &Tape::operator[](std::size_t index)
+{
+    return *slot(index);
+}
+
+const Value &Tape::operator[](std::size_t index) const
+{
+    return *slot(index);
+}
+
+void Tape::backward(const ValuePtr &root)
+{
+    // Locate the root; nodes recorded after it cannot contribute to its gradient
+    std::size_t end = m_size;
+    while (end > 0 && slot(end - 1) != root.get())
+    {
+        --end;
+    }
+    if (end == 0)
+    {
+        throw std::invalid_argument("Tape::backward: root was not recorded on this tape");
+    }
+
+    // Recording order is already topological, so the root's ancestors can be
+    // stamped during the sweep itself. Unstamped nodes belong to other roots
+    // and may still hold their gradients, which must not flow again.
+    const std::uint64_t epoch = Value::next_visit_epoch();
+    root->m_visit_epoch = epoch;
+    *root->m_grad = 1.0;
+    for (std::size_t i = end; i-- > 0;)
+    {
+        Value *node = slot(i);
+        if (node->m_visit_epoch != epoch)
+        {
+            continue;
+        }
+        for (const ValuePtr &child : node->m_prev)
+        {
+            child->m_visit_epoch = epoch;
+        }
+        node->backward_step();
+    }
+}
+
+void Tape::clear()
+{
+    // Destroy in reverse recording order, parents before their children
+    while (m_size > 0)
+    {
+        slot(--m_size)->~Value();
+    }
+}
+
+Tape *Tape::active()
+{
+    return t_active_tape;
+}
+
+// ======== TAPE SCOPE ========
+TapeScope::TapeScope(Tape &tape) : m_previous(t_active_tape)
+{
+    t_active_tape = &tape;
+}
+
+TapeScope::~TapeScope()
+{
+    t_active_tape = m_previous;
+}
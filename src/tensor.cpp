@@ -0,0 +1,817 @@
+/**
+ * @file tensor.cpp
+ * @brief Implementation of the Tensor class and its ops
+ */
+
+#include "micrograd/tensor.hpp"
+#include "micrograd/kernels.hpp"
+#include "micrograd/profile.hpp"
+#include "micrograd/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{
+std::atomic<std::uint64_t> g_tensor_visit_epoch{0}; ///< Last epoch handed out to a traversal
+
+/// One pending node of the explicit DFS stack
+struct TensorFrame
+{
+    Tensor *node;
+    std::size_t next_child;
+};
+
+/// Input-gradient columns per task of a threaded dense backward. A multiple
+/// of every SIMD width, so each element lands in the same vector lane as in
+/// the serial kernel and rounds identically.
+constexpr std::size_t kInputGradGrain = 256;
+
+/// Run body over [0, count), split across pool when there is one
+template <typename Body>
+void split(ThreadPool *pool, std::size_t count, const Body &body)
+{
+    if (pool)
+    {
+        pool->parallel_for(count, body);
+    }
+    else
+    {
+        body(0, count);
+    }
+}
+
+void require_same_shape(const TensorPtr &a, const TensorPtr &b, const char *op)
+{
+    if (a->rows() != b->rows() || a->cols() != b->cols())
+    {
+        throw std::invalid_argument(std::string(op) + ": shape mismatch");
+    }
+}
+
+/// log(sum exp(row[j])) with the maximum factored out, so no term overflows
+double row_logsumexp(const double *row, std::size_t k)
+{
+    double max = row[0];
+    for (std::size_t j = 1; j < k; ++j)
+    {
+        max = std::max(max, row[j]);
+    }
+    double total = 0.0;
+    for (std::size_t j = 0; j < k; ++j)
+    {
+        total += std::exp(row[j] - max);
+    }
+    return max + std::log(total);
+}
+
+/// The gradient buffer of an operand, or nullptr if it is frozen
+double *trained_grad(const TensorPtr &t)
+{
+    return t->requires_grad() ? t->grad() : nullptr;
+}
+} // namespace
+
+// ======== OPCODES =========
+const char *op_name(TensorOp op)
+{
+    switch (op)
+    {
+    case TensorOp::None:
+        return "";
+    case TensorOp::Add:
+        return "+";
+    case TensorOp::Sub:
+        return "-";
+    case TensorOp::Mul:
+        return "*";
+    case TensorOp::MatMul:
+        return "matmul";
+    case TensorOp::MatMulTransposed:
+        return "matmul_t";
+    case TensorOp::AddBias:
+        return "add_bias";
+    case TensorOp::Tanh:
+        return "tanh";
+    case TensorOp::Exp:
+        return "exp";
+    case TensorOp::Pow:
+        return "pow";
+    case TensorOp::Sum:
+        return "sum";
+    case TensorOp::FromValues:
+        return "from_values";
+    case TensorOp::DenseTanh:
+        return "dense_tanh";
+    case TensorOp::Recompute:
+        return "recompute";
+    case TensorOp::Activate:
+        return "activate";
+    case TensorOp::LogSumExp:
+        return "logsumexp";
+    case TensorOp::SoftmaxCrossEntropy:
+        return "softmax_xent";
+    case TensorOp::SquaredError:
+        return "squared_error";
+    }
+    return "?";
+}
+
+// ======== TENSOR CLASS CONSTRUCTORS =========
+Tensor::Tensor(std::size_t rows, std::size_t cols, double fill)
+    : m_rows(rows), m_cols(cols), m_data(rows * cols, fill), m_grad(rows * cols, 0.0), m_op(TensorOp::None),
+      m_aux(0.0), m_pool(nullptr), m_visit_epoch(0), m_requires_grad(true)
+{
+    MICROGRAD_PROFILE_COUNT_BYTES(Tensor, 2 * rows * cols * sizeof(double));
+}
+
+Tensor::Tensor(std::size_t rows, std::size_t cols, std::vector<double> data)
+    : m_rows(rows), m_cols(cols), m_data(std::move(data)), m_grad(rows * cols, 0.0), m_op(TensorOp::None),
+      m_aux(0.0), m_pool(nullptr), m_visit_epoch(0), m_requires_grad(true)
+{
+    if (m_data.size() != rows * cols)
+    {
+        throw std::invalid_argument("Tensor: data size does not match shape");
+    }
+    // The data buffer was allocated by the caller; count it here all the same
+    MICROGRAD_PROFILE_COUNT_BYTES(Tensor, 2 * rows * cols * sizeof(double));
+}
+
+Tensor::Tensor(std::size_t rows, std::size_t cols, std::vector<TensorPtr> children, TensorOp op)
+    : m_rows(rows), m_cols(cols), m_data(rows * cols, 0.0), m_grad(rows * cols, 0.0), m_op(op), m_aux(0.0),
+      m_prev(std::move(children)), m_pool(nullptr), m_visit_epoch(0), m_requires_grad(true)
+{
+    MICROGRAD_PROFILE_COUNT_BYTES(Tensor, 2 * rows * cols * sizeof(double));
+}
+
+// ======= MUTATORS ========
+void Tensor::zero_grad()
+{
+    std::fill(m_grad.begin(), m_grad.end(), 0.0);
+}
+
+void Tensor::set_requires_grad(bool requires_grad)
+{
+    if (!m_prev.empty())
+    {
+        throw std::invalid_argument("Tensor::set_requires_grad: only leaves can be marked");
+    }
+    m_requires_grad = requires_grad;
+}
+
+// ======== FACTORY FUNCTIONS ========
+TensorPtr make_tensor(std::size_t rows, std::size_t cols, double fill)
+{
+    return std::make_shared<Tensor>(rows, cols, fill);
+}
+TensorPtr make_tensor(std::size_t rows, std::size_t cols, std::vector<double> data)
+{
+    return std::make_shared<Tensor>(rows, cols, std::move(data));
+}
+
+TensorPtr from_values(const std::vector<ValuePtr> &values, std::size_t rows, std::size_t cols)
+{
+    if (values.size() != rows * cols)
+    {
+        throw std::invalid_argument("from_values: value count does not match shape");
+    }
+    auto out = std::make_shared<Tensor>(rows, cols, std::vector<TensorPtr>{}, TensorOp::FromValues);
+    double *y = out->data();
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        y[i] = values[i]->data();
+    }
+    out->m_sources = values;
+    return out;
+}
+
+// ======== TENSOR OPS ========
+TensorPtr operator+(const TensorPtr &lhs, const TensorPtr &rhs)
+{
+    require_same_shape(lhs, rhs, "operator+");
+    auto out = std::make_shared<Tensor>(lhs->rows(), lhs->cols(), std::vector<TensorPtr>{lhs, rhs}, TensorOp::Add);
+    const double *a = lhs->data(), *b = rhs->data();
+    double *y = out->data();
+    for (std::size_t i = 0, n = out->size(); i < n; ++i)
+    {
+        y[i] = a[i] + b[i];
+    }
+    return out;
+}
+
+TensorPtr operator-(const TensorPtr &lhs, const TensorPtr &rhs)
+{
+    require_same_shape(lhs, rhs, "operator-");
+    auto out = std::make_shared<Tensor>(lhs->rows(), lhs->cols(), std::vector<TensorPtr>{lhs, rhs}, TensorOp::Sub);
+    const double *a = lhs->data(), *b = rhs->data();
+    double *y = out->data();
+    for (std::size_t i = 0, n = out->size(); i < n; ++i)
+    {
+        y[i] = a[i] - b[i];
+    }
+    return out;
+}
+
+TensorPtr operator*(const TensorPtr &lhs, const TensorPtr &rhs)
+{
+    require_same_shape(lhs, rhs, "operator*");
+    auto out = std::make_shared<Tensor>(lhs->rows(), lhs->cols(), std::vector<TensorPtr>{lhs, rhs}, TensorOp::Mul);
+    const double *a = lhs->data(), *b = rhs->data();
+    double *y = out->data();
+    for (std::size_t i = 0, n = out->size(); i < n; ++i)
+    {
+        y[i] = a[i] * b[i];
+    }
+    return out;
+}
+
+TensorPtr matmul(const TensorPtr &a, const TensorPtr &b)
+{
+    if (a->cols() != b->rows())
+    {
+        throw std::invalid_argument("matmul: inner dimensions do not match");
+    }
+    const std::size_t m = a->rows(), k = a->cols(), n = b->cols();
+    auto out = std::make_shared<Tensor>(m, n, std::vector<TensorPtr>{a, b}, TensorOp::MatMul);
+    const double *A = a->data(), *B = b->data();
+    double *C = out->data();
+    // i-k-j order: row i of C accumulates contiguous rows of B
+    for (std::size_t i = 0; i < m; ++i)
+    {
+        for (std::size_t p = 0; p < k; ++p)
+        {
+            kernels::axpy(A[i * k + p], B + p * n, C + i * n, n);
+        }
+    }
+    return out;
+}
+
+TensorPtr matmul_transposed(const TensorPtr &a, const TensorPtr &b)
+{
+    if (a->cols() != b->cols())
+    {
+        throw std::invalid_argument("matmul_transposed: inner dimensions do not match");
+    }
+    const std::size_t m = a->rows(), k = a->cols(), n = b->rows();
+    auto out = std::make_shared<Tensor>(m, n, std::vector<TensorPtr>{a, b}, TensorOp::MatMulTransposed);
+    const double *A = a->data(), *B = b->data();
+    double *C = out->data();
+    // Every output element is a dot product of two contiguous rows
+    for (std::size_t i = 0; i < m; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            C[i * n + j] = kernels::dot(A + i * k, B + j * k, k);
+        }
+    }
+    return out;
+}
+
+TensorPtr dense_tanh(const TensorPtr &x, const TensorPtr &weights, const TensorPtr &bias, ThreadPool *pool)
+{
+    if (x->cols() != weights->cols() || bias->rows() != 1 || bias->cols() != weights->rows())
+    {
+        throw std::invalid_argument("dense_tanh: shapes do not match");
+    }
+    const std::size_t m = x->rows(), nin = x->cols(), nout = weights->rows();
+    auto out = std::make_shared<Tensor>(m, nout, std::vector<TensorPtr>{x, weights, bias}, TensorOp::DenseTanh);
+    out->m_pool = pool;
+    const double *W = weights->data(), *b = bias->data(), *X = x->data();
+    double *Y = out->data();
+    split(pool, nout, [&](std::size_t j0, std::size_t j1) {
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            kernels::dense_tanh_forward(W + j0 * nin, b + j0, X + i * nin, Y + i * nout + j0, j1 - j0, nin);
+        }
+    });
+    return out;
+}
+
+TensorPtr checkpoint_dense_tanh(const TensorPtr &x, const std::vector<TensorPtr> &layers, ThreadPool *pool)
+{
+    if (layers.empty() || layers.size() % 2 != 0)
+    {
+        throw std::invalid_argument("checkpoint_dense_tanh: expected weight and bias pairs");
+    }
+    // The inner nodes die as soon as this scope ends; dense_tanh checks the shapes
+    TensorPtr h = x;
+    for (std::size_t l = 0; l < layers.size(); l += 2)
+    {
+        h = dense_tanh(h, layers[l], layers[l + 1], pool);
+    }
+
+    std::vector<TensorPtr> children;
+    children.reserve(layers.size() + 1);
+    children.push_back(x);
+    children.insert(children.end(), layers.begin(), layers.end());
+    auto out = std::make_shared<Tensor>(h->rows(), h->cols(), std::move(children), TensorOp::Recompute);
+    out->m_pool = pool;
+    out->m_data = std::move(h->m_data);
+    return out;
+}
+
+TensorPtr add_bias(const TensorPtr &x, const TensorPtr &bias)
+{
+    if (bias->rows() != 1 || bias->cols() != x->cols())
+    {
+        throw std::invalid_argument("add_bias: bias must be 1 x cols(x)");
+    }
+    const std::size_t m = x->rows(), n = x->cols();
+    auto out = std::make_shared<Tensor>(m, n, std::vector<TensorPtr>{x, bias}, TensorOp::AddBias);
+    const double *X = x->data(), *b = bias->data();
+    double *Y = out->data();
+    for (std::size_t i = 0; i < m; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            Y[i * n + j] = X[i * n + j] + b[j];
+        }
+    }
+    return out;
+}
+
+TensorPtr tanh(const TensorPtr &x)
+{
+    auto out = std::make_shared<Tensor>(x->rows(), x->cols(), std::vector<TensorPtr>{x}, TensorOp::Tanh);
+    const double *X = x->data();
+    double *Y = out->data();
+    for (std::size_t i = 0, n = out->size(); i < n; ++i)
+    {
+        Y[i] = std::tanh(X[i]);
+    }
+    return out;
+}
+
+TensorPtr exp(const TensorPtr &x)
+{
+    auto out = std::make_shared<Tensor>(x->rows(), x->cols(), std::vector<TensorPtr>{x}, TensorOp::Exp);
+    const double *X = x->data();
+    double *Y = out->data();
+    for (std::size_t i = 0, n = out->size(); i < n; ++i)
+    {
+        Y[i] = std::exp(X[i]);
+    }
+    return out;
+}
+
+TensorPtr pow(const TensorPtr &base, double exp_val)
+{
+    auto out = std::make_shared<Tensor>(base->rows(), base->cols(), std::vector<TensorPtr>{base}, TensorOp::Pow);
+    out->m_aux = exp_val;
+    const double *X = base->data();
+    double *Y = out->data();
+    for (std::size_t i = 0, n = out->size(); i < n; ++i)
+    {
+        Y[i] = std::pow(X[i], exp_val);
+    }
+    return out;
+}
+
+TensorPtr sum(const TensorPtr &x)
+{
+    auto out = std::make_shared<Tensor>(1, 1, std::vector<TensorPtr>{x}, TensorOp::Sum);
+    const double *X = x->data();
+    double acc = 0.0;
+    for (std::size_t i = 0, n = x->size(); i < n; ++i)
+    {
+        acc += X[i];
+    }
+    out->data()[0] = acc;
+    return out;
+}
+
+TensorPtr activate(const TensorPtr &x, Activation act)
+{
+    if (act == Activation::Tanh)
+    {
+        return tanh(x);
+    }
+    if (act == Activation::Linear)
+    {
+        return x;
+    }
+    auto out = std::make_shared<Tensor>(x->rows(), x->cols(), std::vector<TensorPtr>{x}, TensorOp::Activate);
+    out->m_aux = static_cast<double>(act);
+    const double *X = x->data();
+    double *Y = out->data();
+    for (std::size_t i = 0, n = out->size(); i < n; ++i)
+    {
+        Y[i] = activation::apply(act, X[i]);
+    }
+    return out;
+}
+
+// ======== FUSED LOSSES ========
+TensorPtr logsumexp(const TensorPtr &x)
+{
+    if (x->cols() == 0)
+    {
+        throw std::invalid_argument("logsumexp: no columns");
+    }
+    auto out = std::make_shared<Tensor>(x->rows(), 1, std::vector<TensorPtr>{x}, TensorOp::LogSumExp);
+    for (std::size_t i = 0; i < x->rows(); ++i)
+    {
+        out->data()[i] = row_logsumexp(x->data() + i * x->cols(), x->cols());
+    }
+    return out;
+}
+
+TensorPtr softmax_cross_entropy(const TensorPtr &logits, const std::vector<std::size_t> &classes)
+{
+    const std::size_t m = logits->rows(), k = logits->cols();
+    if (classes.size() != m || m == 0)
+    {
+        throw std::invalid_argument("softmax_cross_entropy: need one class per row");
+    }
+    // The classes ride along as a leaf so backward can find them
+    auto targets = make_tensor(m, 1);
+    double loss = 0.0;
+    for (std::size_t i = 0; i < m; ++i)
+    {
+        if (classes[i] >= k)
+        {
+            throw std::invalid_argument("softmax_cross_entropy: class out of range");
+        }
+        targets->data()[i] = static_cast<double>(classes[i]);
+        const double *row = logits->data() + i * k;
+        loss += row_logsumexp(row, k) - row[classes[i]];
+    }
+    auto out = std::make_shared<Tensor>(1, 1, std::vector<TensorPtr>{logits, targets}, TensorOp::SoftmaxCrossEntropy);
+    out->data()[0] = loss / static_cast<double>(m);
+    return out;
+}
+
+TensorPtr squared_error(const TensorPtr &predictions, const TensorPtr &targets, double scale)
+{
+    require_same_shape(predictions, targets, "squared_error");
+    auto out = std::make_shared<Tensor>(1, 1, std::vector<TensorPtr>{predictions, targets}, TensorOp::SquaredError);
+    out->m_aux = scale;
+    const double *P = predictions->data(), *T = targets->data();
+    double acc = 0.0;
+    for (std::size_t i = 0, n = predictions->size(); i < n; ++i)
+    {
+        const double d = P[i] - T[i];
+        acc += d * d;
+    }
+    out->data()[0] = scale * acc;
+    return out;
+}
+
+TensorPtr mse(const TensorPtr &predictions, const TensorPtr &targets)
+{
+    const std::size_t n = predictions->size();
+    return squared_error(predictions, targets, 1.0 / static_cast<double>(n == 0 ? 1 : n));
+}
+
+// ======== BACKPROPAGATION ========
+void Tensor::build_topo(std::vector<Tensor *> &order)
+{
+    thread_local std::vector<TensorFrame> stack;
+
+    const std::uint64_t epoch = g_tensor_visit_epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+    order.clear();
+    stack.clear();
+
+    m_visit_epoch = epoch;
+    stack.push_back({this, 0});
+    while (!stack.empty())
+    {
+        TensorFrame &frame = stack.back();
+        if (frame.next_child < frame.node->m_prev.size())
+        {
+            Tensor *child = frame.node->m_prev[frame.next_child++].get();
+            if (child->m_visit_epoch != epoch)
+            {
+                child->m_visit_epoch = epoch;
+                stack.push_back({child, 0}); // invalidates frame
+            }
+        }
+        else
+        {
+            order.push_back(frame.node);
+            stack.pop_back();
+        }
+    }
+}
+
+void Tensor::backward()
+{
+    thread_local std::vector<Tensor *> order;
+    build_topo(order);
+    backward(order);
+}
+
+void Tensor::backward(const std::vector<Tensor *> &order)
+{
+    if (order.empty() || order.back() != this)
+    {
+        throw std::invalid_argument("Tensor::backward: order was not built from this Tensor");
+    }
+
+    std::fill(m_grad.begin(), m_grad.end(), 1.0);
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+    {
+        (*it)->backward_step();
+    }
+}
+
+void Tensor::backward(const std::vector<Tensor *> &order, const std::function<void(std::size_t)> &after_step)
+{
+    if (order.empty() || order.back() != this)
+    {
+        throw std::invalid_argument("Tensor::backward: order was not built from this Tensor");
+    }
+
+    std::fill(m_grad.begin(), m_grad.end(), 1.0);
+    for (std::size_t i = order.size(); i-- > 0;)
+    {
+        order[i]->backward_step();
+        after_step(i);
+    }
+}
+
+void Tensor::backward_step()
+{
+    const double *G = m_grad.data();
+    const std::size_t size = m_data.size();
+    switch (m_op)
+    {
+    case TensorOp::None:
+        break;
+    case TensorOp::Add:
+    case TensorOp::Sub:
+    {
+        double *da = m_prev[0]->grad();
+        double *db = m_prev[1]->grad();
+        const double sign = m_op == TensorOp::Add ? 1.0 : -1.0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            da[i] += G[i];
+            db[i] += sign * G[i];
+        }
+        break;
+    }
+    case TensorOp::Mul:
+    {
+        const double *a = m_prev[0]->data(), *b = m_prev[1]->data();
+        double *da = m_prev[0]->grad();
+        double *db = m_prev[1]->grad();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            da[i] += b[i] * G[i];
+            db[i] += a[i] * G[i];
+        }
+        break;
+    }
+    case TensorOp::MatMul:
+    {
+        // C = A . B:  dA += dC . B^T,  dB += A^T . dC
+        const Tensor &a = *m_prev[0], &b = *m_prev[1];
+        const std::size_t m = a.m_rows, k = a.m_cols, n = b.m_cols;
+        const double *A = a.data(), *B = b.data();
+        double *dA = trained_grad(m_prev[0]);
+        double *dB = trained_grad(m_prev[1]);
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            for (std::size_t p = 0; p < k; ++p)
+            {
+                if (dA)
+                {
+                    dA[i * k + p] += kernels::dot(G + i * n, B + p * n, n);
+                }
+                if (dB)
+                {
+                    kernels::axpy(A[i * k + p], G + i * n, dB + p * n, n);
+                }
+            }
+        }
+        break;
+    }
+    case TensorOp::MatMulTransposed:
+    {
+        // C = A . B^T:  dA[i] += sum_j dC[i][j] * B[j],  dB[j] += sum_i dC[i][j] * A[i]
+        const Tensor &a = *m_prev[0], &b = *m_prev[1];
+        const std::size_t m = a.m_rows, k = a.m_cols, n = b.m_rows;
+        const double *A = a.data(), *B = b.data();
+        double *dA = trained_grad(m_prev[0]);
+        double *dB = trained_grad(m_prev[1]);
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                const double g = G[i * n + j];
+                if (dA)
+                {
+                    kernels::axpy(g, B + j * k, dA + i * k, k);
+                }
+                if (dB)
+                {
+                    kernels::axpy(g, A + i * k, dB + j * k, k);
+                }
+            }
+        }
+        break;
+    }
+    case TensorOp::AddBias:
+    {
+        double *dX = trained_grad(m_prev[0]);
+        double *db = trained_grad(m_prev[1]);
+        for (std::size_t i = 0; dX && i < m_rows; ++i)
+        {
+            for (std::size_t j = 0; j < m_cols; ++j)
+            {
+                dX[i * m_cols + j] += G[i * m_cols + j];
+            }
+        }
+        for (std::size_t i = 0; db && i < m_rows; ++i)
+        {
+            for (std::size_t j = 0; j < m_cols; ++j)
+            {
+                db[j] += G[i * m_cols + j];
+            }
+        }
+        break;
+    }
+    case TensorOp::Tanh:
+    {
+        // d tanh(x) = 1 - tanh(x)^2, reusing the forward output
+        double *dX = m_prev[0]->grad();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            dX[i] += (1 - m_data[i] * m_data[i]) * G[i];
+        }
+        break;
+    }
+    case TensorOp::Exp:
+    {
+        double *dX = m_prev[0]->grad();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            dX[i] += m_data[i] * G[i];
+        }
+        break;
+    }
+    case TensorOp::Pow:
+    {
+        const double *X = m_prev[0]->data();
+        double *dX = m_prev[0]->grad();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            dX[i] += (m_aux * std::pow(X[i], m_aux - 1)) * G[i];
+        }
+        break;
+    }
+    case TensorOp::Sum:
+    {
+        double *dX = m_prev[0]->grad();
+        for (std::size_t i = 0, n = m_prev[0]->size(); i < n; ++i)
+        {
+            dX[i] += G[0];
+        }
+        break;
+    }
+    case TensorOp::FromValues:
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            m_sources[i]->add_to_grad(G[i]);
+        }
+        break;
+    case TensorOp::Activate:
+    {
+        const Activation act = static_cast<Activation>(static_cast<int>(m_aux));
+        const double *X = m_prev[0]->data();
+        double *dX = m_prev[0]->grad();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            dX[i] += activation::derivative(act, X[i], m_data[i]) * G[i];
+        }
+        break;
+    }
+    case TensorOp::LogSumExp:
+    {
+        // d lse_i / dx_ij = softmax(x_i)_j = exp(x_ij - lse_i)
+        const std::size_t k = m_prev[0]->cols();
+        const double *X = m_prev[0]->data();
+        double *dX = m_prev[0]->grad();
+        for (std::size_t i = 0; i < m_rows; ++i)
+        {
+            for (std::size_t j = 0; j < k; ++j)
+            {
+                dX[i * k + j] += std::exp(X[i * k + j] - m_data[i]) * G[i];
+            }
+        }
+        break;
+    }
+    case TensorOp::SoftmaxCrossEntropy:
+    {
+        const std::size_t m = m_prev[0]->rows(), k = m_prev[0]->cols();
+        const double *X = m_prev[0]->data(), *classes = m_prev[1]->data();
+        double *dX = m_prev[0]->grad();
+        const double g = G[0] / static_cast<double>(m);
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            const double *row = X + i * k;
+            const double lse = row_logsumexp(row, k);
+            const std::size_t target = static_cast<std::size_t>(classes[i]);
+            for (std::size_t j = 0; j < k; ++j)
+            {
+                dX[i * k + j] += (std::exp(row[j] - lse) - (j == target ? 1.0 : 0.0)) * g;
+            }
+        }
+        break;
+    }
+    case TensorOp::SquaredError:
+    {
+        const double *P = m_prev[0]->data(), *T = m_prev[1]->data();
+        double *dP = m_prev[0]->grad(), *dT = m_prev[1]->grad();
+        for (std::size_t i = 0, n = m_prev[0]->size(); i < n; ++i)
+        {
+            const double d = 2.0 * m_aux * (P[i] - T[i]) * G[0];
+            dP[i] += d;
+            dT[i] -= d;
+        }
+        break;
+    }
+    case TensorOp::DenseTanh:
+    {
+        const Tensor &x = *m_prev[0], &w = *m_prev[1];
+        const std::size_t m = m_rows, nin = x.m_cols, nout = w.m_rows;
+        const double *W = w.data(), *X = x.data(), *Y = m_data.data();
+        double *dX = trained_grad(m_prev[0]), *dW = trained_grad(m_prev[1]), *db = trained_grad(m_prev[2]);
+        if (!m_pool)
+        {
+            for (std::size_t i = 0; i < m; ++i)
+            {
+                kernels::dense_tanh_backward(W, X + i * nin, Y + i * nout, G + i * nout, dW, db,
+                                             dX ? dX + i * nin : nullptr, nout, nin);
+            }
+            break;
+        }
+
+        // Weight and bias rows belong to one neuron each
+        if (dW || db)
+        {
+            m_pool->parallel_for(nout, [&](std::size_t j0, std::size_t j1) {
+                for (std::size_t i = 0; i < m; ++i)
+                {
+                    kernels::dense_tanh_backward(W + j0 * nin, X + i * nin, Y + i * nout + j0, G + i * nout + j0,
+                                                 dW ? dW + j0 * nin : nullptr, db ? db + j0 : nullptr, nullptr,
+                                                 j1 - j0, nin);
+                }
+            });
+        }
+        if (!dX)
+        {
+            break;
+        }
+
+        // Every neuron feeds every input, so dX is split by (row, column block)
+        // instead and each block sums over all neurons in order
+        const std::size_t blocks = (nin + kInputGradGrain - 1) / kInputGradGrain;
+        m_pool->parallel_for(m * blocks, [&](std::size_t t0, std::size_t t1) {
+            for (std::size_t t = t0; t < t1; ++t)
+            {
+                const std::size_t i = t / blocks, c0 = (t % blocks) * kInputGradGrain;
+                const std::size_t len = std::min(kInputGradGrain, nin - c0);
+                for (std::size_t j = 0; j < nout; ++j)
+                {
+                    const double y = Y[i * nout + j];
+                    const double d = G[i * nout + j] * (1 - y * y);
+                    kernels::axpy(d, W + j * nin + c0, dX + i * nin + c0, len);
+                }
+            }
+        });
+        break;
+    }
+    case TensorOp::Recompute:
+    {
+        // Rebuild the stack from a copy of the input, so its gradient can be
+        // added into the real input once; the parameters are the real leaves
+        const Tensor &x = *m_prev[0];
+        auto input = std::make_shared<Tensor>(x.m_rows, x.m_cols, x.m_data);
+        TensorPtr h = input;
+        for (std::size_t l = 1; l + 1 < m_prev.size(); l += 2)
+        {
+            h = dense_tanh(h, m_prev[l], m_prev[l + 1], m_pool);
+        }
+
+        // Seed with this node's gradient instead of ones
+        std::vector<Tensor *> order;
+        h->build_topo(order);
+        std::copy(m_grad.begin(), m_grad.end(), h->m_grad.begin());
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            (*it)->backward_step();
+        }
+        if (double *dX = trained_grad(m_prev[0]))
+        {
+            kernels::axpy(1.0, input->grad(), dX, input->size());
+        }
+        break;
+    }
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Implementation of the ThreadPool
+ */
+
+#include "micrograd/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+thread_local bool t_in_parallel_for = false; ///< Set while this thread runs a chunk
+}
+
+ThreadPool::ThreadPool(std::size_t threads)
+    : m_body(nullptr), m_count(0), m_chunks(0), m_next(0), m_finished(0), m_active(0), m_generation(0),
+      m_stop(false)
+{
+    for (std::size_t i = 1; i < threads; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const
+{
+    return m_workers.size() + 1;
+}
+
+void ThreadPool::parallel_for(std::size_t count, const RangeFn &body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (m_workers.empty() || count == 1 || t_in_parallel_for)
+    {
+        body(0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submit);
+    const std::size_t chunks = std::min(count, size());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_body = &body;
+        m_count = count;
+        m_chunks = chunks;
+        m_next.store(0, std::memory_order_relaxed);
+        m_finished = 0;
+        m_error = nullptr;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    run_chunks(body, count, chunks);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // Wait for stragglers to drop their copy of the job before it goes out of scope
+        m_done.wait(lock, [&] { return m_finished == chunks && m_active == 0; });
+        m_body = nullptr;
+        error = m_error;
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::run_chunks(const RangeFn &body, std::size_t count, std::size_t chunks)
+{
+    t_in_parallel_for = true;
+    std::size_t done = 0;
+    for (std::size_t c; (c = m_next.fetch_add(1, std::memory_order_relaxed)) < chunks;)
+    {
+        try
+        {
+            body(c * count / chunks, (c + 1) * count / chunks);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error)
+            {
+                m_error = std::current_exception();
+            }
+        }
+        ++done;
+    }
+    t_in_parallel_for = false;
+
+    if (done > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished += done;
+    }
+}
+
+void ThreadPool::worker_loop()
+{
+    std::uint64_t seen = 0;
+    for (;;)
+    {
+        const RangeFn *body;
+        std::size_t count, chunks;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop)
+            {
+                return;
+            }
+            seen = m_generation;
+            if (!m_body)
+            {
+                continue; // Woke after the job had already completed
+            }
+            body = m_body;
+            count = m_count;
+            chunks = m_chunks;
+            ++m_active;
+        }
+
+        run_chunks(*body, count, chunks);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_active;
+        }
+        m_done.notify_one();
+    }
+}
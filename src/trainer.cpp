@@ -0,0 +1,239 @@
+#include "micrograd/trainer.hpp"
+#include "micrograd/dataset.hpp"
+#include "micrograd/kernels.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+std::vector<int> layer_sizes(const MLP &model) {
+    std::vector<int> nouts;
+    for (const auto &layer : model.layers()) {
+        nouts.push_back(static_cast<int>(layer.nout()));
+    }
+    return nouts;
+}
+
+/// Sum per-shard gradients pairwise (0+1, 2+3, ..., then 0+2, ...) and add the
+/// total into target's grad; split by element so every level runs in parallel
+void tree_reduce(ThreadPool &pool, const std::vector<double *> &grads, const ParameterSpan &target) {
+    const std::size_t shards = grads.size();
+    pool.parallel_for(target.size, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t stride = 1; stride < shards; stride *= 2) {
+            for (std::size_t t = 0; t + stride < shards; t += 2 * stride) {
+                kernels::axpy(1.0, grads[t + stride] + begin, grads[t] + begin, end - begin);
+            }
+        }
+        kernels::axpy(1.0, grads[0] + begin, target.grad + begin, end - begin);
+    });
+}
+} // namespace
+
+Trainer::Trainer(MLP &model, std::size_t threads)
+    : m_model(model), m_losses(threads, 0.0), m_shard_grads(threads, nullptr), m_pool(threads) {
+    if (threads == 0) {
+        throw std::invalid_argument("Trainer: threads must be positive");
+    }
+    const std::vector<int> nouts = layer_sizes(model);
+    const std::vector<Activation> activations = model.activations();
+    m_replicas.reserve(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+        // Replicas are synced from the model before use, so they draw no weights
+        m_replicas.emplace_back(static_cast<int>(model.nin()), nouts, activations, no_init);
+    }
+}
+
+double Trainer::backward_batch(const double *x, const double *y, std::size_t batch) {
+    const std::size_t shards = m_replicas.size(), nin = m_model.nin(), nout = m_model.nout();
+    std::fill(m_losses.begin(), m_losses.end(), 0.0);
+
+    m_pool.parallel_for(shards, [&](std::size_t first, std::size_t last) {
+        for (std::size_t t = first; t < last; ++t) {
+            MLP &replica = m_replicas[t];
+            sync_replica(replica);
+            replica.zero_grad();
+            const std::size_t begin = t * batch / shards, end = (t + 1) * batch / shards;
+            if (end > begin) {
+                BatchOutput out = replica.forward_batch(x + begin * nin, y + begin * nout, end - begin);
+                out.loss->backward();
+                m_losses[t] = out.loss->at(0, 0);
+            }
+        }
+    });
+
+    reduce_gradients();
+
+    double loss = 0.0;
+    for (double l : m_losses) {
+        loss += l;
+    }
+    return loss;
+}
+
+double Trainer::step(const double *x, const double *y, std::size_t batch, double learning_rate) {
+    m_model.zero_grad();
+    const double loss = backward_batch(x, y, batch);
+    for (const auto &span : m_model.parameter_spans()) {
+        if (!span.frozen()) {
+            kernels::axpy(-learning_rate, span.grad, span.data, span.size);
+        }
+    }
+    return loss;
+}
+
+double Trainer::step(const double *x, const double *y, std::size_t batch, Optimizer &optimizer) {
+    optimizer.zero_grad();
+    const double loss = backward_batch(x, y, batch);
+    optimizer.step();
+    return loss;
+}
+
+std::size_t Trainer::threads() const {
+    return m_replicas.size();
+}
+
+void Trainer::sync_replica(MLP &replica) const {
+    const auto &src = m_model.parameter_spans();
+    const auto &dst = replica.parameter_spans();
+    for (std::size_t k = 0; k < src.size(); ++k) {
+        std::copy(src[k].data, src[k].data + src[k].size, dst[k].data);
+    }
+    replica.set_checkpoint_interval(m_model.checkpoint_interval());
+    for (std::size_t l = 0; l < m_model.layers().size(); ++l) {
+        const bool requires_grad = m_model.layers()[l].requires_grad();
+        if (replica.layers()[l].requires_grad() != requires_grad) {
+            replica.set_requires_grad(l, requires_grad);
+        }
+    }
+}
+
+void Trainer::reduce_gradients() {
+    const auto &targets = m_model.parameter_spans();
+    for (std::size_t k = 0; k < targets.size(); ++k) {
+        for (std::size_t t = 0; t < m_replicas.size(); ++t) {
+            m_shard_grads[t] = m_replicas[t].parameter_spans()[k].grad;
+        }
+        tree_reduce(m_pool, m_shard_grads, targets[k]);
+    }
+}
+
+// ======== PIPELINED TRAINER ========
+PipelinedTrainer::PipelinedTrainer(MLP &model, Optimizer &optimizer)
+    : m_model(model), m_optimizer(optimizer), m_queue_head(0), m_stop(false), m_busy(false) {
+    const auto &ours = model.parameter_spans(), &theirs = optimizer.spans();
+    bool same = ours.size() == theirs.size();
+    for (std::size_t k = 0; same && k < ours.size(); ++k) {
+        same = ours[k].data == theirs[k].data && ours[k].size == theirs[k].size;
+    }
+    if (!same) {
+        throw std::invalid_argument("PipelinedTrainer: optimizer must cover exactly the model's parameter spans");
+    }
+    for (std::size_t l = 0; l < model.layers().size(); ++l) {
+        m_layer_of[model.layers()[l].weights().get()] = l;
+        m_layer_of[model.layers()[l].bias().get()] = l;
+    }
+    m_model.zero_grad();
+    m_thread = std::thread(&PipelinedTrainer::update_loop, this);
+}
+
+PipelinedTrainer::~PipelinedTrainer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+}
+
+double PipelinedTrainer::step(const double *x, const double *y, std::size_t batch) {
+    // The previous step's last updates must land before the forward pass reads them
+    synchronize();
+    BatchOutput out = m_model.forward_batch(x, y, batch);
+    out.loss->build_topo(m_order);
+
+    const std::size_t layers = m_model.layers().size();
+    m_last_use.assign(layers, m_order.size());
+    for (std::size_t i = 0; i < m_order.size(); ++i) {
+        for (const TensorPtr &parent : m_order[i]->prev()) {
+            auto it = m_layer_of.find(parent.get());
+            if (it != m_layer_of.end()) {
+                m_last_use[it->second] = std::min(m_last_use[it->second], i);
+            }
+        }
+    }
+    m_by_use.resize(layers);
+    std::iota(m_by_use.begin(), m_by_use.end(), std::size_t(0));
+    std::sort(m_by_use.begin(), m_by_use.end(), [this](std::size_t a, std::size_t b) {
+        return m_last_use[a] != m_last_use[b] ? m_last_use[a] > m_last_use[b] : a > b;
+    });
+
+    m_optimizer.begin_step();
+    std::size_t next = 0;
+    out.loss->backward(m_order, [&](std::size_t i) {
+        while (next < layers && m_last_use[m_by_use[next]] >= i) {
+            post(m_by_use[next++]);
+        }
+    });
+    m_order.clear();
+    return out.loss->at(0, 0);
+}
+
+double PipelinedTrainer::run_epoch(BatchLoader &loader) {
+    double loss = 0.0;
+    while (const Batch *b = loader.next()) {
+        loss += step(b->x, b->y, b->size);
+    }
+    return loss;
+}
+
+void PipelinedTrainer::synchronize() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this] { return m_queue_head == m_queue.size() && !m_busy; });
+    m_queue.clear();
+    m_queue_head = 0;
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void PipelinedTrainer::post(std::size_t layer) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(layer);
+    }
+    m_changed.notify_all();
+}
+
+void PipelinedTrainer::update_loop() {
+    const auto &spans = m_optimizer.spans();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_changed.wait(lock, [this] { return m_stop || m_queue_head < m_queue.size(); });
+        if (m_queue_head == m_queue.size()) {
+            return; // Stopped with nothing left to apply
+        }
+        const std::size_t layer = m_queue[m_queue_head++];
+        m_busy = true;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            for (std::size_t k = 2 * layer; k < 2 * layer + 2; ++k) {
+                m_optimizer.update(k);
+                std::fill(spans[k].grad, spans[k].grad + spans[k].size, 0.0);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (error && !m_error) {
+            m_error = error;
+        }
+        m_busy = false;
+        m_changed.notify_all();
+    }
+}
@@ -4,116 +4,481 @@
  */
 
 #include "micrograd/value.hpp"
+#include "micrograd/tape.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
-#include <set>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+// ======== OPCODES =========
+const char *op_name(Op op)
+{
+    switch (op)
+    {
+    case Op::None:
+        return "";
+    case Op::Const:
+        return "const";
+    case Op::Add:
+        return "+";
+    case Op::Mul:
+        return "*";
+    case Op::Tanh:
+        return "tanh";
+    case Op::Exp:
+        return "exp";
+    case Op::Pow:
+        return "pow";
+    case Op::Relu:
+        return "relu";
+    case Op::Sigmoid:
+        return "sigmoid";
+    case Op::Gelu:
+        return "gelu";
+    case Op::LogSumExp:
+        return "logsumexp";
+    case Op::SoftmaxCrossEntropy:
+        return "softmax_xent";
+    case Op::SquaredError:
+        return "squared_error";
+    }
+    return "?";
+}
+
+// ======== CHILD LIST =========
+ChildList::ChildList(ValuePtr only) noexcept : m_size(1)
+{
+    m_inline[0] = std::move(only);
+}
+
+ChildList::ChildList(ValuePtr first, ValuePtr second) noexcept : m_size(2)
+{
+    m_inline[0] = std::move(first);
+    m_inline[1] = std::move(second);
+}
+
+ChildList::ChildList(const std::vector<ValuePtr> &children) : m_size(static_cast<std::uint32_t>(children.size()))
+{
+    ValuePtr *dst = m_inline;
+    if (m_size > inline_capacity)
+    {
+        m_spill.reset(new ValuePtr[m_size]);
+        dst = m_spill.get();
+    }
+    std::copy(children.begin(), children.end(), dst);
+}
+
+ChildList::ChildList(const ChildList &other) : m_size(other.m_size)
+{
+    ValuePtr *dst = m_inline;
+    if (m_size > inline_capacity)
+    {
+        m_spill.reset(new ValuePtr[m_size]);
+        dst = m_spill.get();
+    }
+    std::copy(other.begin(), other.end(), dst);
+}
+
+ChildList::ChildList(ChildList &&other) noexcept
+{
+    swap(*this, other);
+}
+
+ChildList &ChildList::operator=(ChildList other) noexcept
+{
+    swap(*this, other);
+    return *this;
+}
+
+void ChildList::clear() noexcept
+{
+    m_inline[0].reset();
+    m_inline[1].reset();
+    m_spill.reset();
+    m_size = 0;
+}
+
+void swap(ChildList &a, ChildList &b) noexcept
+{
+    using std::swap;
+    swap(a.m_inline[0], b.m_inline[0]);
+    swap(a.m_inline[1], b.m_inline[1]);
+    swap(a.m_spill, b.m_spill);
+    swap(a.m_size, b.m_size);
+}
+
+// ======== LABEL SIDE TABLE =========
+namespace
+{
+/// Labels of the Values whose m_labeled flag is set, keyed by node address
+struct LabelTable
+{
+    std::mutex mutex;
+    std::unordered_map<const Value *, std::string> labels;
+};
+
+LabelTable &label_table()
+{
+    // Never destroyed, so Values with static storage duration can still be torn down
+    static LabelTable *table = new LabelTable();
+    return *table;
+}
+
+const std::string kNoLabel;
+
+/// Children ~Value has yet to release on one thread
+struct PendingList
+{
+    std::vector<ValuePtr> nodes;
+    bool draining = false;
+};
+
+// Trivially destructible, so still readable while the thread's other
+// thread_locals are torn down (on the main thread, before any static ValuePtr)
+thread_local PendingList *t_pending = nullptr;
+thread_local bool t_pending_gone = false;
+
+/// Frees the calling thread's list at thread exit and marks it gone
+struct PendingOwner
+{
+    ~PendingOwner()
+    {
+        PendingList *list = t_pending;
+        t_pending = nullptr;
+        t_pending_gone = true;
+        delete list;
+    }
+};
+
+/// The calling thread's list, or nullptr once the thread is tearing down
+PendingList *pending_list()
+{
+    if (!t_pending && !t_pending_gone)
+    {
+        thread_local PendingOwner owner;
+        (void)owner;
+        t_pending = new PendingList();
+    }
+    return t_pending;
+}
+} // namespace
+
 // ======== VALUE CLASS CONSTRUCTORS =========
-Value::Value(double data, const std::string &label)
-    : m_data(data), m_grad(0.0), m_label(label), m_op(""), m_backward_fn([]() {}) {}
+Value::Value(double data)
+    : m_data(m_storage), m_grad(m_storage + 1), m_storage{data, 0.0}, m_aux(0.0), m_visit_epoch(0), m_op(Op::None),
+      m_labeled(false), m_requires_grad(true) {}
 
-Value::Value(double data, const std::set<ValuePtr> &children, const std::string &op, const std::string &label)
-    : m_data(data), m_grad(0.0), m_label(label), m_op(op), m_prev(children), m_backward_fn([]() {}) {}
+Value::Value(double data, const std::string &label) : Value(data)
+{
+    set_label(label);
+}
 
-// ======= ACCESSORS =======
-double Value::data() const
+Value::Value(double data, ChildList children, Op op)
+    : m_data(m_storage), m_grad(m_storage + 1), m_storage{data, 0.0}, m_aux(0.0), m_prev(std::move(children)),
+      m_visit_epoch(0), m_op(op), m_labeled(false), m_requires_grad(op != Op::Const && m_prev.empty())
 {
-    return m_data;
+    for (const ValuePtr &parent : m_prev)
+    {
+        m_requires_grad = m_requires_grad || parent->m_requires_grad;
+    }
 }
-double Value::grad() const
+
+Value::Value(double data, ChildList children, Op op, const std::string &label) : Value(data, std::move(children), op)
 {
-    return m_grad;
+    set_label(label);
 }
-const std::string &Value::label() const
+
+Value::Value(double *data, double *grad)
+    : m_data(data), m_grad(grad), m_storage{0.0, 0.0}, m_aux(0.0), m_visit_epoch(0), m_op(Op::None),
+      m_labeled(false), m_requires_grad(true) {}
+
+Value::Value(double *data, double *grad, const std::string &label) : Value(data, grad)
 {
-    return m_label;
+    set_label(label);
 }
 
-// ======= MUTATORS ========
-void Value::set_data(double data)
+Value::Value(const Value &other)
+    : ValueCounter(other), m_storage{other.m_storage[0], other.m_storage[1]}, m_aux(other.m_aux), m_prev(other.m_prev),
+      m_visit_epoch(other.m_visit_epoch), m_op(other.m_op), m_labeled(false), m_requires_grad(other.m_requires_grad)
 {
-    m_data = data;
+    bind_like(other);
+    if (other.m_labeled)
+    {
+        set_label(other.label());
+    }
+}
+
+Value &Value::operator=(const Value &other)
+{
+    if (this != &other)
+    {
+        m_storage[0] = other.m_storage[0];
+        m_storage[1] = other.m_storage[1];
+        m_aux = other.m_aux;
+        m_prev = other.m_prev;
+        m_visit_epoch = other.m_visit_epoch;
+        m_op = other.m_op;
+        m_requires_grad = other.m_requires_grad;
+        bind_like(other);
+        set_label(other.label());
+    }
+    return *this;
+}
+
+Value::Value(Value &&other) noexcept
+    : ValueCounter(other), m_storage{other.m_storage[0], other.m_storage[1]}, m_aux(other.m_aux),
+      m_prev(std::move(other.m_prev)), m_visit_epoch(other.m_visit_epoch), m_op(other.m_op), m_labeled(false),
+      m_requires_grad(other.m_requires_grad)
+{
+    bind_like(other);
+    take_label(other);
+}
+
+Value &Value::operator=(Value &&other) noexcept
+{
+    if (this != &other)
+    {
+        m_storage[0] = other.m_storage[0];
+        m_storage[1] = other.m_storage[1];
+        m_aux = other.m_aux;
+        m_prev = std::move(other.m_prev);
+        m_visit_epoch = other.m_visit_epoch;
+        m_op = other.m_op;
+        m_requires_grad = other.m_requires_grad;
+        bind_like(other);
+        clear_label();
+        take_label(other);
+    }
+    return *this;
+}
+
+void Value::bind_like(const Value &other) noexcept
+{
+    if (other.is_bound())
+    {
+        m_data = other.m_data;
+        m_grad = other.m_grad;
+    }
+    else
+    {
+        m_data = m_storage;
+        m_grad = m_storage + 1;
+    }
+}
+
+void Value::clear_label() noexcept
+{
+    if (m_labeled)
+    {
+        LabelTable &table = label_table();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        table.labels.erase(this);
+        m_labeled = false;
+    }
+}
+
+void Value::take_label(Value &other) noexcept
+{
+    if (other.m_labeled)
+    {
+        // Re-key the entry instead of copying the string
+        LabelTable &table = label_table();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto node = table.labels.extract(&other);
+        node.key() = this;
+        table.labels.insert(std::move(node));
+        other.m_labeled = false;
+        m_labeled = true;
+    }
 }
-void Value::set_grad(double grad)
+
+Value::~Value()
 {
-    m_grad = grad;
+    clear_label();
+
+    PendingList *pending = pending_list();
+    if (!pending)
+    {
+        // Released after thread teardown: the graphs left are the few held
+        // by static ValuePtrs, so plain recursion is fine
+        m_prev.clear();
+        return;
+    }
+
+    // Hand our references to the pending list; the outermost destructor drains it
+    for (const auto &child : m_prev)
+    {
+        pending->nodes.push_back(child);
+    }
+    m_prev.clear();
+    if (pending->draining)
+    {
+        return;
+    }
+
+    pending->draining = true;
+    while (!pending->nodes.empty())
+    {
+        ValuePtr v = std::move(pending->nodes.back());
+        pending->nodes.pop_back();
+        // v may be destroyed here; its destructor only appends to pending
+    }
+    pending->draining = false;
 }
-void Value::add_to_grad(double grad_increment)
+
+// ======== LIVE COUNT ========
+std::atomic<long> ValueCounter::s_live{0};
+
+long Value::live_count()
 {
-    m_grad += grad_increment;
+    return ValueCounter::live();
 }
-void Value::zero_grad()
+
+// ======= LABELS =======
+const std::string &Value::label() const
 {
-    m_grad = 0.0;
+    if (!m_labeled)
+    {
+        return kNoLabel;
+    }
+    LabelTable &table = label_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.labels.find(this)->second;
 }
+
 void Value::set_label(const std::string &label)
 {
-    m_label = label;
+    if (label.empty())
+    {
+        clear_label();
+        return;
+    }
+    LabelTable &table = label_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.labels[this] = label;
+    m_labeled = true;
+}
+
+// ======= GRADIENT TRACKING =======
+void Value::set_requires_grad(bool requires_grad)
+{
+    if (!m_prev.empty())
+    {
+        throw std::invalid_argument("Value::set_requires_grad: only leaves can be marked");
+    }
+    m_requires_grad = requires_grad;
 }
 
 // ======== UTILITY METHODS =======
 void Value::print() const
 {
-    std::cout << "Value(data=" << m_data << ", grad=" << m_grad;
-    if (!m_label.empty())
+    std::cout << "Value(data=" << *m_data << ", grad=" << *m_grad;
+    if (m_labeled)
     {
-        std::cout << ", label=\"" << m_label << "\"";
+        std::cout << ", label=\"" << label() << "\"";
     }
     std::cout << ")" << std::endl;
 }
 
 std::string Value::to_string() const
 {
-    std::string result = "Value(" + std::to_string(m_data) + ")";
-    if (!m_label.empty())
+    std::string result = "Value(" + std::to_string(*m_data) + ")";
+    if (m_labeled)
     {
-        result += "[" + m_label + "]";
+        result += "[" + label() + "]";
     }
     return result;
 }
 
 // ======== FACTORY FUNCTIONS ========
+ValuePtr make_value(double data)
+{
+    MICROGRAD_PROFILE_COUNT_NODE(Op::None);
+    if (Tape *tape = Tape::active())
+    {
+        return tape->record(data);
+    }
+    MICROGRAD_PROFILE_COUNT_BYTES(Node, sizeof(Value));
+    return std::make_shared<Value>(data);
+}
 ValuePtr make_value(double data, const std::string &label)
 {
+    MICROGRAD_PROFILE_COUNT_NODE(Op::None);
+    if (Tape *tape = Tape::active())
+    {
+        return tape->record(data, label);
+    }
+    MICROGRAD_PROFILE_COUNT_BYTES(Node, sizeof(Value));
     return std::make_shared<Value>(data, label);
 }
-ValuePtr make_value(double data, const std::set<ValuePtr> &children, const std::string &op, const std::string &label)
+ValuePtr make_value(double data, ChildList children, Op op)
+{
+    MICROGRAD_PROFILE_COUNT_NODE(op);
+    if (Tape *tape = Tape::active())
+    {
+        return tape->record(data, std::move(children), op);
+    }
+    MICROGRAD_PROFILE_COUNT_BYTES(Node, sizeof(Value));
+    return std::make_shared<Value>(data, std::move(children), op);
+}
+ValuePtr make_value(double data, ChildList children, Op op, const std::string &label)
 {
-    return std::make_shared<Value>(data, children, op, label);
+    MICROGRAD_PROFILE_COUNT_NODE(op);
+    if (Tape *tape = Tape::active())
+    {
+        return tape->record(data, std::move(children), op, label);
+    }
+    MICROGRAD_PROFILE_COUNT_BYTES(Node, sizeof(Value));
+    return std::make_shared<Value>(data, std::move(children), op, label);
 }
 
 // ======== OPERATOR OVERLOADS ========
-ValuePtr operator+(const ValuePtr &lhs, const ValuePtr &rhs)
+namespace
+{
+/// Literal operand of the double overloads; an Op::Const leaf that graph
+/// passes can fold away (see CompiledGraph::optimize)
+ValuePtr make_constant(double value)
+{
+    return make_value(value, ChildList(), Op::Const);
+}
+
+/// log(sum exp(z_i)) with the maximum factored out, so no term overflows
+double stable_logsumexp(const std::vector<ValuePtr> &z)
 {
-    auto out = make_value(lhs->data() + rhs->data(), {lhs, rhs}, "+");
-    out->m_backward_fn = [lhs, rhs, out]()
+    double max = z[0]->data();
+    for (const ValuePtr &v : z)
     {
-        // Chain rule for addition: dL/dx = dL/dout * dout/dx = out.grad * 1.0
-        lhs->add_to_grad(out->grad());
-        rhs->add_to_grad(out->grad());
-    };
-    return out;
+        max = std::max(max, v->data());
+    }
+    double total = 0.0;
+    for (const ValuePtr &v : z)
+    {
+        total += std::exp(v->data() - max);
+    }
+    return max + std::log(total);
+}
+} // namespace
+
+ValuePtr operator+(const ValuePtr &lhs, const ValuePtr &rhs)
+{
+    return make_value(lhs->data() + rhs->data(), {lhs, rhs}, Op::Add);
 }
 
 ValuePtr operator*(const ValuePtr &lhs, const ValuePtr &rhs)
 {
-    auto out = make_value(lhs->data() * rhs->data(), {lhs, rhs}, "*");
-    out->m_backward_fn = [lhs, rhs, out]()
-    {
-        // Chain rule for multiplication: dL/dx = dL/dout * dout/dx = out.grad * y
-        lhs->add_to_grad(rhs->data() * out->grad());
-        rhs->add_to_grad(lhs->data() * out->grad());
-    };
-    return out;
+    return make_value(lhs->data() * rhs->data(), {lhs, rhs}, Op::Mul);
 }
 
 ValuePtr operator-(const ValuePtr &v)
 { // Unary negation
-    return v * -1.0;
+    return v * make_constant(-1.0);
 }
 
 ValuePtr operator-(const ValuePtr &lhs, const ValuePtr &rhs)
@@ -131,98 +496,326 @@ ValuePtr operator/(const ValuePtr &lhs, const ValuePtr &rhs)
 // Overloads for double
 ValuePtr operator+(const ValuePtr &lhs, double rhs_val)
 {
-    return lhs + make_value(rhs_val);
+    return lhs + make_constant(rhs_val);
 }
 ValuePtr operator+(double lhs_val, const ValuePtr &rhs)
 {
-    return make_value(lhs_val) + rhs;
+    return make_constant(lhs_val) + rhs;
 }
 ValuePtr operator*(const ValuePtr &lhs, double rhs_val)
 {
-    return lhs * make_value(rhs_val);
+    return lhs * make_constant(rhs_val);
 }
 ValuePtr operator*(double lhs_val, const ValuePtr &rhs)
 {
-    return make_value(lhs_val) * rhs;
+    return make_constant(lhs_val) * rhs;
+}
+ValuePtr operator-(const ValuePtr &lhs, double rhs_val)
+{
+    return lhs + make_constant(-rhs_val);
+}
+ValuePtr operator-(double lhs_val, const ValuePtr &rhs)
+{
+    return make_constant(lhs_val) + (-rhs);
 }
 ValuePtr operator/(const ValuePtr &lhs, double rhs_val)
 {
-    return lhs / make_value(rhs_val);
+    return lhs / make_constant(rhs_val);
 }
 
 // ======== BACKPROPAGATION ========
-void Value::backward()
+namespace
 {
-    std::vector<ValuePtr> topo;
-    std::set<ValuePtr> visited;
+std::atomic<std::uint64_t> g_visit_epoch{0}; ///< Last epoch handed out to a traversal
 
-    // Recursively build a topologically sorted list of all nodes
-    std::function<void(ValuePtr)> build_topo =
-        [&](ValuePtr v)
+/// One pending node of the explicit DFS stack
+struct TopoFrame
+{
+    Value *node;
+    const ValuePtr *next_child;
+};
+} // namespace
+
+std::uint64_t Value::next_visit_epoch() noexcept
+{
+    return g_visit_epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Value::build_topo(std::vector<Value *> &order, bool grad_only)
+{
+    // Scratch stack reused across calls so steady-state traversals don't allocate
+    thread_local std::vector<TopoFrame> stack;
+
+    const std::uint64_t epoch = next_visit_epoch();
+    order.clear();
+    stack.clear();
+
+    m_visit_epoch = epoch;
+    stack.push_back({this, m_prev.begin()});
+    while (!stack.empty())
     {
-        if (visited.find(v) == visited.end())
+        TopoFrame &frame = stack.back();
+        if (frame.next_child != frame.node->m_prev.end())
         {
-            visited.insert(v);
-            for (const auto &child : v->m_prev)
+            Value *child = (frame.next_child++)->get();
+            if (grad_only && !child->m_requires_grad)
             {
-                build_topo(child);
+                continue; // Nothing below it has a gradient to receive
             }
-            topo.push_back(v);
+            if (child->m_visit_epoch != epoch)
+            {
+                child->m_visit_epoch = epoch;
+                stack.push_back({child, child->m_prev.begin()}); // invalidates frame
+            }
+        }
+        else
+        {
+            // Post-order: every child of this node has already been emitted
+            order.push_back(frame.node);
+            stack.pop_back();
         }
-    };
+    }
+}
+
+void Value::backward()
+{
+    thread_local std::vector<Value *> order;
+    {
+        MICROGRAD_PROFILE_SCOPE("topo_sort", -1);
+        build_topo(order, true);
+    }
+    backward(order);
+}
 
-    build_topo(shared_from_this());
+void Value::backward(const std::vector<Value *> &order)
+{
+    if (order.empty() || order.back() != this)
+    {
+        throw std::invalid_argument("Value::backward: order was not built from this Value");
+    }
 
     // The gradient of the final node with respect to itself is 1
-    this->m_grad = 1.0;
+    *this->m_grad = 1.0;
 
     // Go backwards through the topologically sorted list and apply the chain rule
-    std::reverse(topo.begin(), topo.end());
-    for (const auto &v : topo)
+#ifdef MICROGRAD_ENABLE_PROFILING
+    // One event per run of nodes built by the same layer; leaves have no
+    // backward work and do not break a run
+    for (auto run = order.rbegin(); run != order.rend();)
     {
-        if (v->m_backward_fn)
+        const int layer = (*run)->m_profile_layer;
+        const double start = profile::now_us();
+        auto it = run;
+        for (; it != order.rend(); ++it)
         {
-            v->m_backward_fn();
+            Value *node = *it;
+            if (node->m_profile_layer != layer && node->m_op != Op::None && node->m_op != Op::Const)
+            {
+                break;
+            }
+            node->backward_step();
         }
+        profile::record("backward", layer, start, profile::now_us());
+        run = it;
+    }
+#else
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+    {
+        (*it)->backward_step();
+    }
+#endif
+}
+
+void Value::backward_step()
+{
+    if (!m_requires_grad)
+    {
+        return;
+    }
+    const double g = *m_grad;
+    switch (m_op)
+    {
+    case Op::None:
+    case Op::Const:
+        break;
+    case Op::Add:
+        // Chain rule for addition: dL/dx = dL/dout * dout/dx = out.grad * 1.0
+        accumulate(*m_prev[0], g);
+        accumulate(*m_prev[1], g);
+        break;
+    case Op::Mul:
+    {
+        // Chain rule for multiplication: dL/dx = dL/dout * dout/dx = out.grad * y
+        Value *l = m_prev[0].get();
+        Value *r = m_prev[1].get();
+        accumulate(*l, *r->m_data * g);
+        accumulate(*r, *l->m_data * g);
+        break;
+    }
+    case Op::Tanh:
+        // Chain rule for tanh: dL/dx = dL/dout * (1 - tanh(x)^2)
+        accumulate(*m_prev[0], (1 - *m_data * *m_data) * g);
+        break;
+    case Op::Exp:
+        // Chain rule for exp: dL/dx = dL/dout * exp(x)
+        accumulate(*m_prev[0], *m_data * g);
+        break;
+    case Op::Pow:
+    {
+        // Chain rule for power: dL/dx = dL/dout * (n * x^(n-1))
+        Value *base = m_prev[0].get();
+        accumulate(*base, (m_aux * std::pow(*base->m_data, m_aux - 1)) * g);
+        break;
+    }
+    case Op::Relu:
+        accumulate(*m_prev[0], *m_data > 0.0 ? g : 0.0);
+        break;
+    case Op::Sigmoid:
+        // d sigmoid(x) / dx = s * (1 - s), from the output alone
+        accumulate(*m_prev[0], *m_data * (1.0 - *m_data) * g);
+        break;
+    case Op::Gelu:
+        accumulate(*m_prev[0], activation::gelu_grad(*m_prev[0]->m_data) * g);
+        break;
+    case Op::LogSumExp:
+        // d lse / dz_i = softmax(z)_i = exp(z_i - lse)
+        for (const ValuePtr &z : m_prev)
+        {
+            accumulate(*z, std::exp(*z->m_data - *m_data) * g);
+        }
+        break;
+    case Op::SoftmaxCrossEntropy:
+    {
+        // out = lse - z_t, so lse is recovered without storing it
+        const std::size_t target = static_cast<std::size_t>(m_aux);
+        const double lse = *m_data + *m_prev[target]->m_data;
+        for (std::size_t i = 0; i < m_prev.size(); ++i)
+        {
+            Value *z = m_prev[i].get();
+            accumulate(*z, (std::exp(*z->m_data - lse) - (i == target ? 1.0 : 0.0)) * g);
+        }
+        break;
+    }
+    case Op::SquaredError:
+    {
+        // Parents are all predictions, then all targets
+        const std::size_t n = m_prev.size() / 2;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            Value *p = m_prev[i].get();
+            Value *t = m_prev[n + i].get();
+            const double d = 2.0 * m_aux * (*p->m_data - *t->m_data) * g;
+            accumulate(*p, d);
+            accumulate(*t, -d);
+        }
+        break;
+    }
     }
 }
 
 // ======== ACTIVATION FUNCTIONS ========
 ValuePtr tanh(const ValuePtr& v) {
-   double t = std::tanh(v->data());
-   auto out = make_value(t, {v}, "tanh");
+   return make_value(std::tanh(v->data()), {v}, Op::Tanh);
+}
 
 
-   out->m_backward_fn = [v, t, out]() {
-       // Chain rule for tanh: dL/dx = dL/dout * (1 - tanh(x)^2)
-       v->add_to_grad((1 - t * t) * out->grad());
-   };
+ValuePtr exp(const ValuePtr& v) {
+   return make_value(std::exp(v->data()), {v}, Op::Exp);
+}
+
+
+ValuePtr pow(const ValuePtr& base, double exp_val) {
+   auto out = make_value(std::pow(base->data(), exp_val), {base}, Op::Pow);
+   out->m_aux = exp_val;
    return out;
 }
 
+ValuePtr relu(const ValuePtr &v)
+{
+    return make_value(v->data() > 0.0 ? v->data() : 0.0, {v}, Op::Relu);
+}
 
-ValuePtr exp(const ValuePtr& v) {
-   double e = std::exp(v->data());
-   auto out = make_value(e, {v}, "exp");
+ValuePtr sigmoid(const ValuePtr &v)
+{
+    return make_value(activation::sigmoid(v->data()), {v}, Op::Sigmoid);
+}
 
+ValuePtr gelu(const ValuePtr &v)
+{
+    return make_value(activation::gelu(v->data()), {v}, Op::Gelu);
+}
 
-   out->m_backward_fn = [v, e, out]() {
-       // Chain rule for exp: dL/dx = dL/dout * exp(x)
-       v->add_to_grad(e * out->grad());
-   };
-   return out;
+ValuePtr activate(const ValuePtr &v, Activation act)
+{
+    switch (act)
+    {
+    case Activation::Tanh:
+        return tanh(v);
+    case Activation::Relu:
+        return relu(v);
+    case Activation::Sigmoid:
+        return sigmoid(v);
+    case Activation::Linear:
+        break;
+    case Activation::Gelu:
+        return gelu(v);
+    }
+    return v;
 }
 
+// ======== FUSED LOSSES ========
+ValuePtr logsumexp(const std::vector<ValuePtr> &z)
+{
+    if (z.empty())
+    {
+        throw std::invalid_argument("logsumexp: no inputs");
+    }
+    return make_value(stable_logsumexp(z), ChildList(z), Op::LogSumExp);
+}
 
-ValuePtr pow(const ValuePtr& base, double exp_val) {
-   double result = std::pow(base->data(), exp_val);
-   auto out = make_value(result, {base}, "pow");
+ValuePtr softmax_cross_entropy(const std::vector<ValuePtr> &logits, std::size_t target)
+{
+    if (target >= logits.size())
+    {
+        throw std::invalid_argument("softmax_cross_entropy: target class out of range");
+    }
+    auto out = make_value(stable_logsumexp(logits) - logits[target]->data(), ChildList(logits),
+                          Op::SoftmaxCrossEntropy);
+    out->m_aux = static_cast<double>(target);
+    return out;
+}
 
+ValuePtr squared_error(const std::vector<ValuePtr> &predictions, const std::vector<ValuePtr> &targets, double scale)
+{
+    if (predictions.empty() || predictions.size() != targets.size())
+    {
+        throw std::invalid_argument("squared_error: predictions and targets differ in size");
+    }
+    double total = 0.0;
+    for (std::size_t i = 0; i < predictions.size(); ++i)
+    {
+        const double d = predictions[i]->data() - targets[i]->data();
+        total += d * d;
+    }
+    std::vector<ValuePtr> parents(predictions);
+    parents.insert(parents.end(), targets.begin(), targets.end());
+    auto out = make_value(scale * total, ChildList(parents), Op::SquaredError);
+    out->m_aux = scale;
+    return out;
+}
 
-   out->m_backward_fn = [base, exp_val, out]() {
-       // Chain rule for power: dL/dx = dL/dout * (n * x^(n-1))
-       base->add_to_grad((exp_val * std::pow(base->data(), exp_val - 1)) * out->grad());
-   };
-   return out;
+ValuePtr mse(const std::vector<ValuePtr> &predictions, const std::vector<ValuePtr> &targets)
+{
+    return squared_error(predictions, targets, 1.0 / static_cast<double>(predictions.empty() ? 1 : predictions.size()));
 }
 
+ValuePtr mse(const std::vector<ValuePtr> &predictions, const std::vector<double> &targets)
+{
+    std::vector<ValuePtr> leaves;
+    leaves.reserve(targets.size());
+    for (double t : targets)
+    {
+        leaves.push_back(make_constant(t));
+    }
+    return mse(predictions, leaves);
+}
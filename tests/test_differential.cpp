@@ -0,0 +1,550 @@
+/**
+ * @file test_differential.cpp
+ * @brief Differential tests of every gradient engine against the scalar reference
+ *
+ * Random MLP topologies, weights and batches are run through each engine:
+ * the arena tape, the compiled graph, the fused loss node, the batched
+ * tensor path (plain, checkpointed and on a thread pool) and the
+ * data-parallel Trainer. Every engine's loss and parameter gradients are
+ * compared to the heap-allocated Value graph with Value::backward(), whose
+ * gradients are in turn checked against central finite differences of
+ * MLP::predict(). The inference snapshots are compared on the forward
+ * pass. A timing pass on a fixed network then reports each engine's
+ * speedup over the reference; the timings are informative only.
+ *
+ * Usage: test_differential [--cases <n>] [--seed <s>] [--no-timing]
+ */
+
+#include "micrograd/compiled_graph.hpp"
+#include "micrograd/inference.hpp"
+#include "micrograd/init.hpp"
+#include "micrograd/mlp.hpp"
+#include "micrograd/tape.hpp"
+#include "micrograd/thread_pool.hpp"
+#include "micrograd/trainer.hpp"
+#include "micrograd/value.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ======== TESTING FRAMEWORK ========
+// Re-using the simple testing framework from test_nn.cpp
+
+class TestFramework {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+    int tests_failed = 0;
+    std::string current_test_name;
+
+public:
+    ~TestFramework() {
+        std::cout << "\n----------------------------------------\n";
+        std::cout << "Test Summary: " << tests_passed << " / " << tests_run << " passed." << std::endl;
+        std::cout << "----------------------------------------\n";
+    }
+
+    void start_test(const std::string& name) {
+        current_test_name = name;
+        std::cout << "Running: " << name << " ... ";
+        tests_run++;
+    }
+
+    void pass() {
+        std::cout << "✓ PASS" << std::endl;
+        tests_passed++;
+    }
+
+    void fail(const std::string& message = "") {
+        std::cout << "✗ FAIL";
+        if (!message.empty()) {
+            std::cout << " - " << message;
+        }
+        std::cout << std::endl;
+        tests_failed++;
+    }
+
+    void assert_true(bool condition, const std::string& message = "") {
+        if (condition) {
+            pass();
+        } else {
+            fail(message);
+        }
+    }
+
+    int failures() const {
+        return tests_failed;
+    }
+};
+
+// =============================================================================
+// RANDOM CASES
+// =============================================================================
+namespace {
+
+/// Sequential draws from a counter-based stream
+class Draw {
+  public:
+    explicit Draw(const Rng& rng) : m_rng(rng) {}
+
+    std::size_t below(std::size_t n) {
+        return static_cast<std::size_t>(m_rng.bits(m_next++) % n);
+    }
+
+    double uniform(double lo, double hi) {
+        return lo + (hi - lo) * m_rng.uniform(m_next++);
+    }
+
+  private:
+    Rng m_rng;
+    std::uint64_t m_next = 0;
+};
+
+/// One network shape with its weights and a batch of inputs and targets
+struct Case {
+    int nin = 0;
+    std::vector<int> nouts;
+    std::vector<Activation> activations;
+    std::size_t batch = 0;
+    std::vector<double> weights; ///< In MLP::parameters() order
+    std::vector<double> x;       ///< [batch x nin]
+    std::vector<double> y;       ///< [batch x nout]
+
+    std::string name() const {
+        static const char* const kNames[] = {"tanh", "relu", "sigmoid", "linear", "gelu"};
+        std::ostringstream out;
+        out << nin;
+        for (int n : nouts) {
+            out << "-" << n;
+        }
+        for (std::size_t l = 0; l < activations.size(); ++l) {
+            out << (l == 0 ? " " : "/") << kNames[static_cast<int>(activations[l])];
+        }
+        out << ", batch " << batch;
+        return out.str();
+    }
+
+    MLP build() const {
+        MLP mlp(nin, nouts, activations);
+        const auto& params = mlp.parameters();
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            params[i]->set_data(weights[i]);
+        }
+        return mlp;
+    }
+};
+
+Case random_case(const Rng& rng) {
+    Draw draw(rng);
+    Case c;
+    c.nin = 1 + static_cast<int>(draw.below(8));
+    const std::size_t depth = 1 + draw.below(4);
+    std::size_t params = 0;
+    int fan_in = c.nin;
+    for (std::size_t l = 0; l < depth; ++l) {
+        const int width = 1 + static_cast<int>(draw.below(12));
+        c.nouts.push_back(width);
+        c.activations.push_back(static_cast<Activation>(draw.below(5)));
+        params += static_cast<std::size_t>(width) * static_cast<std::size_t>(fan_in + 1);
+        fan_in = width;
+    }
+    c.batch = 1 + draw.below(9);
+
+    for (std::size_t i = 0; i < params; ++i) {
+        c.weights.push_back(draw.uniform(-1.0, 1.0));
+    }
+    for (std::size_t i = 0; i < c.batch * static_cast<std::size_t>(c.nin); ++i) {
+        c.x.push_back(draw.uniform(-2.0, 2.0));
+    }
+    for (std::size_t i = 0; i < c.batch * static_cast<std::size_t>(c.nouts.back()); ++i) {
+        c.y.push_back(draw.uniform(-1.0, 1.0));
+    }
+    return c;
+}
+
+// =============================================================================
+// ENGINES
+// =============================================================================
+
+/// One gradient step: clears the model's grads, runs forward and backward, returns the loss
+using Step = std::function<double()>;
+
+/**
+ * An engine sets up whatever it replays (a compiled graph, a trainer)
+ * once per model and batch, so the timing pass measures the steady state.
+ */
+struct Engine {
+    std::string name;
+    std::function<Step(MLP&, const Case&)> prepare;
+};
+
+/// The scalar graph of a batch's squared-error loss, one node per operation
+ValuePtr scalar_loss(MLP& mlp, const Case& c, std::vector<ValuePtr>* inputs = nullptr) {
+    const std::size_t nin = static_cast<std::size_t>(c.nin), nout = mlp.nout();
+    ValuePtr loss;
+    for (std::size_t s = 0; s < c.batch; ++s) {
+        std::vector<ValuePtr> x;
+        for (std::size_t i = 0; i < nin; ++i) {
+            x.push_back(make_value(c.x[s * nin + i]));
+        }
+        if (inputs) {
+            inputs->insert(inputs->end(), x.begin(), x.end());
+        }
+        const std::vector<ValuePtr> out = mlp(x);
+        for (std::size_t j = 0; j < nout; ++j) {
+            ValuePtr term = pow(out[j] - c.y[s * nout + j], 2.0);
+            loss = loss ? loss + term : term;
+        }
+    }
+    return loss;
+}
+
+/// The same loss as one fused SquaredError node over the whole batch
+ValuePtr fused_loss(MLP& mlp, const Case& c) {
+    const std::size_t nin = static_cast<std::size_t>(c.nin);
+    std::vector<ValuePtr> predictions, targets;
+    for (std::size_t s = 0; s < c.batch; ++s) {
+        std::vector<ValuePtr> x;
+        for (std::size_t i = 0; i < nin; ++i) {
+            x.push_back(make_value(c.x[s * nin + i]));
+        }
+        const std::vector<ValuePtr> out = mlp(x);
+        predictions.insert(predictions.end(), out.begin(), out.end());
+    }
+    for (double t : c.y) {
+        targets.push_back(make_value(t));
+    }
+    return squared_error(predictions, targets);
+}
+
+/// The loss of the current weights through the graph-free forward pass
+double predict_loss(const MLP& mlp, const Case& c) {
+    std::vector<double> out(c.y.size());
+    mlp.predict(c.x.data(), out.data(), c.batch);
+    double loss = 0.0;
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        loss += (out[i] - c.y[i]) * (out[i] - c.y[i]);
+    }
+    return loss;
+}
+
+std::vector<double> gradients(const MLP& mlp) {
+    std::vector<double> grads;
+    for (const auto& p : mlp.parameters()) {
+        grads.push_back(p->grad());
+    }
+    return grads;
+}
+
+/// The reference: a heap-allocated scalar graph and Value::backward()
+Step reference_step(MLP& mlp, const Case& c) {
+    return [&mlp, &c] {
+        mlp.zero_grad();
+        ValuePtr loss = scalar_loss(mlp, c);
+        loss->backward();
+        return loss->data();
+    };
+}
+
+std::vector<Engine> engines(ThreadPool& pool) {
+    std::vector<Engine> list;
+    list.push_back({"scalar.fused_loss", [](MLP& mlp, const Case& c) -> Step {
+        return [&mlp, &c] {
+            mlp.zero_grad();
+            ValuePtr loss = fused_loss(mlp, c);
+            loss->backward();
+            return loss->data();
+        };
+    }});
+    list.push_back({"scalar.pool", [&pool](MLP& mlp, const Case& c) -> Step {
+        mlp.set_thread_pool(&pool);
+        return reference_step(mlp, c);
+    }});
+    list.push_back({"tape", [](MLP& mlp, const Case& c) -> Step {
+        auto tape = std::make_shared<Tape>();
+        return [&mlp, &c, tape] {
+            mlp.zero_grad();
+            tape->clear();
+            ValuePtr loss;
+            {
+                TapeScope scope(*tape);
+                loss = scalar_loss(mlp, c);
+            }
+            tape->backward(loss);
+            return loss->data();
+        };
+    }});
+    list.push_back({"compiled", [](MLP& mlp, const Case& c) -> Step {
+        // Traced once with the batch as inputs, then replayed on the current weights
+        std::vector<ValuePtr> inputs;
+        ValuePtr loss = scalar_loss(mlp, c, &inputs);
+        auto graph = std::make_shared<CompiledGraph>(loss, inputs);
+        graph->optimize();
+        return [&mlp, &c, graph] {
+            mlp.zero_grad();
+            graph->set_inputs(c.x.data());
+            const double value = graph->forward();
+            graph->backward();
+            return value;
+        };
+    }});
+    list.push_back({"tensor", [](MLP& mlp, const Case& c) -> Step {
+        return [&mlp, &c] {
+            mlp.zero_grad();
+            BatchOutput out = mlp.forward_batch(c.x.data(), c.y.data(), c.batch);
+            out.loss->backward();
+            return out.loss->at(0, 0);
+        };
+    }});
+    list.push_back({"tensor.checkpoint", [](MLP& mlp, const Case& c) -> Step {
+        mlp.set_checkpoint_interval(2);
+        return [&mlp, &c] {
+            mlp.zero_grad();
+            BatchOutput out = mlp.forward_batch(c.x.data(), c.y.data(), c.batch);
+            out.loss->backward();
+            return out.loss->at(0, 0);
+        };
+    }});
+    list.push_back({"tensor.pool", [&pool](MLP& mlp, const Case& c) -> Step {
+        mlp.set_thread_pool(&pool);
+        return [&mlp, &c] {
+            mlp.zero_grad();
+            BatchOutput out = mlp.forward_batch(c.x.data(), c.y.data(), c.batch);
+            out.loss->backward();
+            return out.loss->at(0, 0);
+        };
+    }});
+    list.push_back({"trainer", [](MLP& mlp, const Case& c) -> Step {
+        auto trainer = std::make_shared<Trainer>(mlp, 3);
+        return [&mlp, &c, trainer] {
+            mlp.zero_grad();
+            return trainer->backward_batch(c.x.data(), c.y.data(), c.batch);
+        };
+    }});
+    return list;
+}
+
+/// Engines may attach a pool or checkpointing; each one starts from the plain model
+void reset(MLP& mlp) {
+    mlp.set_thread_pool(nullptr);
+    mlp.set_checkpoint_interval(0);
+}
+
+/// Largest difference relative to the reference's magnitude, floored at 1
+double relative_error(const std::vector<double>& actual, const std::vector<double>& expected) {
+    double worst = 0.0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        worst = std::max(worst, std::abs(actual[i] - expected[i]) / std::max(1.0, std::abs(expected[i])));
+    }
+    return worst;
+}
+
+/// The worst error seen for one check and the case it came from
+struct Worst {
+    double error = 0.0;
+    std::string where;
+
+    void update(double e, const std::string& name) {
+        if (!(e <= error)) { // Keeps NaN
+            error = e;
+            where = name;
+        }
+    }
+
+    std::string describe() const {
+        std::ostringstream out;
+        out << "worst error " << error << " on " << where;
+        return out.str();
+    }
+};
+
+// =============================================================================
+// DIFFERENTIAL TESTS
+// =============================================================================
+
+constexpr double kGradientTolerance = 1e-9;   ///< Engines differ only in summation order
+constexpr double kDifferenceStep = 1e-5;      ///< Central-difference step
+constexpr double kDifferenceTolerance = 1e-6; ///< O(step^2) truncation plus cancellation
+constexpr double kFloatTolerance = 1e-4;      ///< InferenceMLP<float> against double
+
+void test_differential_suite(TestFramework& tf, std::uint64_t seed, std::size_t cases, ThreadPool& pool) {
+    std::cout << "--- Engines Against The Scalar Reference (" << cases << " random cases, seed " << seed
+              << ") ---" << std::endl;
+
+    const std::vector<Engine> list = engines(pool);
+    std::vector<Worst> loss_errors(list.size()), grad_errors(list.size());
+    std::vector<std::string> crashes(list.size());
+    Worst predict_error, difference_error, double_snapshot, float_snapshot;
+
+    const Rng root(seed);
+    for (std::size_t k = 0; k < cases; ++k) {
+        const Case c = random_case(root.stream(k));
+        const std::string name = "case " + std::to_string(k) + " (" + c.name() + ")";
+        MLP mlp = c.build();
+
+        const double ref_loss = reference_step(mlp, c)();
+        const std::vector<double> ref_grads = gradients(mlp);
+        predict_error.update(std::abs(predict_loss(mlp, c) - ref_loss) / std::max(1.0, ref_loss), name);
+
+        // Central differences on an evenly spread subset of the parameters
+        const auto& params = mlp.parameters();
+        const std::size_t stride = std::max<std::size_t>(1, params.size() / 16);
+        for (std::size_t i = 0; i < params.size(); i += stride) {
+            const double w = params[i]->data();
+            params[i]->set_data(w + kDifferenceStep);
+            const double up = predict_loss(mlp, c);
+            params[i]->set_data(w - kDifferenceStep);
+            const double down = predict_loss(mlp, c);
+            params[i]->set_data(w);
+            const double estimate = (up - down) / (2.0 * kDifferenceStep);
+            difference_error.update(std::abs(estimate - ref_grads[i]) / std::max(1.0, std::abs(ref_grads[i])),
+                                    name + ", parameter " + std::to_string(i));
+        }
+
+        for (std::size_t e = 0; e < list.size(); ++e) {
+            try {
+                const double loss = list[e].prepare(mlp, c)();
+                loss_errors[e].update(std::abs(loss - ref_loss) / std::max(1.0, ref_loss), name);
+                grad_errors[e].update(relative_error(gradients(mlp), ref_grads), name);
+            } catch (const std::exception& ex) {
+                if (crashes[e].empty()) {
+                    crashes[e] = name + ": " + ex.what();
+                }
+            }
+            reset(mlp);
+        }
+
+        // Forward-only snapshots
+        std::vector<double> expected(c.y.size()), actual(c.y.size());
+        mlp.predict(c.x.data(), expected.data(), c.batch);
+        InferenceMLP<double>(mlp).predict(c.x.data(), actual.data(), c.batch);
+        double_snapshot.update(relative_error(actual, expected), name);
+        std::vector<float> xf(c.x.begin(), c.x.end()), yf(c.y.size());
+        InferenceMLP<float>(mlp).predict(xf.data(), yf.data(), c.batch);
+        float_snapshot.update(relative_error(std::vector<double>(yf.begin(), yf.end()), expected), name);
+    }
+
+    tf.start_test("Reference Loss Matches MLP::predict");
+    tf.assert_true(predict_error.error <= kGradientTolerance, predict_error.describe());
+
+    tf.start_test("Reference Gradients Match Finite Differences");
+    tf.assert_true(difference_error.error <= kDifferenceTolerance, difference_error.describe());
+
+    for (std::size_t e = 0; e < list.size(); ++e) {
+        tf.start_test(list[e].name + " Runs Every Case");
+        tf.assert_true(crashes[e].empty(), crashes[e]);
+
+        tf.start_test(list[e].name + " Loss Matches The Reference");
+        tf.assert_true(loss_errors[e].error <= kGradientTolerance, loss_errors[e].describe());
+
+        tf.start_test(list[e].name + " Gradients Match The Reference");
+        tf.assert_true(grad_errors[e].error <= kGradientTolerance, grad_errors[e].describe());
+    }
+
+    tf.start_test("InferenceMLP<double> Is Bitwise MLP::predict");
+    tf.assert_true(double_snapshot.error == 0.0, double_snapshot.describe());
+
+    tf.start_test("InferenceMLP<float> Tracks MLP::predict");
+    tf.assert_true(float_snapshot.error <= kFloatTolerance, float_snapshot.describe());
+}
+
+// =============================================================================
+// SPEEDUP REPORT
+// =============================================================================
+
+/// Median wall time of one step, in microseconds
+double median_micros(const Step& step, int reps) {
+    std::vector<double> times;
+    for (int r = 0; r < reps; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        step();
+        const auto stop = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void report_speedups(ThreadPool& pool) {
+    // A fixed 16-32-32-4 network, big enough for the batched paths to pay off
+    Case c;
+    c.nin = 16;
+    c.nouts = {32, 32, 4};
+    c.activations = {Activation::Tanh, Activation::Tanh, Activation::Linear};
+    c.batch = 32;
+    Draw draw(Rng(0));
+    c.weights.resize(16 * 32 + 32 + 32 * 32 + 32 + 32 * 4 + 4);
+    for (double& w : c.weights) {
+        w = draw.uniform(-0.3, 0.3);
+    }
+    c.x.resize(c.batch * 16);
+    for (double& v : c.x) {
+        v = draw.uniform(-1.0, 1.0);
+    }
+    c.y.resize(c.batch * 4);
+    for (double& v : c.y) {
+        v = draw.uniform(-1.0, 1.0);
+    }
+    constexpr int kReps = 7;
+
+    std::cout << "\n--- Speedup Over The Scalar Reference (" << c.name() << ", median of " << kReps
+              << " steps) ---" << std::endl;
+    MLP mlp = c.build();
+    const double reference = median_micros(reference_step(mlp, c), kReps);
+    std::cout << std::left << std::setw(20) << "reference" << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << reference << " us" << std::setw(10) << "1.00x" << std::endl;
+    for (const Engine& engine : engines(pool)) {
+        const double t = median_micros(engine.prepare(mlp, c), kReps);
+        reset(mlp);
+        std::cout << std::left << std::setw(20) << engine.name << std::right << std::setw(12) << t << " us"
+                  << std::setw(9) << std::setprecision(2) << reference / t << "x" << std::setprecision(1)
+                  << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::uint64_t seed = 1;
+    std::size_t cases = 40;
+    bool timing = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--cases" && i + 1 < argc) {
+            cases = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-timing") {
+            timing = false;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--cases <n>] [--seed <s>] [--no-timing]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::cout << "Differential Engine Tests" << std::endl;
+    std::cout << "=========================" << std::endl << std::endl;
+
+    ThreadPool pool(3);
+    int failures = 0;
+    {
+        TestFramework tf;
+        test_differential_suite(tf, seed, cases, pool);
+        failures = tf.failures();
+    } // Prints the summary before the timings
+    if (timing) {
+        report_speedups(pool);
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,15 +4,73 @@
  */
 
 #include "micrograd/neuron.hpp"
+#include "micrograd/compiled_graph.hpp"
+#include "micrograd/dataset.hpp"
+#include "micrograd/inference.hpp"
+#include "micrograd/init.hpp"
 #include "micrograd/layer.hpp"
 #include "micrograd/mlp.hpp"
+#include "micrograd/optimizer.hpp"
+#include "micrograd/profile.hpp"
+#include "micrograd/quantized.hpp"
+#include "micrograd/serialize.hpp"
+#include "micrograd/thread_pool.hpp"
+#include "micrograd/trainer.hpp"
 #include "micrograd/value.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
 #include <vector>
 #include <string>
+#include <thread>
 #include <cmath>
 #include <numeric>
+#include <sstream>
+
+// ======== ALLOCATION COUNTING ========
+// Replacing the global operator new lets tests assert that a path is allocation-free
+namespace {
+std::atomic<long> g_allocations{0};
+}
+
+// noinline keeps GCC from pairing the inlined free() with the operator new
+// call at each use site and reporting -Wmismatched-new-delete
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// The array forms are replaced too, so every new/delete pair stays matched
+__attribute__((noinline)) void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
 
 // ======== TESTING FRAMEWORK ========
 // Re-using the simple testing framework from test_value.cpp
@@ -21,6 +79,7 @@ class TestFramework {
 private:
     int tests_run = 0;
     int tests_passed = 0;
+    int tests_failed = 0;
     std::string current_test_name;
 
 public:
@@ -47,6 +106,7 @@ public:
             std::cout << " - " << message;
         }
         std::cout << std::endl;
+        tests_failed++;
     }
 
     void assert_true(bool condition, const std::string& message = "") {
@@ -77,6 +137,10 @@ public:
             fail("Expected: " + std::to_string(expected) + ", Got: " + std::to_string(actual));
         }
     }
+
+    int failures() const {
+        return tests_failed;
+    }
 };
 
 // =============================================================================
@@ -100,6 +164,99 @@ void test_neuron_suite(TestFramework& tf) {
     tf.assert_true(out->data() >= -1.0 && out->data() <= 1.0, "Output must be in range [-1, 1]");
 }
 
+// =============================================================================
+// INITIALIZATION TESTS
+// =============================================================================
+void test_init_suite(TestFramework& tf) {
+    std::cout << "\n--- Initialization Tests ---" << std::endl;
+
+    auto weights_of = [](const MLP& mlp) {
+        std::vector<double> all;
+        for (const Layer& layer : mlp.layers()) {
+            all.insert(all.end(), layer.weights()->data(), layer.weights()->data() + layer.weights()->size());
+            all.insert(all.end(), layer.bias()->data(), layer.bias()->data() + layer.bias()->size());
+        }
+        return all;
+    };
+
+    tf.start_test("Seeded Initialization Is Reproducible");
+    MLP a(3, {16, 8, 1}), b(3, {16, 8, 1});
+    a.initialize(Init::XavierUniform, Rng(42));
+    b.initialize(Init::XavierUniform, Rng(42));
+    tf.assert_true(weights_of(a) == weights_of(b), "The same seed should give the same weights");
+    b.initialize(Init::XavierUniform, Rng(43));
+    tf.assert_true(weights_of(a) != weights_of(b), "A different seed should give different weights");
+
+    tf.start_test("Parallel Fill Matches Serial");
+    ThreadPool pool(3);
+    b.set_thread_pool(&pool);
+    b.initialize(Init::XavierUniform, Rng(42));
+    b.set_thread_pool(nullptr);
+    tf.assert_true(weights_of(a) == weights_of(b), "Rows filled on a pool should match a serial fill");
+
+    tf.start_test("Neuron Initialization Matches Its Row");
+    Layer layer(5, 4);
+    const Rng layer_rng = Rng(7).stream(1);
+    layer.initialize(Init::HeNormal, layer_rng);
+    std::vector<double> expected(layer.weights()->data(), layer.weights()->data() + 20);
+    Neuron view(std::make_shared<ParameterBlock>(4, 5), 2);
+    view.initialize(Init::HeNormal, layer_rng);
+    bool row_ok = true;
+    for (std::size_t i = 0; i < 5; ++i) {
+        row_ok = row_ok && view.weights()[i]->data() == expected[2 * 5 + i];
+    }
+    tf.assert_true(row_ok, "A neuron should draw the same weights as its row of the layer");
+
+    tf.start_test("Scheme Scales");
+    MLP wide(400, {300});
+    wide.initialize(Init::XavierUniform, Rng(1));
+    const double* w = wide.layers()[0].weights()->data();
+    const std::size_t n = 400 * 300;
+    const double limit = std::sqrt(6.0 / 700.0);
+    double max_abs = 0.0, sum_sq = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        max_abs = std::max(max_abs, std::abs(w[i]));
+    }
+    tf.assert_true(max_abs <= limit && max_abs > 0.99 * limit, "Xavier uniform weights should fill [-a, a]");
+    wide.initialize(Init::HeNormal, Rng(1));
+    for (std::size_t i = 0; i < n; ++i) {
+        sum_sq += w[i] * w[i];
+    }
+    tf.assert_equal(2.0 / 400.0, sum_sq / static_cast<double>(n), 1e-4); // He normal variance is 2 / fan_in
+
+    tf.start_test("Default Initialization Is Seedable And Thread-Safe");
+    seed_default_init(5);
+    MLP first(3, {4, 1});
+    seed_default_init(5);
+    MLP second(3, {4, 1});
+    tf.assert_true(weights_of(first) == weights_of(second), "Reseeding should replay the default weights");
+    std::vector<std::thread> builders;
+    std::atomic<int> built{0};
+    for (int t = 0; t < 4; ++t) {
+        builders.emplace_back([&built] {
+            for (int i = 0; i < 25; ++i) {
+                MLP m(4, {8, 1});
+                built += m.layers()[0].weights()->data()[0] != m.layers()[0].weights()->data()[1];
+            }
+        });
+    }
+    for (auto& t : builders) {
+        t.join();
+    }
+    tf.assert_equal(std::size_t(100), static_cast<std::size_t>(built.load()), "Concurrent construction should work");
+
+    tf.start_test("Default Initialization Ignores Trainer Replicas");
+    std::vector<std::vector<double>> after_trainer;
+    for (std::size_t threads : {1, 3}) {
+        seed_default_init(9);
+        MLP trained(3, {4, 1});
+        Trainer trainer(trained, threads);
+        after_trainer.push_back(weights_of(MLP(3, {4, 1})));
+    }
+    tf.assert_true(after_trainer[0] == after_trainer[1],
+                   "Replicas should not draw default streams, whatever the thread count");
+}
+
 // =============================================================================
 // LAYER TESTS
 // =============================================================================
@@ -130,6 +287,37 @@ void test_layer_suite(TestFramework& tf) {
         }
     }
     tf.assert_true(all_valid, "All outputs must be in range [-1, 1]");
+
+    // Test contiguous parameter storage
+    tf.start_test("Layer Contiguous Weight Storage");
+    Layer layer3(3, 2);
+    auto params = layer3.parameters(); // neuron 0: w0 w1 w2 b, neuron 1: w0 w1 w2 b
+    params[5]->set_data(0.25);         // neuron 1, weight 1
+    tf.assert_true(layer3.weights()->rows() == 2 && layer3.weights()->cols() == 3 &&
+                   layer3.weights()->at(1, 1) == 0.25 && params[0]->is_bound(),
+                   "Scalar parameters should be views into the [nout x nin] weight buffer");
+
+    tf.start_test("Layer Scalar Gradients Land In Buffer");
+    auto out = layer3(x)[1];
+    out->backward();
+    tf.assert_equal(params[7]->grad(), layer3.bias()->grad()[1]);
+
+    tf.start_test("Layer Zero Grad Clears Buffers");
+    layer3.zero_grad();
+    double grad_sum = 0.0;
+    for (const auto& p : params) {
+        grad_sum += std::abs(p->grad());
+    }
+    tf.assert_equal(0.0, grad_sum);
+
+    tf.start_test("Parameter Views Keep Storage Alive");
+    ValuePtr survivor;
+    {
+        Layer temporary(2, 2);
+        survivor = temporary.parameters()[0];
+    }
+    survivor->set_data(1.5);
+    tf.assert_equal(1.5, survivor->data());
 }
 
 // =============================================================================
@@ -186,8 +374,1125 @@ void test_mlp_suite(TestFramework& tf) {
         grad_sum_after += p->grad();
     }
     tf.assert_equal(0.0, grad_sum_after, 1e-12);
+
+    // Test that a training step does not leak its graph
+    tf.start_test("MLP Training Step Releases Graph");
+    MLP mlp4(3, {4, 4, 1});
+    auto params4 = mlp4.parameters();
+    long live_before = Value::live_count();
+    {
+        auto xs = std::vector<ValuePtr>{make_value(1.0), make_value(-0.5), make_value(2.0)};
+        auto pred = mlp4(xs)[0];
+        auto loss = pow(pred - 1.0, 2.0);
+        mlp4.zero_grad();
+        loss->backward();
+        for (const auto& p : params4) {
+            p->set_data(p->data() - 0.05 * p->grad());
+        }
+    }
+    tf.assert_equal(static_cast<size_t>(live_before), static_cast<size_t>(Value::live_count()),
+                    "Every intermediate Value of the step should be freed");
+
+    // The parameter index is built once and handed out by reference
+    tf.start_test("MLP Parameter Index Is Cached");
+    const auto& first = mlp4.parameters();
+    const auto& second = mlp4.parameters();
+    bool cached = &first == &second && first.size() == 41 && &mlp4.parameter_spans() == &mlp4.parameter_spans();
+    const auto& spans = mlp4.parameter_spans();
+    cached = cached && spans.size() == 6 && spans[0].data == mlp4.layers()[0].weights()->data() &&
+             spans[5].grad == mlp4.layers()[2].bias()->grad();
+    tf.assert_true(cached, "parameters() and parameter_spans() should return the same cached index");
+
+    // Freezing the hidden layers leaves the head's gradients unchanged
+    tf.start_test("MLP Frozen Layers Get No Gradient");
+    std::vector<double> head_grads;
+    for (bool freeze : {false, true}) {
+        mlp4.set_requires_grad(0, !freeze);
+        mlp4.set_requires_grad(1, !freeze);
+        mlp4.zero_grad();
+        auto xs = std::vector<ValuePtr>{make_value(1.0), make_value(-0.5), make_value(2.0)};
+        for (auto& v : xs) {
+            v->set_requires_grad(false);
+        }
+        pow(mlp4(xs)[0] - 1.0, 2.0)->backward();
+        const auto& head = mlp4.parameter_spans();
+        if (!freeze) {
+            head_grads.assign(head[4].grad, head[4].grad + head[4].size);
+            continue;
+        }
+        bool frozen = !mlp4.layers()[0].requires_grad() && mlp4.layers()[2].requires_grad();
+        for (std::size_t k = 0; k < 4; ++k) {
+            frozen = frozen && std::all_of(head[k].grad, head[k].grad + head[k].size, [](double g) { return g == 0.0; });
+        }
+        frozen = frozen && std::equal(head_grads.begin(), head_grads.end(), head[4].grad);
+        tf.assert_true(frozen, "Only the trainable head should accumulate, with the same values");
+    }
+    mlp4.set_requires_grad(0, true);
+    mlp4.set_requires_grad(1, true);
+}
+
+
+// =============================================================================
+// BATCH TESTS
+// =============================================================================
+void test_batch_suite(TestFramework& tf) {
+    std::cout << "\n--- Mini-Batch Tests ---" << std::endl;
+
+    MLP mlp(3, {4, 2});
+    const std::size_t batch = 4;
+    const std::vector<double> xs = {1.0, -0.5, 2.0,   0.3, 0.1, -1.2,
+                                    -2.0, 0.7, 0.4,   0.0, 1.5, -0.3};
+    const std::vector<double> ys = {1.0, -1.0,  0.5, 0.5,  -1.0, 1.0,  0.0, 0.2};
+
+    // Reference: one scalar graph per sample, losses summed scalar by scalar
+    ValuePtr ref_loss = make_value(0.0);
+    std::vector<double> ref_out;
+    for (std::size_t i = 0; i < batch; ++i) {
+        std::vector<ValuePtr> x;
+        for (std::size_t j = 0; j < 3; ++j) {
+            x.push_back(make_value(xs[i * 3 + j]));
+        }
+        auto out = mlp(x);
+        for (std::size_t j = 0; j < out.size(); ++j) {
+            ref_out.push_back(out[j]->data());
+            ref_loss = ref_loss + pow(out[j] - ys[i * 2 + j], 2.0);
+        }
+    }
+    mlp.zero_grad();
+    ref_loss->backward();
+    std::vector<double> ref_grads;
+    for (const auto& p : mlp.parameters()) {
+        ref_grads.push_back(p->grad());
+    }
+
+    mlp.zero_grad();
+    BatchOutput result = mlp.forward_batch(xs.data(), ys.data(), batch);
+
+    tf.start_test("Batch Output Shape");
+    tf.assert_true(result.output->rows() == batch && result.output->cols() == 2,
+                   "Output should be [batch x nout]");
+
+    tf.start_test("Batch Output Matches Per-Sample Forward");
+    bool out_ok = true;
+    for (std::size_t i = 0; i < ref_out.size(); ++i) {
+        out_ok = out_ok && std::abs(ref_out[i] - result.output->data()[i]) < 1e-12;
+    }
+    tf.assert_true(out_ok, "Every batched prediction should equal the scalar prediction");
+
+    tf.start_test("Batch Loss Matches Summed Scalar Losses");
+    tf.assert_equal(ref_loss->data(), result.loss->at(0, 0), 1e-12);
+
+    tf.start_test("Batch Gradients Match Scalar Gradients");
+    result.loss->backward();
+    auto params = mlp.parameters();
+    bool grad_ok = params.size() == ref_grads.size();
+    for (std::size_t i = 0; grad_ok && i < params.size(); ++i) {
+        grad_ok = std::abs(ref_grads[i] - params[i]->grad()) < 1e-12;
+    }
+    tf.assert_true(grad_ok, "Backward through the batch should reach the same parameters");
+}
+
+// =============================================================================
+// CHECKPOINTING TESTS
+// =============================================================================
+void test_checkpoint_suite(TestFramework& tf) {
+    std::cout << "\n--- Gradient Checkpointing Tests ---" << std::endl;
+
+    MLP mlp(3, {6, 6, 6, 6, 6, 6, 6, 2});
+    const std::size_t batch = 5;
+    std::vector<double> xs(batch * 3), ys(batch * 2);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = std::sin(0.7 * static_cast<double>(i));
+    }
+    for (std::size_t i = 0; i < ys.size(); ++i) {
+        ys[i] = std::cos(1.3 * static_cast<double>(i));
+    }
+
+    auto run = [&](std::size_t interval, std::size_t& nodes) {
+        mlp.set_checkpoint_interval(interval);
+        mlp.zero_grad();
+        BatchOutput out = mlp.forward_batch(xs.data(), ys.data(), batch);
+        std::vector<Tensor*> order;
+        out.loss->build_topo(order);
+        nodes = order.size();
+        out.loss->backward();
+        std::vector<double> result(out.output->data(), out.output->data() + out.output->size());
+        for (const auto& span : mlp.parameter_spans()) {
+            result.insert(result.end(), span.grad, span.grad + span.size);
+        }
+        return result;
+    };
+
+    std::size_t full_nodes = 0, checkpointed_nodes = 0, uneven_nodes = 0, pooled_nodes = 0;
+    const std::vector<double> full = run(0, full_nodes);
+    const std::vector<double> checkpointed = run(3, checkpointed_nodes);
+    const std::vector<double> uneven = run(5, uneven_nodes);
+    ThreadPool pool(3);
+    mlp.set_thread_pool(&pool);
+    const std::vector<double> pooled = run(3, pooled_nodes);
+    mlp.set_thread_pool(nullptr);
+
+    tf.start_test("Checkpointed Outputs And Gradients Are Exact");
+    tf.assert_true(full == checkpointed && full == uneven && full == pooled,
+                   "Recomputing inside backward() should reproduce every output and gradient bit for bit");
+
+    tf.start_test("Checkpointed Graph Keeps Fewer Activations");
+    // 8 layers in groups of 3: 3 group nodes instead of 8 layer nodes
+    tf.assert_equal(full_nodes - 5, checkpointed_nodes, "Only the group boundaries should stay in the graph");
+    tf.assert_true(uneven_nodes < full_nodes, "Uneven groups should also shrink the graph");
+
+    tf.start_test("Trainer Replicas Follow The Checkpoint Setting");
+    mlp.set_checkpoint_interval(3);
+    Trainer trainer(mlp, 2);
+    mlp.zero_grad();
+    trainer.backward_batch(xs.data(), ys.data(), batch);
+    std::vector<double> checkpointed_grads;
+    for (const auto& span : mlp.parameter_spans()) {
+        checkpointed_grads.insert(checkpointed_grads.end(), span.grad, span.grad + span.size);
+    }
+    mlp.set_checkpoint_interval(0);
+    mlp.zero_grad();
+    trainer.backward_batch(xs.data(), ys.data(), batch);
+    bool same = true;
+    std::size_t k = 0;
+    for (const auto& span : mlp.parameter_spans()) {
+        for (std::size_t i = 0; i < span.size; ++i) {
+            same = same && span.grad[i] == checkpointed_grads[k++];
+        }
+    }
+    tf.assert_true(same, "Sharded training should give the same gradients with and without checkpoints");
+
+    tf.start_test("Mixed Activations Checkpoint Their Tanh Runs");
+    using A = Activation;
+    MLP mixed(3, {6, 6, 6, 6, 6, 2}, {A::Tanh, A::Tanh, A::Relu, A::Tanh, A::Tanh, A::Linear});
+    auto mixed_run = [&](std::size_t interval, std::size_t& nodes) {
+        mixed.set_checkpoint_interval(interval);
+        mixed.zero_grad();
+        BatchOutput out = mixed.forward_batch(xs.data(), ys.data(), batch);
+        std::vector<Tensor*> order;
+        out.loss->build_topo(order);
+        nodes = order.size();
+        out.loss->backward();
+        std::vector<double> result(out.output->data(), out.output->data() + out.output->size());
+        for (const auto& span : mixed.parameter_spans()) {
+            result.insert(result.end(), span.grad, span.grad + span.size);
+        }
+        return result;
+    };
+    std::size_t mixed_full_nodes = 0, mixed_nodes = 0;
+    const std::vector<double> mixed_full = mixed_run(0, mixed_full_nodes);
+    const std::vector<double> mixed_checkpointed = mixed_run(6, mixed_nodes);
+    // One group of 6 splits into two tanh pairs, each one node instead of two
+    tf.assert_equal(mixed_full_nodes - 2, mixed_nodes, "Both tanh runs should be checkpointed");
+    tf.assert_true(mixed_full == mixed_checkpointed, "Splitting the group should not change outputs or gradients");
+}
+
+// =============================================================================
+// THREADING TESTS
+// =============================================================================
+void test_threading_suite(TestFramework& tf) {
+    std::cout << "\n--- Threading Tests ---" << std::endl;
+
+    tf.start_test("Parallel For Covers Every Index Once");
+    {
+        ThreadPool pool(4);
+        std::vector<int> hits(1000, 0);
+        pool.parallel_for(hits.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                hits[i]++;
+            }
+        });
+        bool once = std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; });
+        tf.assert_true(once && pool.size() == 4, "Each iteration should run exactly once");
+    }
+
+    tf.start_test("Parallel For Rethrows Chunk Exceptions");
+    {
+        ThreadPool pool(3);
+        bool threw = false;
+        try {
+            pool.parallel_for(10, [](std::size_t begin, std::size_t) {
+                if (begin == 0) {
+                    throw std::runtime_error("chunk failed");
+                }
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        tf.assert_true(threw, "The caller should see the exception");
+    }
+
+    // A layer wide enough that the input gradient spans several column blocks
+    const std::size_t nin = 300, nout = 37, batch = 5;
+    std::vector<double> xs(batch * nin);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = std::sin(0.37 * static_cast<double>(i));
+    }
+    Layer layer(static_cast<int>(nin), static_cast<int>(nout));
+
+    auto run = [&](ThreadPool* pool, std::vector<double>& out) {
+        layer.set_thread_pool(pool);
+        layer.zero_grad();
+        auto x = make_tensor(batch, nin, xs);
+        auto y = layer(x);
+        sum(pow(y, 2.0))->backward();
+        out.assign(y->data(), y->data() + y->size());
+        out.insert(out.end(), x->grad(), x->grad() + x->size());
+        out.insert(out.end(), layer.weights()->grad(), layer.weights()->grad() + layer.weights()->size());
+        out.insert(out.end(), layer.bias()->grad(), layer.bias()->grad() + layer.bias()->size());
+    };
+
+    std::vector<double> serial;
+    run(nullptr, serial);
+    bool identical = true;
+    for (std::size_t threads : {1, 2, 3, 8}) {
+        ThreadPool pool(threads);
+        std::vector<double> threaded;
+        run(&pool, threaded);
+        identical = identical && threaded == serial; // Bitwise, not within a tolerance
+    }
+    layer.set_thread_pool(nullptr);
+    tf.start_test("Threaded Batch Layer Is Bitwise Deterministic");
+    tf.assert_true(identical, "Outputs and all gradients should not depend on the thread count");
+
+    tf.start_test("Threaded Scalar Layer Forward");
+    {
+        Layer small(3, 16);
+        std::vector<ValuePtr> x = {make_value(0.5), make_value(-1.0), make_value(2.0)};
+        auto expected = small(x);
+        ThreadPool pool(4);
+        small.set_thread_pool(&pool);
+        auto actual = small(x);
+        bool same = actual.size() == expected.size();
+        for (std::size_t i = 0; same && i < actual.size(); ++i) {
+            same = actual[i]->data() == expected[i]->data();
+        }
+        tf.assert_true(same, "Concurrent neurons should produce the serial outputs in order");
+    }
 }
 
+// =============================================================================
+// TRAINER TESTS
+// =============================================================================
+void test_trainer_suite(TestFramework& tf) {
+    std::cout << "\n--- Data-Parallel Trainer Tests ---" << std::endl;
+
+    MLP mlp(3, {8, 8, 2});
+    const std::size_t batch = 7; // Not a multiple of the thread counts below
+    std::vector<double> xs(batch * 3), ys(batch * 2);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = std::sin(1.3 * static_cast<double>(i));
+    }
+    for (std::size_t i = 0; i < ys.size(); ++i) {
+        ys[i] = std::cos(0.7 * static_cast<double>(i));
+    }
+
+    mlp.zero_grad();
+    BatchOutput ref = mlp.forward_batch(xs.data(), ys.data(), batch);
+    ref.loss->backward();
+    std::vector<double> ref_grads;
+    for (const auto& p : mlp.parameters()) {
+        ref_grads.push_back(p->grad());
+    }
+
+    bool loss_ok = true, grad_ok = true, repeatable = true;
+    for (std::size_t threads : {1, 2, 3, 4, 9}) {
+        Trainer trainer(mlp, threads);
+        std::vector<double> first;
+        for (int run = 0; run < 2; ++run) {
+            mlp.zero_grad();
+            double loss = trainer.backward_batch(xs.data(), ys.data(), batch);
+            loss_ok = loss_ok && std::abs(loss - ref.loss->at(0, 0)) < 1e-12;
+            std::vector<double> grads;
+            for (const auto& p : mlp.parameters()) {
+                grads.push_back(p->grad());
+            }
+            for (std::size_t i = 0; i < grads.size(); ++i) {
+                grad_ok = grad_ok && std::abs(grads[i] - ref_grads[i]) < 1e-12;
+            }
+            if (run == 0) {
+                first = grads;
+            } else {
+                repeatable = repeatable && grads == first;
+            }
+        }
+    }
+
+    tf.start_test("Sharded Loss Matches Full Batch");
+    tf.assert_true(loss_ok, "Summed shard losses should equal the full batch loss");
+    tf.start_test("Reduced Gradients Match Full Batch");
+    tf.assert_true(grad_ok, "Tree-reduced gradients should equal single-graph gradients");
+    tf.start_test("Reduction Is Repeatable");
+    tf.assert_true(repeatable, "The same thread count should reproduce the same gradients exactly");
+
+    tf.start_test("Trainer Step Decreases Loss");
+    Trainer trainer(mlp, 4);
+    double before = trainer.step(xs.data(), ys.data(), batch, 0.01);
+    double after = before;
+    for (int i = 0; i < 20; ++i) {
+        after = trainer.step(xs.data(), ys.data(), batch, 0.01);
+    }
+    tf.assert_true(after < before, "Gradient descent through the trainer should reduce the loss");
+}
+
+// =============================================================================
+// OPTIMIZER TESTS
+// =============================================================================
+void test_optimizer_suite(TestFramework& tf) {
+    std::cout << "\n--- Optimizer Tests ---" << std::endl;
+
+    MLP mlp(3, {4, 2});
+    const auto& spans = mlp.parameter_spans();
+    tf.start_test("Parameter Spans Cover Every Parameter");
+    std::size_t total = 0;
+    for (const auto& span : spans) {
+        total += span.size;
+    }
+    tf.assert_true(spans.size() == 4 && total == mlp.parameters().size(),
+                   "Two spans per layer should cover all weights and biases");
+
+    // Give every parameter a known gradient through its scalar view
+    auto params = mlp.parameters();
+    auto set_grads = [&]() {
+        mlp.zero_grad();
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            params[i]->add_to_grad(std::sin(static_cast<double>(i)));
+        }
+    };
+    auto snapshot = [&]() {
+        std::vector<double> data;
+        for (const auto& p : params) {
+            data.push_back(p->data());
+        }
+        return data;
+    };
+
+    tf.start_test("SGD Step");
+    {
+        SGD sgd(spans, 0.1);
+        set_grads();
+        auto before = snapshot();
+        sgd.step();
+        bool ok = true;
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            ok = ok && std::abs(params[i]->data() - (before[i] - 0.1 * params[i]->grad())) < 1e-15;
+        }
+        tf.assert_true(ok, "Each parameter should move by -lr * grad");
+    }
+
+    tf.start_test("SGD With Momentum");
+    {
+        SGD sgd(spans, 0.1, 0.9);
+        auto expected = snapshot();
+        std::vector<double> velocity(params.size(), 0.0);
+        for (int step = 0; step < 3; ++step) {
+            set_grads();
+            for (std::size_t i = 0; i < params.size(); ++i) {
+                velocity[i] = 0.9 * velocity[i] + params[i]->grad();
+                expected[i] -= 0.1 * velocity[i];
+            }
+            sgd.step();
+        }
+        bool ok = true;
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            ok = ok && std::abs(params[i]->data() - expected[i]) < 1e-12;
+        }
+        tf.assert_true(ok, "Parameters should follow the momentum recurrence");
+    }
+
+    tf.start_test("Adam With Bias Correction");
+    {
+        Adam adam(spans, 0.01);
+        auto expected = snapshot();
+        std::vector<double> m(params.size(), 0.0), v(params.size(), 0.0);
+        for (int step = 1; step <= 3; ++step) {
+            set_grads();
+            for (std::size_t i = 0; i < params.size(); ++i) {
+                double g = params[i]->grad();
+                m[i] = 0.9 * m[i] + 0.1 * g;
+                v[i] = 0.999 * v[i] + 0.001 * g * g;
+                double m_hat = m[i] / (1 - std::pow(0.9, step));
+                double v_hat = v[i] / (1 - std::pow(0.999, step));
+                expected[i] -= 0.01 * m_hat / (std::sqrt(v_hat) + 1e-8);
+            }
+            adam.step();
+        }
+        bool ok = adam.steps() == 3;
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            ok = ok && std::abs(params[i]->data() - expected[i]) < 1e-12;
+        }
+        tf.assert_true(ok, "Parameters should follow the bias-corrected Adam update");
+    }
+
+    tf.start_test("Optimizer Zero Grad");
+    {
+        SGD sgd(spans, 0.1);
+        set_grads();
+        sgd.zero_grad();
+        bool zero = std::all_of(params.begin(), params.end(), [](const ValuePtr& p) { return p->grad() == 0.0; });
+        tf.assert_true(zero, "Every captured gradient should be cleared");
+    }
+
+    tf.start_test("Trainer With Adam Decreases Loss");
+    {
+        const std::vector<double> xs = {1.0, -0.5, 2.0, 0.3, 0.1, -1.2, -2.0, 0.7, 0.4, 0.0, 1.5, -0.3};
+        const std::vector<double> ys = {1.0, -1.0, 0.5, 0.5, -1.0, 1.0, 0.0, 0.2};
+        Adam adam(spans, 0.05);
+        Trainer trainer(mlp, 2);
+        double before = trainer.step(xs.data(), ys.data(), 4, adam);
+        double after = before;
+        for (int i = 0; i < 30; ++i) {
+            after = trainer.step(xs.data(), ys.data(), 4, adam);
+        }
+        tf.assert_true(after < before, "Adam steps should reduce the training loss");
+    }
+
+    tf.start_test("Pipelined Trainer Matches The Serial Loop");
+    {
+        const std::vector<double> xs = {1.0, -0.5, 2.0, 0.3, 0.1, -1.2, -2.0, 0.7, 0.4, 0.0, 1.5, -0.3};
+        const std::vector<double> ys = {1.0, -1.0, 0.5, 0.5, -1.0, 1.0, 0.0, 0.2};
+        const std::vector<Activation> acts = {Activation::Tanh, Activation::Tanh, Activation::Relu, Activation::Linear};
+        bool ok = true;
+        for (std::size_t interval : {0, 2}) {
+            MLP serial(3, {6, 5, 4, 2}, acts), piped(3, {6, 5, 4, 2}, acts);
+            serial.initialize(Init::XavierUniform, Rng(11));
+            piped.initialize(Init::XavierUniform, Rng(11));
+            serial.set_checkpoint_interval(interval);
+            piped.set_checkpoint_interval(interval);
+            Adam serial_adam(serial.parameter_spans(), 0.01), piped_adam(piped.parameter_spans(), 0.01);
+            PipelinedTrainer trainer(piped, piped_adam);
+            for (int i = 0; i < 5; ++i) {
+                serial.zero_grad();
+                BatchOutput out = serial.forward_batch(xs.data(), ys.data(), 4);
+                out.loss->backward();
+                serial_adam.step();
+                ok = ok && trainer.step(xs.data(), ys.data(), 4) == out.loss->at(0, 0);
+            }
+            trainer.synchronize();
+            const auto &a = serial.parameter_spans(), &b = piped.parameter_spans();
+            for (std::size_t k = 0; k < a.size(); ++k) {
+                ok = ok && std::equal(a[k].data, a[k].data + a[k].size, b[k].data) &&
+                     std::all_of(b[k].grad, b[k].grad + b[k].size, [](double g) { return g == 0.0; });
+            }
+        }
+        tf.assert_true(ok, "Per-layer updates should reproduce the serial step bit for bit");
+    }
+
+    tf.start_test("Pipelined Trainer Rejects A Foreign Optimizer");
+    {
+        MLP other(3, {4, 2});
+        SGD foreign(other.parameter_spans(), 0.1);
+        bool threw = false;
+        try {
+            PipelinedTrainer trainer(mlp, foreign);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        tf.assert_true(threw, "The optimizer must update the trainer's model");
+    }
+
+    tf.start_test("Frozen Layers Stay Fixed On The Batched Paths");
+    {
+        const std::vector<double> xs = {1.0, -0.5, 2.0, 0.3, 0.1, -1.2, -2.0, 0.7, 0.4, 0.0, 1.5, -0.3};
+        const std::vector<double> ys = {1.0, -1.0, 0.5, 0.5, -1.0, 1.0, 0.0, 0.2};
+        auto values = [](const MLP& m, std::size_t first, std::size_t last) {
+            std::vector<double> all;
+            for (std::size_t k = first; k < last; ++k) {
+                const ParameterSpan& span = m.parameter_spans()[k];
+                all.insert(all.end(), span.data, span.data + span.size);
+            }
+            return all;
+        };
+        bool ok = true;
+        // 0: SGD with momentum, 1: Adam, 2: checkpointed Adam, 3: Trainer, 4: PipelinedTrainer
+        for (int path = 0; path < 5; ++path) {
+            MLP m(3, {6, 5, 2});
+            m.initialize(Init::XavierUniform, Rng(3));
+            m.set_checkpoint_interval(path == 2 ? 2 : 0);
+            SGD sgd(m.parameter_spans(), 0.05, 0.9);
+            Adam adam(m.parameter_spans(), 0.01);
+            Optimizer& opt = path == 0 ? static_cast<Optimizer&>(sgd) : adam;
+            auto serial_step = [&] {
+                opt.zero_grad();
+                m.forward_batch(xs.data(), ys.data(), 4).loss->backward();
+                opt.step();
+            };
+            // One trainable step first, so the optimizer state of layer 0 is not zero
+            serial_step();
+            m.set_requires_grad(0, false);
+            const std::vector<double> frozen = values(m, 0, 2), head = values(m, 4, 6);
+            if (path == 3) {
+                Trainer trainer(m, 2);
+                for (int i = 0; i < 3; ++i) {
+                    trainer.step(xs.data(), ys.data(), 4, opt);
+                }
+            } else if (path == 4) {
+                PipelinedTrainer trainer(m, opt);
+                for (int i = 0; i < 3; ++i) {
+                    trainer.step(xs.data(), ys.data(), 4);
+                }
+                trainer.synchronize();
+            } else {
+                for (int i = 0; i < 3; ++i) {
+                    serial_step();
+                }
+            }
+            const auto& s = m.parameter_spans();
+            const auto is_zero = [](double g) { return g == 0.0; };
+            ok = ok && values(m, 0, 2) == frozen && values(m, 4, 6) != head &&
+                 std::all_of(s[0].grad, s[0].grad + s[0].size, is_zero) &&
+                 std::all_of(s[1].grad, s[1].grad + s[1].size, is_zero);
+        }
+        tf.assert_true(ok, "A frozen layer should get no gradient and keep its weights bit for bit");
+    }
+}
+
+// =============================================================================
+// INFERENCE TESTS
+// =============================================================================
+void test_inference_suite(TestFramework& tf) {
+    std::cout << "\n--- Inference Tests ---" << std::endl;
+
+    MLP mlp(3, {16, 8, 2});
+    const std::vector<double> xs = {1.0, -0.5, 2.0, 0.3, 0.1, -1.2};
+
+    tf.start_test("Predict Matches Graph Forward");
+    bool same = true;
+    for (std::size_t i = 0; i < 2; ++i) {
+        auto out = mlp({make_value(xs[i * 3]), make_value(xs[i * 3 + 1]), make_value(xs[i * 3 + 2])});
+        double y[2];
+        mlp.predict(xs.data() + i * 3, y);
+        for (std::size_t j = 0; j < 2; ++j) {
+            same = same && std::abs(out[j]->data() - y[j]) < 1e-12;
+        }
+    }
+    tf.assert_true(same, "predict() should agree with the autograd forward pass");
+
+    tf.start_test("Batch Predict Matches Single Predict");
+    double batch_out[4], single_out[4];
+    mlp.predict(xs.data(), batch_out, 2);
+    mlp.predict(xs.data(), single_out);
+    mlp.predict(xs.data() + 3, single_out + 2);
+    tf.assert_true(std::equal(batch_out, batch_out + 4, single_out), "Each batch row should be one predict()");
+
+    tf.start_test("Predict Does Not Allocate");
+    long live_before = Value::live_count();
+    long allocations_before = g_allocations.load();
+    double y[2];
+    for (int i = 0; i < 100; ++i) {
+        mlp.predict(xs.data(), y);
+    }
+    // Read the counters before assert_true builds its message string
+    bool quiet = g_allocations.load() == allocations_before && Value::live_count() == live_before;
+    tf.assert_true(quiet, "Warm predict() calls should neither allocate nor create Values");
+}
+
+// =============================================================================
+// REDUCED PRECISION TESTS
+// =============================================================================
+void test_precision_suite(TestFramework& tf) {
+    std::cout << "\n--- Reduced Precision Inference Tests ---" << std::endl;
+
+    tf.start_test("bfloat16 Rounding");
+    // bfloat16 has 7 mantissa bits, so 1 + 1/256 and 1 + 3/256 are exact ties
+    bool rounding = static_cast<float>(bfloat16(1.0f)) == 1.0f && static_cast<float>(bfloat16(-2.5f)) == -2.5f &&
+                    static_cast<float>(bfloat16(1.0f + 1.0f / 256)) == 1.0f &&
+                    static_cast<float>(bfloat16(1.0f + 3.0f / 256)) == 1.0f + 4.0f / 256 &&
+                    std::isnan(static_cast<float>(bfloat16(std::nanf(""))));
+    tf.assert_true(rounding, "Conversion should round to nearest even and keep NaNs");
+
+    MLP mlp(5, {24, 12, 3});
+    const std::vector<double> xs = {1.0, -0.5, 2.0, 0.3, 0.1, -1.2, 0.4, 0.9, -0.7, 0.05};
+    double ref[6];
+    mlp.predict(xs.data(), ref, 2);
+
+    tf.start_test("Double Snapshot Is Exact");
+    InferenceMLP<double> f64(mlp);
+    double y64[6];
+    f64.predict(xs.data(), y64, 2);
+    tf.assert_true(std::equal(ref, ref + 6, y64), "A double snapshot should reproduce MLP::predict bit for bit");
+
+    std::vector<float> xf(xs.begin(), xs.end());
+    auto max_error = [&](const float* y) {
+        double err = 0.0;
+        for (int i = 0; i < 6; ++i) {
+            err = std::max(err, std::abs(y[i] - ref[i]));
+        }
+        return err;
+    };
+
+    tf.start_test("Float Snapshot Is Close");
+    InferenceMLP<float> f32(mlp);
+    float y32[6];
+    f32.predict(xf.data(), y32, 2);
+    tf.assert_true(max_error(y32) < 1e-5, "float outputs should be within single-precision rounding");
+    tf.assert_equal(f64.bytes() / 2, f32.bytes(), "float should halve the storage");
+
+    tf.start_test("bfloat16 Snapshot Is Close");
+    InferenceMLP<bfloat16> bf16(mlp);
+    float ybf[6];
+    bf16.predict(xf.data(), ybf, 2);
+    tf.assert_true(max_error(ybf) < 5e-2, "bfloat16 outputs should be within a few bf16 ulps");
+    tf.assert_true(bf16.bytes() < f32.bytes() * 0.6, "bfloat16 should roughly halve the float weight storage");
+
+    tf.start_test("Snapshot Reload");
+    for (const auto& p : mlp.parameters()) {
+        p->set_data(p->data() * 0.5);
+    }
+    mlp.predict(xs.data(), ref, 2);
+    f64.load(mlp);
+    f64.predict(xs.data(), y64, 2);
+    tf.assert_true(std::equal(ref, ref + 6, y64), "load() should pick up the new weights");
+    bool threw = false;
+    try {
+        f64.load(MLP(5, {24, 13, 3}));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "Loading a different architecture should throw");
+}
+
+// =============================================================================
+// INT8 QUANTIZATION TESTS
+// =============================================================================
+void test_quantization_suite(TestFramework& tf) {
+    std::cout << "\n--- Int8 Quantization Tests ---" << std::endl;
+
+    MLP mlp(16, {64, 64, 4}, {Activation::Tanh, Activation::Relu, Activation::Tanh});
+    mlp.initialize(Init::XavierUniform, Rng(3));
+    const Rng data(17);
+    std::vector<double> calibration(128 * 16), validation(256 * 16);
+    for (std::size_t i = 0; i < calibration.size(); ++i) {
+        calibration[i] = 4.0 * data.uniform(i) - 2.0;
+    }
+    for (std::size_t i = 0; i < validation.size(); ++i) {
+        validation[i] = 4.0 * data.stream(1).uniform(i) - 2.0;
+    }
+
+    tf.start_test("Int8 Snapshot Is Close");
+    QuantizedMLP per_row(mlp, calibration.data(), 128);
+    QuantizedMLP per_layer(mlp, calibration.data(), 128, WeightScale::PerLayer);
+    const double row_error = per_row.max_error(mlp, validation.data(), 256);
+    const double layer_error = per_layer.max_error(mlp, validation.data(), 256);
+    tf.assert_true(row_error < 0.05 && layer_error < 0.05, "int8 outputs should stay within a few quantization steps");
+
+    tf.start_test("Int8 Weights Take About An Eighth");
+    InferenceMLP<double> f64(mlp);
+    tf.assert_true(per_row.bytes() * 6 < f64.bytes(), "int8 weights plus float scales should be near 1/8 of double");
+
+    tf.start_test("Int8 Batch Predict Matches Single Predict");
+    std::vector<float> xf(validation.begin(), validation.begin() + 32);
+    float batch_out[8], single_out[8];
+    per_row.predict(xf.data(), batch_out, 2);
+    per_row.predict(xf.data(), single_out);
+    per_row.predict(xf.data() + 16, single_out + 4);
+    tf.assert_true(std::equal(batch_out, batch_out + 8, single_out), "Each batch row should be one predict()");
+
+    tf.start_test("Int8 Predict Does Not Allocate");
+    long allocations_before = g_allocations.load();
+    for (int i = 0; i < 100; ++i) {
+        per_row.predict(xf.data(), single_out);
+    }
+    bool quiet = g_allocations.load() == allocations_before;
+    tf.assert_true(quiet, "Warm predict() calls should not allocate");
+
+    tf.start_test("Int8 Needs Calibration Data");
+    bool threw = false;
+    try {
+        QuantizedMLP bad(mlp, calibration.data(), 0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "Quantizing without calibration samples should throw");
+}
+
+// =============================================================================
+// SERIALIZATION TESTS
+// =============================================================================
+void test_serialization_suite(TestFramework& tf) {
+    std::cout << "\n--- Model Serialization Tests ---" << std::endl;
+
+    const std::string path = "test_nn_model.mgrd";
+    MLP mlp(3, {7, 5, 2});
+    save_model(mlp, path);
+    const std::vector<double> xs = {1.0, -0.5, 2.0, 0.3, 0.1, -1.2};
+    double ref[4];
+    mlp.predict(xs.data(), ref, 2);
+
+    tf.start_test("Loaded Model Matches Saved Model");
+    MLP loaded = load_model(path);
+    double out[4];
+    loaded.predict(xs.data(), out, 2);
+    bool same_params = loaded.parameters().size() == mlp.parameters().size();
+    for (std::size_t i = 0; same_params && i < mlp.parameters().size(); ++i) {
+        same_params = loaded.parameters()[i]->data() == mlp.parameters()[i]->data();
+    }
+    tf.assert_true(same_params, "Every parameter should survive the round trip exactly");
+    tf.assert_true(std::equal(ref, ref + 4, out), "The loaded network should predict identically");
+
+    tf.start_test("Mapped Model Predicts In Place");
+    MappedModel mapped(path);
+    mapped.predict(xs.data(), out, 2);
+    tf.assert_equal(static_cast<size_t>(3), mapped.layers().size(), "Topology should come from the header");
+    tf.assert_true(std::equal(ref, ref + 4, out), "Mapped weights should predict identically");
+    MappedModel moved(std::move(mapped));
+    moved.predict(xs.data(), out, 2);
+    tf.assert_true(std::equal(ref, ref + 4, out), "A moved-from mapping should stay usable in its new owner");
+
+    tf.start_test("Malformed Files Are Rejected");
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto rejects = [&](const std::string& contents) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+        try {
+            MappedModel bad(path);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    std::string bad_magic = bytes;
+    bad_magic[0] = 'X';
+    std::string bad_version = bytes;
+    bad_version[4] = 9;
+    bool rejected = rejects(bad_magic) && rejects(bad_version) && rejects(bytes.substr(0, bytes.size() - 8)) &&
+                    rejects("");
+    tf.assert_true(rejected, "Bad magic, version, truncation and empty files should throw");
+    bool missing = false;
+    std::remove(path.c_str());
+    try {
+        load_model(path);
+    } catch (const std::runtime_error&) {
+        missing = true;
+    }
+    tf.assert_true(missing, "A missing file should throw");
+}
+
+// =============================================================================
+// DATASET TESTS
+// =============================================================================
+void test_dataset_suite(TestFramework& tf) {
+    std::cout << "\n--- Dataset Loader Tests ---" << std::endl;
+
+    // 10 samples of 2 inputs and 1 target
+    const std::size_t samples = 10;
+    std::vector<double> xs, ys;
+    const std::string csv_path = "test_nn_data.csv", bin_path = "test_nn_data.bin";
+    {
+        std::ofstream csv(csv_path);
+        std::ofstream bin(bin_path, std::ios::binary);
+        for (std::size_t i = 0; i < samples; ++i) {
+            const double r[3] = {0.5 * static_cast<double>(i), -0.25 * static_cast<double>(i), i % 2 ? 1.0 : -1.0};
+            xs.insert(xs.end(), r, r + 2);
+            ys.push_back(r[2]);
+            csv << r[0] << ", " << r[1] << "," << r[2] << "\n";
+            if (i == 4) {
+                csv << "\n"; // Blank lines are skipped
+            }
+            bin.write(reinterpret_cast<const char*>(r), sizeof r);
+        }
+    }
+
+    // Collect one epoch, checking it against the written samples
+    auto epoch_ok = [&](BatchLoader& loader) {
+        std::vector<std::size_t> sizes;
+        std::vector<double> seen_x, seen_y;
+        while (const Batch* b = loader.next()) {
+            sizes.push_back(b->size);
+            seen_x.insert(seen_x.end(), b->x, b->x + b->size * 2);
+            seen_y.insert(seen_y.end(), b->y, b->y + b->size);
+        }
+        return sizes == std::vector<std::size_t>{4, 4, 2} && seen_x == xs && seen_y == ys && !loader.next();
+    };
+
+    tf.start_test("CSV Batches Match The File");
+    BatchLoader csv_loader(std::make_unique<CsvDataset>(csv_path, 2, 1), 4);
+    tf.assert_true(epoch_ok(csv_loader), "Batches should cover every sample in order, the last one short");
+    csv_loader.reset();
+    tf.assert_true(epoch_ok(csv_loader), "reset() should replay the same epoch");
+
+    tf.start_test("Binary Batches Match The File");
+    BatchLoader bin_loader(std::make_unique<BinaryDataset>(bin_path, 2, 1), 4);
+    tf.assert_true(epoch_ok(bin_loader), "Batches should cover every sample in order, the last one short");
+
+    tf.start_test("Batches Feed The Trainer");
+    MLP mlp(2, {4, 1});
+    Trainer trainer(mlp, 2);
+    SGD sgd(mlp.parameter_spans(), 0.05);
+    bin_loader.reset();
+    double first = 0.0, last = 0.0;
+    for (int epoch = 0; epoch < 30; ++epoch) {
+        double total = 0.0;
+        while (const Batch* b = bin_loader.next()) {
+            total += trainer.step(b->x, b->y, b->size, sgd);
+        }
+        bin_loader.reset();
+        (epoch == 0 ? first : last) = total;
+    }
+    tf.assert_true(last < first, "Training from the loader should reduce the loss");
+
+    tf.start_test("Loader Epochs Feed The Pipelined Trainer");
+    MLP piped(2, {4, 1});
+    SGD piped_sgd(piped.parameter_spans(), 0.05);
+    PipelinedTrainer pipeline(piped, piped_sgd);
+    first = pipeline.run_epoch(bin_loader);
+    for (int epoch = 0; epoch < 30; ++epoch) {
+        bin_loader.reset();
+        last = pipeline.run_epoch(bin_loader);
+    }
+    tf.assert_true(last < first, "Training from the loader should reduce the loss");
+
+    tf.start_test("Malformed CSV Is Reported");
+    {
+        std::ofstream csv(csv_path, std::ios::trunc);
+        csv << "1,2,3\n4,5,6\n7,oops,9\n";
+    }
+    BatchLoader bad(std::make_unique<CsvDataset>(csv_path, 2, 1), 2);
+    bool first_ok = bad.next() != nullptr, threw = false;
+    try {
+        bad.next();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    tf.assert_true(first_ok && threw, "The loader thread's parse error should surface from next()");
+    std::remove(csv_path.c_str());
+    std::remove(bin_path.c_str());
+}
+
+// =============================================================================
+// PROFILING TESTS
+// =============================================================================
+void test_profile_suite(TestFramework& tf) {
+    std::cout << "\n--- Profiling Tests ---" << std::endl;
+
+    MLP mlp(2, {3, 1});
+    profile::reset();
+    auto out = mlp({make_value(0.5), make_value(-1.0)});
+    out[0]->backward();
+    const std::string summary = profile::summary();
+    std::ostringstream trace;
+    profile::write_chrome_trace(trace);
+
+    if (!profile::enabled) {
+        tf.start_test("Profiling Compiled Out");
+        tf.assert_true(profile::nodes(Op::Tanh) == 0 && profile::bytes(profile::Alloc::Node) == 0,
+                       "Counters should stay zero without MICROGRAD_ENABLE_PROFILING");
+        tf.assert_true(summary.find("disabled") != std::string::npos, "The summary should say profiling is off");
+        tf.assert_true(trace.str().find("\"traceEvents\":[\n]") != std::string::npos,
+                       "The trace should be valid and empty");
+        return;
+    }
+
+    tf.start_test("Node Counters");
+    tf.assert_equal(std::size_t(4), static_cast<std::size_t>(profile::nodes(Op::Tanh)), "One tanh per neuron");
+    tf.assert_equal(std::size_t(2), static_cast<std::size_t>(profile::nodes(Op::None)), "Two input leaves");
+    tf.assert_true(profile::bytes(profile::Alloc::Node) ==
+                       sizeof(Value) * (profile::nodes(Op::None) + profile::nodes(Op::Const) +
+                                        profile::nodes(Op::Add) + profile::nodes(Op::Mul) +
+                                        profile::nodes(Op::Tanh) + profile::nodes(Op::Exp) + profile::nodes(Op::Pow)),
+                   "Every heap node should be counted in bytes");
+
+    tf.start_test("Phases Per Layer");
+    for (const char* phase : {"forward layer 0", "forward layer 1", "backward layer 0", "backward layer 1",
+                              "topo_sort"}) {
+        tf.assert_true(summary.find(phase) != std::string::npos, std::string("Summary should list ") + phase);
+    }
+
+    tf.start_test("Chrome Trace");
+    const std::string json = trace.str();
+    tf.assert_true(json.find("\"ph\":\"X\"") != std::string::npos &&
+                       json.find("\"args\":{\"layer\":1}") != std::string::npos,
+                   "The trace should hold complete events tagged with their layer");
+    profile::reset();
+    std::ostringstream empty;
+    profile::write_chrome_trace(empty);
+    tf.assert_true(empty.str().find("\"traceEvents\":[\n]") != std::string::npos, "reset() should drop events");
+}
+
+// =============================================================================
+// ACTIVATION TESTS
+// =============================================================================
+void test_activation_suite(TestFramework& tf) {
+    std::cout << "\n--- Per-Layer Activation Tests ---" << std::endl;
+
+    const std::vector<Activation> acts = {Activation::Relu, Activation::Gelu, Activation::Sigmoid, Activation::Linear};
+    MLP mlp(3, {6, 5, 4, 2}, acts);
+    mlp.initialize(Init::HeUniform, Rng(3));
+    const std::vector<double> xs = {0.5, -1.0, 2.0, -0.3, 0.8, 0.1};
+    const std::vector<double> ys = {0.2, -0.4, 1.0, 0.0};
+
+    tf.start_test("Layers Keep Their Activation");
+    tf.assert_true(mlp.activations() == acts && mlp.layers()[1].activation() == Activation::Gelu &&
+                       MLP(3, {2}).layers()[0].activation() == Activation::Tanh,
+                   "The activations should be the ones asked for, tanh by default");
+
+    // Scalar graph for both samples, reduced with the fused loss
+    std::vector<ValuePtr> preds, targets;
+    for (std::size_t i = 0; i < 2; ++i) {
+        auto out = mlp({make_value(xs[3 * i]), make_value(xs[3 * i + 1]), make_value(xs[3 * i + 2])});
+        preds.insert(preds.end(), out.begin(), out.end());
+    }
+    for (double y : ys) {
+        targets.push_back(make_value(y));
+    }
+
+    tf.start_test("Predict Paths Agree With The Graph");
+    double predicted[4], snapshot[4];
+    mlp.predict(xs.data(), predicted, 2);
+    InferenceMLP<double>(mlp).predict(xs.data(), snapshot, 2);
+    auto batched = mlp(make_tensor(2, 3, xs));
+    bool agree = true;
+    for (std::size_t i = 0; i < 4; ++i) {
+        agree = agree && std::abs(preds[i]->data() - predicted[i]) < 1e-12 && snapshot[i] == predicted[i] &&
+                std::abs(batched->data()[i] - predicted[i]) < 1e-12;
+    }
+    tf.assert_true(agree, "Scalar, batched, predict() and InferenceMLP outputs should match");
+
+    tf.start_test("Batched Gradients Match The Scalar Path");
+    mlp.zero_grad();
+    squared_error(preds, targets)->backward();
+    std::vector<double> scalar_grads;
+    for (const auto& p : mlp.parameters()) {
+        scalar_grads.push_back(p->grad());
+    }
+    mlp.zero_grad();
+    mlp.forward_batch(xs.data(), ys.data(), 2).loss->backward();
+    bool grads_ok = true;
+    for (std::size_t i = 0; i < scalar_grads.size(); ++i) {
+        grads_ok = grads_ok && std::abs(scalar_grads[i] - mlp.parameters()[i]->grad()) < 1e-12;
+    }
+    tf.assert_true(grads_ok, "Both paths should reach the same parameter gradients");
+
+    tf.start_test("Checkpointing Skips Non-Tanh Groups");
+    mlp.set_checkpoint_interval(2);
+    auto grouped = mlp(make_tensor(2, 3, xs));
+    mlp.set_checkpoint_interval(0);
+    tf.assert_true(std::equal(grouped->data(), grouped->data() + 4, batched->data()),
+                   "Groups of non-tanh layers should run unchanged");
+
+    tf.start_test("Model Files Keep Activations");
+    const std::string path = "test_nn_activations.mgrd";
+    save_model(mlp, path);
+    MLP loaded = load_model(path);
+    double reloaded[4], mapped[4];
+    loaded.predict(xs.data(), reloaded, 2);
+    MappedModel(path).predict(xs.data(), mapped, 2);
+    tf.assert_true(loaded.activations() == acts && std::equal(predicted, predicted + 4, reloaded) &&
+                       std::equal(predicted, predicted + 4, mapped),
+                   "Loaded and mapped models should predict identically");
+
+    tf.start_test("Version 1 Files Load As Tanh");
+    MLP old(2, {3, 1});
+    save_model(old, path);
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    bytes[4] = 1; // An all-tanh file differs from version 1 only in its padding
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+    MLP upgraded = load_model(path);
+    tf.assert_true(upgraded.activations() == std::vector<Activation>(2, Activation::Tanh) &&
+                       upgraded.parameters()[0]->data() == old.parameters()[0]->data(),
+                   "A version 1 file should still load");
+    std::remove(path.c_str());
+
+    tf.start_test("Mismatched Activations Throw");
+    bool threw_mlp = false, threw_snapshot = false;
+    try {
+        MLP bad(3, {4, 1}, {Activation::Relu});
+    } catch (const std::invalid_argument&) {
+        threw_mlp = true;
+    }
+    InferenceMLP<float> snap(MLP(3, {2}, {Activation::Relu}));
+    try {
+        snap.load(MLP(3, {2}));
+    } catch (const std::invalid_argument&) {
+        threw_snapshot = true;
+    }
+    tf.assert_true(threw_mlp && threw_snapshot, "Activation lists and snapshots should be checked");
+}
+
+// =============================================================================
+// COMPILED GRAPH TESTS
+// =============================================================================
+void test_compiled_suite(TestFramework& tf) {
+    std::cout << "\n--- Compiled Training Graph Tests ---" << std::endl;
+
+    MLP mlp(3, {4, 4, 1});
+    const std::vector<double> xs = {1.0, -0.5, 2.0, 0.3, 0.1, -1.2, -2.0, 0.7, 0.4};
+    const std::vector<double> ys = {1.0, -1.0, 0.5};
+
+    // Trace one forward plus loss over placeholder inputs
+    std::vector<ValuePtr> inputs = {make_value(0.0), make_value(0.0), make_value(0.0), make_value(0.0)};
+    auto pred = mlp({inputs[0], inputs[1], inputs[2]})[0];
+    CompiledGraph step(pow(pred - inputs[3], 2.0), inputs);
+    pred.reset();
+
+    bool match = true;
+    for (std::size_t i = 0; i < 3; ++i) {
+        mlp.zero_grad();
+        auto loss = pow(mlp({make_value(xs[i * 3]), make_value(xs[i * 3 + 1]), make_value(xs[i * 3 + 2])})[0] - ys[i],
+                        2.0);
+        loss->backward();
+        std::vector<double> ref;
+        for (const auto& p : mlp.parameters()) {
+            ref.push_back(p->grad());
+        }
+
+        mlp.zero_grad();
+        const double sample[4] = {xs[i * 3], xs[i * 3 + 1], xs[i * 3 + 2], ys[i]};
+        step.set_inputs(sample);
+        match = match && std::abs(step.forward() - loss->data()) < 1e-12;
+        step.backward();
+        for (std::size_t k = 0; k < ref.size(); ++k) {
+            match = match && std::abs(mlp.parameters()[k]->grad() - ref[k]) < 1e-12;
+        }
+    }
+    tf.start_test("Compiled MLP Step Matches Dynamic Graph");
+    tf.assert_true(match, "Replaying the traced step should give the rebuilt graph's loss and gradients");
+
+    // The traced neuron chains collapse into one DotTanh per neuron
+    std::vector<ValuePtr> inputs2 = {make_value(0.0), make_value(0.0), make_value(0.0), make_value(0.0)};
+    CompiledGraph fused(pow(mlp({inputs2[0], inputs2[1], inputs2[2]})[0] - inputs2[3], 2.0), inputs2);
+    OptimizeStats stats = fused.optimize();
+    bool fused_match = true;
+    for (std::size_t i = 0; i < 3; ++i) {
+        const double sample[4] = {xs[i * 3], xs[i * 3 + 1], xs[i * 3 + 2], ys[i]};
+        mlp.zero_grad();
+        step.set_inputs(sample);
+        const double expected = step.forward();
+        step.backward();
+        std::vector<double> ref;
+        for (const auto& p : mlp.parameters()) {
+            ref.push_back(p->grad());
+        }
+        mlp.zero_grad();
+        fused.set_inputs(sample);
+        fused_match = fused_match && std::abs(fused.forward() - expected) < 1e-12;
+        fused.backward();
+        for (std::size_t k = 0; k < ref.size(); ++k) {
+            fused_match = fused_match && std::abs(mlp.parameters()[k]->grad() - ref[k]) < 1e-12;
+        }
+    }
+    tf.start_test("Optimized MLP Step Is Several Times Smaller");
+    tf.assert_true(stats.instructions_after * 4 < stats.instructions_before, "Fusion should shrink the schedule");
+    tf.start_test("Optimized MLP Step Matches Unoptimized");
+    tf.assert_true(fused_match, "Fused replay should give the same loss and gradients");
+
+    tf.start_test("Compiled Replay Does Not Allocate");
+    long allocations_before = g_allocations.load();
+    for (int i = 0; i < 10; ++i) {
+        step.set_inputs(xs.data());
+        step.forward();
+        step.backward();
+    }
+    bool quiet = g_allocations.load() == allocations_before;
+    tf.assert_true(quiet, "forward() and backward() should only touch preallocated slots");
+}
 
 // =============================================================================
 // MAIN TEST RUNNER
@@ -199,8 +1504,22 @@ int main() {
     TestFramework tf;
 
     test_neuron_suite(tf);
+    test_init_suite(tf);
     test_layer_suite(tf);
     test_mlp_suite(tf);
+    test_batch_suite(tf);
+    test_checkpoint_suite(tf);
+    test_threading_suite(tf);
+    test_trainer_suite(tf);
+    test_optimizer_suite(tf);
+    test_inference_suite(tf);
+    test_precision_suite(tf);
+    test_quantization_suite(tf);
+    test_serialization_suite(tf);
+    test_dataset_suite(tf);
+    test_profile_suite(tf);
+    test_activation_suite(tf);
+    test_compiled_suite(tf);
 
-    return 0; // The TestFramework destructor will print the summary
+    return tf.failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE; // The TestFramework destructor will print the summary
 }
@@ -0,0 +1,460 @@
+/**
+ * @file test_tensor.cpp
+ * @brief Unit tests for the Tensor class, checked against the scalar Value engine
+ */
+
+#include "micrograd/kernels.hpp"
+#include "micrograd/tensor.hpp"
+#include "micrograd/value.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ======== TESTING FRAMEWORK ========
+// Re-using the simple testing framework from test_nn.cpp
+
+class TestFramework {
+private:
+    int tests_run = 0;
+    int tests_passed = 0;
+    int tests_failed = 0;
+    std::string current_test_name;
+
+public:
+    ~TestFramework() {
+        std::cout << "\n----------------------------------------\n";
+        std::cout << "Test Summary: " << tests_passed << " / " << tests_run << " passed." << std::endl;
+        std::cout << "----------------------------------------\n";
+    }
+
+    void start_test(const std::string& name) {
+        current_test_name = name;
+        std::cout << "Running: " << name << " ... ";
+        tests_run++;
+    }
+
+    void pass() {
+        std::cout << "✓ PASS" << std::endl;
+        tests_passed++;
+    }
+
+    void fail(const std::string& message = "") {
+        std::cout << "✗ FAIL";
+        if (!message.empty()) {
+            std::cout << " - " << message;
+        }
+        std::cout << std::endl;
+        tests_failed++;
+    }
+
+    void assert_true(bool condition, const std::string& message = "") {
+        if (condition) {
+            pass();
+        } else {
+            fail(message);
+        }
+    }
+
+    void assert_equal(double expected, double actual, double tolerance = 1e-9) {
+        bool equal = std::abs(expected - actual) < tolerance;
+        if (equal) {
+            pass();
+        } else {
+            fail("Expected: " + std::to_string(expected) + ", Got: " + std::to_string(actual));
+        }
+    }
+
+    int failures() const {
+        return tests_failed;
+    }
+};
+
+// Builds a deterministic pseudo-random buffer so tests are reproducible
+std::vector<double> test_data(std::size_t n, double seed) {
+    std::vector<double> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = std::sin(seed + 1.7 * static_cast<double>(i));
+    }
+    return out;
+}
+
+// =============================================================================
+// FORWARD TESTS
+// =============================================================================
+void test_forward_suite(TestFramework& tf) {
+    std::cout << "--- Tensor Forward Tests ---" << std::endl;
+
+    tf.start_test("Tensor Construction");
+    auto t = make_tensor(2, 3, 1.5);
+    tf.assert_true(t->rows() == 2 && t->cols() == 3 && t->at(1, 2) == 1.5 && t->grad_at(1, 2) == 0.0,
+                   "Leaf should have the requested shape, fill and zero gradient");
+
+    tf.start_test("MatMul Forward");
+    auto a = make_tensor(2, 2, {1.0, 2.0, 3.0, 4.0});
+    auto b = make_tensor(2, 2, {5.0, 6.0, 7.0, 8.0});
+    auto c = matmul(a, b);
+    tf.assert_true(c->at(0, 0) == 19.0 && c->at(0, 1) == 22.0 && c->at(1, 0) == 43.0 && c->at(1, 1) == 50.0,
+                   "[[1,2],[3,4]] . [[5,6],[7,8]] = [[19,22],[43,50]]");
+
+    tf.start_test("MatMul Transposed Forward");
+    auto bt = make_tensor(2, 2, {5.0, 7.0, 6.0, 8.0}); // b^T
+    auto ct = matmul_transposed(a, bt);
+    tf.assert_true(ct->at(0, 0) == 19.0 && ct->at(1, 1) == 50.0, "a . (b^T)^T should equal a . b");
+
+    tf.start_test("Add Bias Forward");
+    auto bias = make_tensor(1, 2, {10.0, 20.0});
+    auto biased = add_bias(a, bias);
+    tf.assert_true(biased->at(0, 0) == 11.0 && biased->at(1, 1) == 24.0, "Bias should broadcast over rows");
+
+    tf.start_test("Sum Forward");
+    tf.assert_equal(10.0, sum(a)->at(0, 0));
+
+    tf.start_test("Shape Mismatch Throws");
+    bool threw = false;
+    try {
+        matmul(make_tensor(2, 3), make_tensor(2, 3));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "Incompatible shapes should be rejected");
+}
+
+// =============================================================================
+// BACKWARD TESTS
+// =============================================================================
+void test_backward_suite(TestFramework& tf) {
+    std::cout << "\n--- Tensor Backward Tests ---" << std::endl;
+
+    // A dense tanh layer with a squared loss, built once with tensors ...
+    const std::size_t batch = 3, nin = 4, nout = 2;
+    auto xs = test_data(batch * nin, 0.3);
+    auto ws = test_data(nout * nin, 1.1);
+    auto bs = test_data(nout, 2.9);
+
+    auto X = make_tensor(batch, nin, xs);
+    auto W = make_tensor(nout, nin, ws);
+    auto B = make_tensor(1, nout, bs);
+    auto loss = sum(pow(tanh(add_bias(matmul_transposed(X, W), B)), 2.0));
+    loss->backward();
+
+    // ... and once with the scalar reference engine
+    std::vector<ValuePtr> x, w, b;
+    for (double v : xs) x.push_back(make_value(v));
+    for (double v : ws) w.push_back(make_value(v));
+    for (double v : bs) b.push_back(make_value(v));
+    ValuePtr ref = make_value(0.0);
+    for (std::size_t i = 0; i < batch; ++i) {
+        for (std::size_t j = 0; j < nout; ++j) {
+            ValuePtr act = b[j];
+            for (std::size_t p = 0; p < nin; ++p) {
+                act = act + x[i * nin + p] * w[j * nin + p];
+            }
+            ref = ref + pow(tanh(act), 2.0);
+        }
+    }
+    ref->backward();
+
+    tf.start_test("Dense Layer Loss Matches Scalar Engine");
+    tf.assert_equal(ref->data(), loss->at(0, 0), 1e-12);
+
+    tf.start_test("Weight Gradients Match Scalar Engine");
+    bool w_ok = true;
+    for (std::size_t i = 0; i < w.size(); ++i) {
+        w_ok = w_ok && std::abs(w[i]->grad() - W->grad()[i]) < 1e-12;
+    }
+    tf.assert_true(w_ok, "dL/dW should agree elementwise");
+
+    tf.start_test("Input and Bias Gradients Match Scalar Engine");
+    bool xb_ok = true;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        xb_ok = xb_ok && std::abs(x[i]->grad() - X->grad()[i]) < 1e-12;
+    }
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        xb_ok = xb_ok && std::abs(b[i]->grad() - B->grad()[i]) < 1e-12;
+    }
+    tf.assert_true(xb_ok, "dL/dX and dL/db should agree elementwise");
+
+    tf.start_test("MatMul Backward");
+    auto a = make_tensor(2, 3, test_data(6, 0.5));
+    auto m = make_tensor(3, 2, test_data(6, 1.5));
+    sum(matmul(a, m))->backward();
+    // d sum(A.M) / dA[i][p] = sum_j M[p][j]
+    tf.assert_equal(m->at(1, 0) + m->at(1, 1), a->grad_at(0, 1), 1e-12);
+
+    tf.start_test("Elementwise Backward");
+    auto u = make_tensor(1, 2, {0.5, -1.0});
+    auto v = make_tensor(1, 2, {2.0, 3.0});
+    sum(exp(u) * v - u)->backward();
+    // d/du = exp(u) * v - 1,  d/dv = exp(u)
+    tf.assert_true(std::abs(u->grad()[0] - (std::exp(0.5) * 2.0 - 1.0)) < 1e-12 &&
+                   std::abs(v->grad()[1] - std::exp(-1.0)) < 1e-12,
+                   "Elementwise chain rule should match the closed form");
+}
+
+// =============================================================================
+// ACTIVATION AND LOSS TESTS
+// =============================================================================
+void test_loss_suite(TestFramework& tf) {
+    std::cout << "\n--- Activation and Fused Loss Tests ---" << std::endl;
+
+    // Every tensor op below is checked against the same computation on Values
+    const std::size_t m = 3, k = 4;
+    const auto zs = test_data(m * k, 0.8), ts = test_data(m * k, 2.2);
+    const std::vector<std::size_t> classes = {1, 3, 0};
+    auto leaves = [](const std::vector<double>& data) {
+        std::vector<ValuePtr> out;
+        for (double v : data) out.push_back(make_value(v));
+        return out;
+    };
+    auto row = [&](const std::vector<ValuePtr>& all, std::size_t i) {
+        return std::vector<ValuePtr>(all.begin() + static_cast<std::ptrdiff_t>(i * k),
+                                     all.begin() + static_cast<std::ptrdiff_t>((i + 1) * k));
+    };
+    auto grads_match = [](const std::vector<ValuePtr>& ref, const TensorPtr& t) {
+        bool ok = true;
+        for (std::size_t i = 0; i < ref.size(); ++i) {
+            ok = ok && std::abs(ref[i]->grad() - t->grad()[i]) < 1e-12;
+        }
+        return ok;
+    };
+
+    tf.start_test("Activations Match Scalar Engine");
+    bool act_ok = true;
+    for (Activation act : {Activation::Relu, Activation::Sigmoid, Activation::Gelu}) {
+        auto Z = make_tensor(m, k, zs);
+        auto loss = sum(activate(Z, act));
+        loss->backward();
+        auto z = leaves(zs);
+        ValuePtr ref = make_value(0.0);
+        for (const auto& v : z) ref = ref + activate(v, act);
+        ref->backward();
+        act_ok = act_ok && Z->prev().empty() && loss->prev()[0]->op() == TensorOp::Activate &&
+                 std::abs(ref->data() - loss->at(0, 0)) < 1e-12 && grads_match(z, Z);
+    }
+    tf.assert_true(act_ok, "Activate nodes should agree with the scalar ops");
+
+    tf.start_test("Log-Sum-Exp Matches Scalar Engine");
+    auto Z = make_tensor(m, k, zs);
+    auto lse = logsumexp(Z);
+    sum(lse)->backward();
+    auto z = leaves(zs);
+    ValuePtr ref = make_value(0.0);
+    for (std::size_t i = 0; i < m; ++i) ref = ref + logsumexp(row(z, i));
+    ref->backward();
+    tf.assert_true(lse->rows() == m && lse->cols() == 1 && grads_match(z, Z), "Row-wise lse and its gradient");
+
+    tf.start_test("Softmax Cross-Entropy Matches Scalar Engine");
+    Z = make_tensor(m, k, zs);
+    auto xent = softmax_cross_entropy(Z, classes);
+    xent->backward();
+    z = leaves(zs);
+    ref = make_value(0.0);
+    for (std::size_t i = 0; i < m; ++i) ref = ref + softmax_cross_entropy(row(z, i), classes[i]);
+    ref = ref / static_cast<double>(m);
+    ref->backward();
+    tf.assert_true(std::abs(ref->data() - xent->at(0, 0)) < 1e-12 && grads_match(z, Z),
+                   "Mean cross-entropy and its gradient");
+
+    tf.start_test("Squared Error Matches The Unfused Graph");
+    auto P = make_tensor(m, k, zs), T = make_tensor(m, k, ts);
+    auto P2 = make_tensor(m, k, zs), T2 = make_tensor(m, k, ts);
+    auto fused = squared_error(P, T);
+    auto unfused = sum(pow(P2 - T2, 2.0));
+    fused->backward();
+    unfused->backward();
+    bool same = fused->at(0, 0) == unfused->at(0, 0);
+    for (std::size_t i = 0; i < m * k; ++i) {
+        same = same && P->grad()[i] == P2->grad()[i] && T->grad()[i] == T2->grad()[i];
+    }
+    tf.assert_true(same, "The fused node should be bitwise identical to sum(pow(p - t, 2))");
+
+    tf.start_test("Mse Is The Mean Squared Error");
+    tf.assert_equal(fused->at(0, 0) / static_cast<double>(m * k), mse(P, T)->at(0, 0), 1e-15);
+
+    tf.start_test("Bad Classes Throw");
+    bool threw = false;
+    try {
+        softmax_cross_entropy(Z, {1, 4, 0});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "A class index past the last column should throw");
+}
+
+// =============================================================================
+// KERNEL TESTS
+// =============================================================================
+void test_kernel_suite(TestFramework& tf) {
+    std::cout << "\n--- SIMD Kernel Tests ---" << std::endl;
+
+    const kernels::Isa original = kernels::active_isa();
+    std::cout << "Detected ISA: " << kernels::isa_name(original) << std::endl;
+
+    for (kernels::Isa isa : {kernels::Isa::Scalar, kernels::Isa::Neon, kernels::Isa::Avx2, kernels::Isa::Avx512}) {
+        if (!kernels::isa_supported(isa)) {
+            continue;
+        }
+        kernels::select_isa(isa);
+        const std::string name = kernels::isa_name(isa);
+
+        // Every length up to a few vector widths, to exercise all tail paths
+        bool dot_ok = true, axpy_ok = true;
+        for (std::size_t n = 0; n <= 37; ++n) {
+            auto a = test_data(n, 0.1);
+            auto b = test_data(n, 2.3);
+            double expected = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                expected += a[i] * b[i];
+            }
+            dot_ok = dot_ok && std::abs(kernels::dot(a.data(), b.data(), n) - expected) < 1e-12;
+
+            auto y = b;
+            kernels::axpy(0.5, a.data(), y.data(), n);
+            for (std::size_t i = 0; i < n; ++i) {
+                axpy_ok = axpy_ok && std::abs(y[i] - (b[i] + 0.5 * a[i])) < 1e-15;
+            }
+        }
+        // Optimizer kernels against a plain loop written from the update formulas
+        bool momentum_ok = true, adam_ok = true;
+        for (std::size_t n : {1, 3, 4, 7, 8, 13, 33}) {
+            auto p = test_data(n, 0.3), g = test_data(n, 1.1), v = test_data(n, 2.9);
+            auto p_ref = p, v_ref = v;
+            kernels::momentum_update(p.data(), g.data(), v.data(), 0.1, 0.9, n);
+            for (std::size_t i = 0; i < n; ++i) {
+                v_ref[i] = 0.9 * v_ref[i] + g[i];
+                p_ref[i] -= 0.1 * v_ref[i];
+                momentum_ok = momentum_ok && std::abs(p[i] - p_ref[i]) < 1e-14 && std::abs(v[i] - v_ref[i]) < 1e-14;
+            }
+
+            auto m = test_data(n, 3.7), s2 = test_data(n, 4.1);
+            for (auto& e : s2) {
+                e = e * e; // Second moments are non-negative
+            }
+            auto q = test_data(n, 0.9), q_ref = q, m_ref = m, s2_ref = s2;
+            kernels::adam_update(q.data(), g.data(), m.data(), s2.data(), 0.9, 0.999, 0.01, 2.0, 1e-8, n);
+            for (std::size_t i = 0; i < n; ++i) {
+                m_ref[i] = 0.9 * m_ref[i] + 0.1 * g[i];
+                s2_ref[i] = 0.999 * s2_ref[i] + 0.001 * g[i] * g[i];
+                q_ref[i] -= 0.01 * m_ref[i] / (std::sqrt(s2_ref[i] * 2.0) + 1e-8);
+                adam_ok = adam_ok && std::abs(q[i] - q_ref[i]) < 1e-12 && std::abs(m[i] - m_ref[i]) < 1e-14 &&
+                          std::abs(s2[i] - s2_ref[i]) < 1e-14;
+            }
+        }
+        tf.start_test("Momentum Update (" + name + ")");
+        tf.assert_true(momentum_ok, "Velocity and parameters should follow the momentum rule");
+        tf.start_test("Adam Update (" + name + ")");
+        tf.assert_true(adam_ok, "Moments and parameters should follow the Adam rule");
+
+        tf.start_test("Dot Product (" + name + ")");
+        tf.assert_true(dot_ok, "Dot products should match the reference sum");
+
+        // Reduced-precision dots against a double reference of the same rounded inputs
+        bool f32_ok = true, bf16_ok = true;
+        for (std::size_t n = 0; n <= 70; ++n) {
+            auto a = test_data(n, 0.4), b = test_data(n, 1.7);
+            std::vector<float> af(a.begin(), a.end()), bf(b.begin(), b.end());
+            std::vector<bfloat16> ah(n);
+            double expected = 0.0, expected_h = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                ah[i] = bfloat16(af[i]);
+                expected += static_cast<double>(af[i]) * bf[i];
+                expected_h += static_cast<double>(static_cast<float>(ah[i])) * bf[i];
+            }
+            f32_ok = f32_ok && std::abs(kernels::dot(af.data(), bf.data(), n) - expected) < 1e-4;
+            bf16_ok = bf16_ok && std::abs(kernels::dot(ah.data(), bf.data(), n) - expected_h) < 1e-4;
+        }
+        tf.start_test("Float Dot Product (" + name + ")");
+        tf.assert_true(f32_ok, "float dot products should match the reference sum");
+        tf.start_test("bfloat16 Dot Product (" + name + ")");
+        tf.assert_true(bf16_ok, "bfloat16 x float dot products should match the reference sum");
+        bool i8_ok = true;
+        for (std::size_t n = 0; n <= 200; ++n) {
+            std::vector<std::int8_t> a(n), b(n);
+            std::int32_t expected = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                // Covers both extremes, including -128
+                a[i] = static_cast<std::int8_t>(static_cast<int>((i * 37 + n) % 256) - 128);
+                b[i] = static_cast<std::int8_t>(static_cast<int>((i * 101 + 7) % 256) - 128);
+                expected += a[i] * b[i];
+            }
+            i8_ok = i8_ok && kernels::dot(a.data(), b.data(), n) == expected;
+        }
+        // The longest supported length, at the extremes where partial sums peak
+        const std::size_t longest = (std::size_t(1) << 17) - 1;
+        for (int v : {-128, 127}) {
+            std::vector<std::int8_t> a(longest, static_cast<std::int8_t>(v));
+            const auto expected = static_cast<std::int64_t>(v) * v * static_cast<std::int64_t>(longest);
+            i8_ok = i8_ok && kernels::dot(a.data(), a.data(), longest) == expected;
+        }
+        tf.start_test("Int8 Dot Product (" + name + ")");
+        tf.assert_true(i8_ok, "int8 dot products should be exact");
+        tf.start_test("Axpy (" + name + ")");
+        tf.assert_true(axpy_ok, "y += alpha * x should match elementwise");
+
+        // The fused layer must agree with the unfused tensor expression
+        auto X = make_tensor(3, 19, test_data(57, 0.7));
+        auto W = make_tensor(5, 19, test_data(95, 1.9));
+        auto B = make_tensor(1, 5, test_data(5, 4.2));
+        auto X2 = make_tensor(3, 19, test_data(57, 0.7));
+        auto W2 = make_tensor(5, 19, test_data(95, 1.9));
+        auto B2 = make_tensor(1, 5, test_data(5, 4.2));
+        auto fused = dense_tanh(X, W, B);
+        auto unfused = tanh(add_bias(matmul_transposed(X2, W2), B2));
+        sum(pow(fused, 2.0))->backward();
+        sum(pow(unfused, 2.0))->backward();
+        bool fused_ok = true;
+        for (std::size_t i = 0; i < fused->size(); ++i) {
+            fused_ok = fused_ok && std::abs(fused->data()[i] - unfused->data()[i]) < 1e-12;
+        }
+        for (std::size_t i = 0; i < W->size(); ++i) {
+            fused_ok = fused_ok && std::abs(W->grad()[i] - W2->grad()[i]) < 1e-12;
+        }
+        for (std::size_t i = 0; i < X->size(); ++i) {
+            fused_ok = fused_ok && std::abs(X->grad()[i] - X2->grad()[i]) < 1e-12;
+        }
+        for (std::size_t i = 0; i < B->size(); ++i) {
+            fused_ok = fused_ok && std::abs(B->grad()[i] - B2->grad()[i]) < 1e-12;
+        }
+        tf.start_test("Fused Dense Tanh (" + name + ")");
+        tf.assert_true(fused_ok, "Fused forward and gradients should match the unfused ops");
+    }
+
+    tf.start_test("Unsupported ISA Is Rejected");
+    bool threw = false;
+    for (kernels::Isa isa : {kernels::Isa::Neon, kernels::Isa::Avx2, kernels::Isa::Avx512}) {
+        if (!kernels::isa_supported(isa)) {
+            try {
+                kernels::select_isa(isa);
+            } catch (const std::invalid_argument&) {
+                threw = true;
+            }
+        } else {
+            threw = true; // Nothing to reject for this ISA on this machine
+        }
+    }
+    tf.assert_true(threw, "Selecting an unsupported ISA should throw");
+
+    kernels::select_isa(original);
+}
+
+// =============================================================================
+// MAIN TEST RUNNER
+// =============================================================================
+int main() {
+    std::cout << "Tensor Unit Tests" << std::endl;
+    std::cout << "=================" << std::endl << std::endl;
+
+    TestFramework tf;
+
+    test_forward_suite(tf);
+    test_backward_suite(tf);
+    test_loss_suite(tf);
+    test_kernel_suite(tf);
+
+    return tf.failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE; // The TestFramework destructor will print the summary
+}
@@ -5,13 +5,20 @@
  */
 
 #include "micrograd/value.hpp"  // Our Value class header
+#include "micrograd/tape.hpp"
+#include "micrograd/compiled_graph.hpp"
+#include "micrograd/derivatives.hpp"
 #include <iostream>
 #include <memory>
+#include <new>
 #include <vector>
 #include <string>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <functional>
 #include <sstream>
+#include <stdexcept>
 
 // ======== TESTING FRAMEWORK ========
 
@@ -22,6 +29,7 @@ class TestFramework {
 private:
     int tests_run = 0;
     int tests_passed = 0;
+    int tests_failed = 0;
     std::string current_test_name;
 
 public:
@@ -36,6 +44,7 @@ public:
             std::cout << "✓ PASS" << std::endl;
             tests_passed++;
         } else {
+            tests_failed++;
             std::cout << "✗ FAIL";
             if (!message.empty()) {
                 std::cout << " - " << message;
@@ -50,6 +59,7 @@ public:
             std::cout << "✓ PASS" << std::endl;
             tests_passed++;
         } else {
+            tests_failed++;
             std::cout << "✗ FAIL - Expected: " << expected
                       << ", Got: " << actual << std::endl;
         }
@@ -60,10 +70,15 @@ public:
             std::cout << "✓ PASS" << std::endl;
             tests_passed++;
         } else {
+            tests_failed++;
             std::cout << "✗ FAIL - Expected: \"" << expected
                       << "\", Got: \"" << actual << "\"" << std::endl;
         }
     }
+
+    int failures() const {
+        return tests_failed;
+    }
 };
 
 // =============================================================================
@@ -102,6 +117,30 @@ void test_value_getters_setters(TestFramework& tf) {
     tf.assert_equal(std::string("test_value"), v.label());
 }
 
+void test_bound_storage(TestFramework& tf) {
+    double data[2] = {1.0, 2.0};
+    double grad[2] = {0.0, 0.0};
+
+    tf.start_test("Bound Value - Reads External Data");
+    auto w = std::make_shared<Value>(&data[1], &grad[1], "w");
+    tf.assert_true(w->is_bound() && w->data() == 2.0, "A bound Value should read its external slot");
+
+    tf.start_test("Bound Value - Writes External Slots");
+    w->set_data(3.0);
+    auto y = w * make_value(4.0);
+    y->backward();
+    tf.assert_true(data[1] == 3.0 && grad[1] == 4.0, "Data and gradient should land in the external buffers");
+
+    tf.start_test("Bound Value - Copies Alias The Same Slots");
+    Value copy = *w;
+    copy.set_grad(7.0);
+    Value plain(5.0);
+    Value plain_copy = plain;
+    plain_copy.set_data(6.0);
+    tf.assert_true(grad[1] == 7.0 && !plain_copy.is_bound() && plain.data() == 5.0,
+                   "Bound copies share storage, unbound copies own theirs");
+}
+
 void test_gradient_operations(TestFramework& tf) {
     tf.start_test("Gradient Accumulation");
     Value v(1.0);
@@ -180,6 +219,23 @@ void test_memory_management(TestFramework& tf) {
     tf.assert_equal(1, outer_ptr.use_count());
     tf.assert_equal(123.0, outer_ptr->data());
 
+    tf.start_test("Memory Management - Graph Released With Root");
+    auto leaf = make_value(2.0, "leaf");
+    long live_before = Value::live_count();
+    {
+        auto root = tanh(leaf * leaf + 1.0);
+        root->backward();
+        tf.assert_true(Value::live_count() > live_before, "Graph nodes should be alive while the root is");
+    }
+    tf.start_test("Memory Management - Graph Freed After Scope");
+    tf.assert_true(Value::live_count() == live_before && leaf.use_count() == 1,
+                   "Dropping the root should free every intermediate node");
+
+    tf.start_test("Memory Management - Static Graph Released At Exit");
+    // Destroyed after main() returns, when this thread's thread_locals are already gone
+    static ValuePtr survivor = tanh(make_value(0.5) * make_value(2.0) + 1.0);
+    tf.assert_true(survivor->prev().size() == 1, "A static root should keep its graph until exit");
+
     tf.start_test("Memory Management - Reset Test");
     auto ptr = make_value(456.0);
     tf.assert_true(ptr != nullptr, "Pointer should not be null");
@@ -187,6 +243,37 @@ void test_memory_management(TestFramework& tf) {
     tf.assert_true(ptr == nullptr, "Pointer should be null after reset");
 }
 
+void test_node_layout(TestFramework& tf) {
+    tf.start_test("Node Layout - Fits Two Cache Lines");
+    // make_shared puts the node next to a control block of a vtable pointer and two counts
+    tf.assert_true(sizeof(Value) + 16 <= 128, "A node and its control block should fit in 128 bytes");
+
+    tf.start_test("Node Layout - Labels Follow Copies And Moves");
+    Value original(1.0, "w");
+    Value copy(original);
+    Value moved(std::move(copy));
+    Value assigned(0.0);
+    assigned = moved;
+    tf.assert_equal(std::string("w"), original.label());
+    tf.assert_equal(std::string("w"), moved.label());
+    tf.assert_equal(std::string("w"), assigned.label());
+    tf.assert_equal(std::string(""), copy.label());
+    assigned = Value(2.0);
+    tf.assert_equal(std::string(""), assigned.label());
+
+    tf.start_test("Node Layout - Labels Die With Their Node");
+    alignas(Value) unsigned char buffer[sizeof(Value)];
+    Value* first = new (buffer) Value(1.0, "stale");
+    first->~Value();
+    // A new node at the same address must not inherit the old label
+    Value* second = new (buffer) Value(2.0);
+    tf.assert_equal(std::string(""), second->label());
+    second->set_label("fresh");
+    second->set_label("");
+    tf.assert_equal(std::string(""), second->label());
+    second->~Value();
+}
+
 void test_string_representation(TestFramework& tf) {
     tf.start_test("String Representation - No Label");
     Value v(2.5);
@@ -276,6 +363,93 @@ void test_mathematical_operations(TestFramework& tf) {
     tf.assert_equal(4.0, m->grad());
 }
 
+void test_activations_and_losses(TestFramework& tf) {
+    // Central differences of f around the leaves' current values
+    auto numeric_grad = [](const std::vector<ValuePtr>& leaves, std::size_t i, const std::function<double()>& f) {
+        const double h = 1e-6, x = leaves[i]->data();
+        leaves[i]->set_data(x + h);
+        const double up = f();
+        leaves[i]->set_data(x - h);
+        const double down = f();
+        leaves[i]->set_data(x);
+        return (up - down) / (2 * h);
+    };
+
+    tf.start_test("ReLU, Sigmoid And GELU");
+    auto p = make_value(0.7), q = make_value(-0.7);
+    auto out = relu(p) + relu(q) + sigmoid(p) + gelu(q);
+    out->backward();
+    const double s = 1 / (1 + std::exp(-0.7));
+    const double phi = 0.5 * std::erfc(0.7 / std::sqrt(2.0)), pdf = std::exp(-0.245) / std::sqrt(2 * 3.14159265358979323846);
+    tf.assert_true(std::abs(out->data() - (0.7 + s - 0.7 * phi)) < 1e-12 &&
+                       std::abs(p->grad() - (1 + s * (1 - s))) < 1e-12 &&
+                       std::abs(q->grad() - (phi - 0.7 * pdf)) < 1e-12,
+                   "Values and gradients should match the closed forms");
+
+    tf.start_test("Linear Activation Adds No Node");
+    tf.assert_true(activate(p, Activation::Linear) == p && activate(p, Activation::Tanh)->op() == Op::Tanh);
+
+    tf.start_test("Extreme Inputs Stay Finite");
+    auto big = make_value(-800.0);
+    auto lse = logsumexp({make_value(1000.0), make_value(1000.0)});
+    tf.assert_true(sigmoid(big)->data() == 0.0 && std::abs(lse->data() - (1000.0 + std::log(2.0))) < 1e-9,
+                   "sigmoid and logsumexp should not overflow");
+
+    tf.start_test("Fused Losses Are One Node");
+    std::vector<ValuePtr> z = {make_value(0.3), make_value(-1.2), make_value(2.0)};
+    std::vector<ValuePtr> t = {make_value(0.5), make_value(0.0), make_value(1.0)};
+    auto xent = softmax_cross_entropy(z, 2);
+    auto err = mse(z, t);
+    tf.assert_true(xent->prev().size() == 3 && err->prev().size() == 6 && err->op() == Op::SquaredError);
+
+    tf.start_test("Fused Loss Gradients Match Finite Differences");
+    bool ok = true;
+    const std::vector<std::function<ValuePtr()>> losses = {
+        [&] { return logsumexp(z); },
+        [&] { return softmax_cross_entropy(z, 2); },
+        [&] { return mse(z, t); },
+        [&] { return mse(z, std::vector<double>{0.5, 0.0, 1.0}); },
+    };
+    for (const auto& loss : losses) {
+        std::vector<ValuePtr> leaves(z);
+        leaves.insert(leaves.end(), t.begin(), t.end());
+        for (auto& v : leaves) {
+            v->zero_grad();
+        }
+        loss()->backward();
+        for (std::size_t i = 0; i < leaves.size(); ++i) {
+            const double expected = numeric_grad(leaves, i, [&] { return loss()->data(); });
+            ok = ok && std::abs(leaves[i]->grad() - expected) < 1e-6;
+        }
+    }
+    tf.assert_true(ok, "Closed-form backward should match a numeric gradient");
+
+    tf.start_test("Fused Mse Matches The Expanded Graph");
+    auto expanded = (pow(z[0] - t[0], 2.0) + pow(z[1] - t[1], 2.0) + pow(z[2] - t[2], 2.0)) / 3.0;
+    tf.assert_equal(expanded->data(), mse(z, t)->data(), 1e-15);
+
+    tf.start_test("Bad Loss Arguments Throw");
+    bool threw = false;
+    try {
+        softmax_cross_entropy(z, 3);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "An out-of-range class should throw");
+
+    tf.start_test("Compiled Activations Match The Graph");
+    auto x = make_value(0.4);
+    auto root = gelu(x) * sigmoid(x) + relu(x * -2.0 + 1.5);
+    CompiledGraph compiled(root, {x});
+    compiled.optimize();
+    compiled.set_input(0, 0.4);
+    const double value = compiled.forward();
+    compiled.backward();
+    x->zero_grad();
+    root->backward();
+    tf.assert_true(std::abs(value - root->data()) < 1e-15 && std::abs(compiled.input_grad(0) - x->grad()) < 1e-15);
+}
+
 void test_neuron_backprop(TestFramework& tf) {
     tf.start_test("Neuron Backprop");
 
@@ -314,6 +488,449 @@ void test_neuron_backprop(TestFramework& tf) {
     tf.assert_equal(0.0, w2->grad(), 1e-9);  // grad(x2w2) * x2->data()
 }
 
+void test_graph_structure(TestFramework& tf) {
+    tf.start_test("Graph Structure - Leaf Has No Parents");
+    auto x = make_value(3.0, "x");
+    tf.assert_true(x->prev().empty(), "A leaf should have no parents");
+
+    tf.start_test("Graph Structure - Operand Order Preserved");
+    auto y = make_value(4.0, "y");
+    auto xy = x * y;
+    tf.assert_true(xy->prev().size() == 2 && xy->prev()[0] == x && xy->prev()[1] == y,
+                   "Parents should be stored in operand order");
+
+    tf.start_test("Graph Structure - Opcodes");
+    auto p = pow(xy, 2.0);
+    tf.assert_true(x->op() == Op::None && xy->op() == Op::Mul && p->op() == Op::Pow &&
+                   std::string(op_name(p->op())) == "pow" && std::string(op_name(Op::Add)) == "+",
+                   "Nodes should record the opcode that produced them");
+
+    tf.start_test("Graph Structure - Duplicate Parents Kept");
+    auto sq = x * x;
+    tf.assert_true(sq->prev().size() == 2 && sq->prev()[0] == sq->prev()[1],
+                   "x * x should record x twice");
+
+    tf.start_test("Graph Structure - Square Backward");
+    sq->backward();
+    tf.assert_equal(6.0, x->grad()); // d(x^2)/dx = 2x
+
+    tf.start_test("Graph Structure - Spilled Parents");
+    std::vector<ValuePtr> many{make_value(1.0), make_value(2.0), make_value(3.0)};
+    ChildList spilled(many);
+    ChildList copied = spilled;
+    tf.assert_true(copied.size() == 3 && copied[2] == many[2] && spilled[0] == many[0],
+                   "N-ary parent lists should spill and copy deeply");
+}
+
+void test_topological_order(TestFramework& tf) {
+    tf.start_test("Topo Order - Deep Chain Does Not Overflow");
+    // A long chain like the one Neuron::operator() builds for a very wide input
+    auto x = make_value(1.0, "x");
+    auto acc = make_value(0.0, "acc");
+    const int depth = 200000;
+    for (int i = 0; i < depth; ++i) {
+        acc = acc + x;
+    }
+    acc->backward();
+    tf.assert_equal(static_cast<double>(depth), x->grad());
+
+    tf.start_test("Topo Order - Children Precede Parents");
+    auto a = make_value(2.0, "a");
+    auto b = make_value(3.0, "b");
+    auto c = a * b;
+    auto d = c + a;
+    std::vector<Value*> order;
+    d->build_topo(order);
+    tf.assert_true(order.size() == 4 && order.back() == d.get() && order[0] != d.get(),
+                   "Each node should appear once, with the root last");
+
+    tf.start_test("Topo Order - Cached Order Reuse");
+    d->backward(order);
+    double first = a->grad();
+    a->zero_grad(); b->zero_grad(); c->zero_grad();
+    a->set_data(5.0); // Same shape, different data
+    d->backward(order);
+    // dd/da = b + 1, independent of a's data
+    tf.assert_true(first == 4.0 && a->grad() == 4.0, "Reusing the order should give the same gradients");
+
+    tf.start_test("Topo Order - Rejects Foreign Order");
+    bool threw = false;
+    try {
+        c->backward(order);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "An order built from another root should be rejected");
+}
+
+void test_tape(TestFramework& tf) {
+    // Parameters live on the heap, outside of any tape
+    auto w = make_value(-3.0, "w");
+    auto b = make_value(1.0, "b");
+
+    Tape tape(4); // Small blocks so the graph spans several of them
+    ValuePtr out;
+    {
+        TapeScope scope(tape);
+        auto x = make_value(2.0, "x");
+        out = tanh(x * w + b);
+    }
+
+    tf.start_test("Tape - Nodes Recorded");
+    // x, x*w, x*w+b, tanh
+    tf.assert_true(tape.size() == 4, "Only the forward-pass nodes should be recorded");
+
+    tf.start_test("Tape - Recorded Nodes Are Not Refcounted");
+    tf.assert_true(out.use_count() == 0, "Tape nodes should be non-owning");
+
+    tf.start_test("Tape - Index Addressing");
+    tf.assert_equal(2.0, tape[0].data());
+
+    tf.start_test("Tape - Forward Pass");
+    tf.assert_equal(std::tanh(-5.0), out->data());
+
+    tf.start_test("Tape - Reverse Sweep Backward");
+    tape.backward(out);
+    double dtanh = 1.0 - std::tanh(-5.0) * std::tanh(-5.0);
+    tf.assert_equal(2.0 * dtanh, w->grad());
+    tf.start_test("Tape - Reverse Sweep Bias Gradient");
+    tf.assert_equal(dtanh, b->grad());
+
+    tf.start_test("Tape - Matches Value::backward");
+    double w_grad = w->grad();
+    w->zero_grad();
+    b->zero_grad();
+    for (std::size_t i = 0; i < tape.size(); ++i) {
+        tape[i].zero_grad();
+    }
+    out->backward();
+    tf.assert_equal(w_grad, w->grad());
+
+    tf.start_test("Tape - Clear Releases Nodes");
+    tape.clear();
+    tf.assert_true(tape.size() == 0 && w.use_count() == 1,
+                   "Clearing should destroy nodes and drop their parameter references");
+
+    tf.start_test("Tape - Scope Restores Heap Allocation");
+    auto heap = make_value(1.0);
+    tf.assert_true(heap.use_count() == 1 && Tape::active() == nullptr,
+                   "Values created after the scope should be refcounted");
+
+    tf.start_test("Tape - Second Root Ignores Earlier Graph");
+    auto p = make_value(1.0);
+    ValuePtr l1, l2;
+    {
+        TapeScope scope(tape);
+        l1 = p * p;
+    }
+    tape.backward(l1);
+    p->zero_grad();
+    {
+        TapeScope scope(tape);
+        l2 = p * 3.0;
+    }
+    tape.backward(l2);
+    tf.assert_equal(3.0, p->grad());
+    tape.clear();
+}
+
+void test_compiled_graph(TestFramework& tf) {
+    auto w = make_value(0.7, "w");
+    auto b = make_value(-0.2, "b");
+    auto x = make_value(0.0, "x");
+    auto t = make_value(0.0, "t");
+
+    // Exercises every opcode, a constant leaf and a node used twice
+    auto build = [&]() {
+        auto h = tanh(x * w + b);
+        return pow(h - t, 2.0) + exp(h) * h + 3.0;
+    };
+
+    CompiledGraph graph(build(), {x, t});
+
+    tf.start_test("Compiled Graph - Schedule");
+    tf.assert_true(graph.num_inputs() == 2 && !graph.instructions().empty() &&
+                       graph.num_slots() > graph.instructions().size(),
+                   "Every non-leaf node should become one instruction");
+
+    bool forward_ok = true, grads_ok = true;
+    for (int step = 0; step < 3; ++step) {
+        const double xv = 0.5 * step - 0.3, tv = 0.1 * step;
+
+        // Reference: rebuild the dynamic graph
+        x->set_data(xv);
+        t->set_data(tv);
+        w->zero_grad();
+        b->zero_grad();
+        x->zero_grad();
+        auto loss = build();
+        loss->backward();
+        const double w_ref = w->grad(), b_ref = b->grad(), x_ref = x->grad();
+
+        // Replay: only the inputs change
+        w->zero_grad();
+        b->zero_grad();
+        const double inputs[2] = {xv, tv};
+        graph.set_inputs(inputs);
+        forward_ok = forward_ok && std::abs(graph.forward() - loss->data()) < 1e-12;
+        graph.backward();
+        grads_ok = grads_ok && std::abs(w->grad() - w_ref) < 1e-12 && std::abs(b->grad() - b_ref) < 1e-12 &&
+                   std::abs(graph.input_grad(0) - x_ref) < 1e-12;
+
+        // Parameter updates are visible to the next replay
+        w->set_data(w->data() - 0.1 * w->grad());
+    }
+
+    tf.start_test("Compiled Graph - Forward Replay");
+    tf.assert_true(forward_ok, "Replayed forward should equal a freshly built graph");
+    tf.start_test("Compiled Graph - Backward Replay");
+    tf.assert_true(grads_ok, "Replayed gradients should reach the original leaves");
+
+    // The same graph after folding, fusion and dead-node elimination
+    CompiledGraph plain(build(), {x, t});
+    CompiledGraph optimized(build(), {x, t});
+    OptimizeStats stats = optimized.optimize();
+    tf.start_test("Optimized Graph - Fewer Instructions And Slots");
+    tf.assert_true(stats.instructions_after < stats.instructions_before && stats.slots_after < stats.slots_before &&
+                       stats.instructions_after == optimized.instructions().size(),
+                   "Literals should fold and tanh(x * w + b) should fuse");
+
+    bool optimized_ok = true;
+    for (int step = 0; step < 3; ++step) {
+        const double inputs[2] = {0.4 * step - 0.5, 0.2 * step};
+        w->zero_grad();
+        b->zero_grad();
+        plain.set_inputs(inputs);
+        const double expected = plain.forward();
+        plain.backward();
+        const double w_ref = w->grad(), b_ref = b->grad(), x_ref = plain.input_grad(0);
+
+        w->zero_grad();
+        b->zero_grad();
+        optimized.set_inputs(inputs);
+        optimized_ok = optimized_ok && std::abs(optimized.forward() - expected) < 1e-12;
+        optimized.backward();
+        optimized_ok = optimized_ok && std::abs(w->grad() - w_ref) < 1e-12 && std::abs(b->grad() - b_ref) < 1e-12 &&
+                       std::abs(optimized.input_grad(0) - x_ref) < 1e-12;
+    }
+    tf.start_test("Optimized Graph - Same Values And Gradients");
+    tf.assert_true(optimized_ok, "Passes should not change what the graph computes");
+
+    tf.start_test("Optimized Graph - Folds Constant Subgraphs");
+    // x / 4.0 is x * pow(4.0, -1): the pow folds and the multiply takes an immediate
+    CompiledGraph folded(x / 4.0, {x});
+    folded.optimize();
+    folded.set_input(0, 1.5);
+    tf.assert_true(folded.instructions().size() == 1 && folded.instructions()[0].op == InstrOp::MulConst &&
+                       std::abs(folded.forward() - 0.375) < 1e-12,
+                   "A subgraph of literals should collapse into one immediate");
+
+    tf.start_test("Optimized Graph - Keeps Inputs Set Before optimize()");
+    CompiledGraph early(x / 4.0 + 1.0, {x});
+    early.set_input(0, 2.0);
+    early.optimize();
+    tf.assert_equal(1.5, early.forward());
+
+    tf.start_test("Optimized Graph - Second optimize() Keeps The Result");
+    auto x0 = make_value(0.5), x1 = make_value(-1.0), x2 = make_value(2.0);
+    auto w0 = make_value(0.3), w1 = make_value(-0.2), w2 = make_value(0.4), b0 = make_value(0.1);
+    auto neuron = [&] { return tanh(b0 + w0 * x0 + w1 * x1 + w2 * x2); };
+    CompiledGraph unfused(neuron(), {x0, x1, x2});
+    CompiledGraph twice(neuron(), {x0, x1, x2});
+    const double neuron_inputs[3] = {0.5, -1.0, 2.0};
+    unfused.set_inputs(neuron_inputs);
+    twice.set_inputs(neuron_inputs);
+    twice.optimize();
+    const std::size_t fused_size = twice.instructions().size();
+    twice.optimize();
+    tf.assert_true(twice.instructions().size() == fused_size && std::abs(twice.forward() - unfused.forward()) < 1e-12,
+                   "Re-optimizing a fused graph should change neither its code nor its value");
+
+    tf.start_test("Compiled Graph - Rejects Non-Leaf Inputs");
+    bool threw = false;
+    try {
+        auto y = x * w;
+        CompiledGraph bad(y + 1.0, {y});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "An interior node cannot be rebound");
+}
+
+void test_requires_grad(TestFramework& tf) {
+    tf.start_test("Requires Grad - Literals And Derived Nodes");
+    auto w = make_value(0.5);
+    auto x = make_value(2.0);
+    x->set_requires_grad(false);
+    auto scaled = 3.0 * x;
+    auto y = tanh(scaled * w + 1.0);
+    tf.assert_true(w->requires_grad() && !scaled->requires_grad() && !scaled->prev()[0]->requires_grad() &&
+                       y->requires_grad(),
+                   "Only nodes reaching a differentiable leaf should require a gradient");
+
+    tf.start_test("Requires Grad - Backward Skips Constant Subgraphs");
+    std::vector<Value*> full, pruned;
+    y->build_topo(full);
+    y->build_topo(pruned, true);
+    y->backward();
+    const double expected = (1 - y->data() * y->data()) * scaled->data();
+    tf.assert_true(full.size() == 8 && pruned.size() == 4 && std::abs(w->grad() - expected) < 1e-12 &&
+                       x->grad() == 0.0 && scaled->grad() == 0.0,
+                   "Frozen inputs and their subgraph should get no topo entry and no gradient");
+
+    tf.start_test("Requires Grad - Frozen Parameter Keeps Its Gradient");
+    auto frozen = make_value(1.5);
+    frozen->set_grad(7.0);
+    frozen->set_requires_grad(false);
+    auto loss = pow(frozen * w - 1.0, 2.0);
+    w->zero_grad();
+    loss->backward();
+    const double w_grad = w->grad();
+    tf.assert_true(frozen->grad() == 7.0 && std::abs(w_grad - 2 * (1.5 * 0.5 - 1.0) * 1.5) < 1e-12);
+
+    tf.start_test("Requires Grad - Tape And Compiled Graph Agree");
+    Tape tape;
+    ValuePtr taped;
+    {
+        TapeScope scope(tape);
+        taped = pow(frozen * w - 1.0, 2.0);
+    }
+    w->zero_grad();
+    tape.backward(taped);
+    const double tape_grad = w->grad();
+    CompiledGraph compiled(loss, {});
+    w->zero_grad();
+    compiled.forward();
+    compiled.backward();
+    tf.assert_true(tape_grad == w_grad && w->grad() == w_grad && frozen->grad() == 7.0,
+                   "Every engine should skip the frozen leaf");
+    taped.reset();
+    tape.clear();
+
+    tf.start_test("Requires Grad - Only Leaves Can Be Marked");
+    bool threw = false;
+    try {
+        y->set_requires_grad(false);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    tf.assert_true(threw, "An op node's flag follows its parents");
+}
+
+void test_derivatives(TestFramework& tf) {
+    std::vector<ValuePtr> x = {make_value(0.4), make_value(-0.9), make_value(1.3)};
+    // Two outputs exercising every op, with shared subexpressions
+    auto build = [&x] {
+        auto shared = x[0] * x[1];
+        auto y0 = logsumexp({shared, tanh(x[2]), gelu(x[0])}) + pow(x[1], 3.0) * exp(x[2]);
+        auto y1 = softmax_cross_entropy({x[0], shared, x[2]}, 1) + relu(x[0]) * sigmoid(x[1]) +
+                  squared_error({x[2]}, {x[1]}, 0.5);
+        return std::vector<ValuePtr>{y0, y1};
+    };
+    // Reference Jacobian row i from backward()
+    auto gradient = [&](std::size_t i) {
+        for (auto& v : x) {
+            v->zero_grad();
+        }
+        build()[i]->backward();
+        return std::vector<double>{x[0]->grad(), x[1]->grad(), x[2]->grad()};
+    };
+    auto ys = build();
+    Differentiator diff(ys, x);
+
+    tf.start_test("Jacobian Matches Backward");
+    const auto J = diff.jacobian();
+    bool ok = J.size() == 6;
+    for (std::size_t i = 0; i < 2 && ok; ++i) {
+        const auto g = gradient(i);
+        for (std::size_t j = 0; j < 3; ++j) {
+            ok = ok && std::abs(J[i * 3 + j] - g[j]) < 1e-12;
+        }
+    }
+    tf.assert_true(ok, "Every derivative should equal the reverse-mode gradient");
+
+    tf.start_test("Batched JVP Equals J v");
+    const std::vector<double> v = {1.0, 0.0, 0.0, 0.5, -2.0, 0.25};
+    std::vector<double> jv(4);
+    diff.jvp(v.data(), jv.data(), 2);
+    ok = true;
+    for (std::size_t d = 0; d < 2; ++d) {
+        for (std::size_t i = 0; i < 2; ++i) {
+            const double expected = J[i * 3] * v[d * 3] + J[i * 3 + 1] * v[d * 3 + 1] + J[i * 3 + 2] * v[d * 3 + 2];
+            ok = ok && std::abs(jv[d * 2 + i] - expected) < 1e-12;
+        }
+    }
+    tf.assert_true(ok, "Each direction should give its own product");
+
+    tf.start_test("Batched VJP Equals u^T J");
+    const std::vector<double> u = {1.0, 1.0, -0.5, 2.0};
+    std::vector<double> uj(6);
+    diff.vjp(u.data(), uj.data(), 2);
+    ok = true;
+    for (std::size_t d = 0; d < 2; ++d) {
+        for (std::size_t j = 0; j < 3; ++j) {
+            ok = ok && std::abs(uj[d * 3 + j] - (u[d * 2] * J[j] + u[d * 2 + 1] * J[3 + j])) < 1e-12;
+        }
+    }
+    tf.assert_true(ok, "Each direction should give its own product");
+
+    tf.start_test("HVP Matches Finite Differences Of The Gradient");
+    // H v ~ (g(x + h v) - g(x - h v)) / 2h
+    std::vector<double> hv(6);
+    diff.hvp(v.data(), hv.data(), 2);
+    ok = true;
+    const double h = 1e-5;
+    for (std::size_t d = 0; d < 2; ++d) {
+        std::vector<double> base = {x[0]->data(), x[1]->data(), x[2]->data()};
+        for (std::size_t j = 0; j < 3; ++j) {
+            x[j]->set_data(base[j] + h * v[d * 3 + j]);
+        }
+        const auto up = gradient(0);
+        for (std::size_t j = 0; j < 3; ++j) {
+            x[j]->set_data(base[j] - h * v[d * 3 + j]);
+        }
+        const auto down = gradient(0);
+        for (std::size_t j = 0; j < 3; ++j) {
+            x[j]->set_data(base[j]);
+            ok = ok && std::abs(hv[d * 3 + j] - (up[j] - down[j]) / (2 * h)) < 1e-6;
+        }
+    }
+    tf.assert_true(ok, "Forward-over-reverse should match differenced gradients");
+
+    tf.start_test("Queries Leave The Graph Untouched");
+    for (auto& leaf : x) {
+        leaf->zero_grad();
+    }
+    diff.vjp(u.data(), uj.data(), 2);
+    diff.hvp(v.data(), hv.data(), 2);
+    tf.assert_true(x[0]->grad() == 0.0 && x[1]->grad() == 0.0 && x[2]->grad() == 0.0);
+
+    tf.start_test("Unreached Input Has Zero Derivative");
+    auto stray = make_value(5.0);
+    Differentiator partial({ys[0]}, {stray, x[1]});
+    const auto row = partial.jacobian();
+    tf.assert_true(row.size() == 2 && row[0] == 0.0 && std::abs(row[1] - J[1]) < 1e-12);
+
+    tf.start_test("Bad Differentiator Arguments Throw");
+    int threw = 0;
+    try {
+        Differentiator bad(ys, {x[0], x[0]});
+    } catch (const std::invalid_argument&) {
+        ++threw;
+    }
+    try {
+        Differentiator bad(ys, {ys[0]});
+    } catch (const std::invalid_argument&) {
+        ++threw;
+    }
+    try {
+        Differentiator bad({}, x);
+    } catch (const std::invalid_argument&) {
+        ++threw;
+    }
+    tf.assert_true(threw == 3, "Repeated, interior and missing arguments should be rejected");
+}
+
 // =============================================================================
 // MAIN TEST RUNNER
 // =============================================================================
@@ -331,6 +948,9 @@ int main() {
     std::cout << "\n--- Getter/Setter Tests ---" << std::endl;
     test_value_getters_setters(tf);
 
+    std::cout << "\n--- Bound Storage Tests ---" << std::endl;
+    test_bound_storage(tf);
+
     std::cout << "\n--- Gradient Operation Tests ---" << std::endl;
     test_gradient_operations(tf);
 
@@ -343,6 +963,9 @@ int main() {
     std::cout << "\n--- Memory Management Tests ---" << std::endl;
     test_memory_management(tf);
 
+    std::cout << "\n--- Node Layout Tests ---" << std::endl;
+    test_node_layout(tf);
+
     std::cout << "\n--- String Representation Tests ---" << std::endl;
     test_string_representation(tf);
 
@@ -352,8 +975,29 @@ int main() {
     std::cout << "\n--- Mathematical Operation & Backprop Tests ---" << std::endl;
     test_mathematical_operations(tf);
 
+    std::cout << "\n--- Activation & Fused Loss Tests ---" << std::endl;
+    test_activations_and_losses(tf);
+
     std::cout << "\n--- Full Neuron Backprop Test ---" << std::endl;
     test_neuron_backprop(tf);
 
-    return 0;
+    std::cout << "\n--- Graph Structure Tests ---" << std::endl;
+    test_graph_structure(tf);
+
+    std::cout << "\n--- Topological Order Tests ---" << std::endl;
+    test_topological_order(tf);
+
+    std::cout << "\n--- Tape Tests ---" << std::endl;
+    test_tape(tf);
+
+    std::cout << "\n--- Compiled Graph Tests ---" << std::endl;
+    test_compiled_graph(tf);
+
+    std::cout << "\n--- Requires Grad Tests ---" << std::endl;
+    test_requires_grad(tf);
+
+    std::cout << "\n--- Derivative Query Tests ---" << std::endl;
+    test_derivatives(tf);
+
+    return tf.failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }